@@ -0,0 +1,91 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * advert_gen - writes a synthetic advertisement stream, one JSON object per
+ * line, usable as the corpus of match_profile or trace_format:
+ *
+ *   advert_gen [--count N] [--devices N] [--known share] [--zipf s]
+ *              [--rate per_s] [--seed N] [--timestamps] [--report]
+ *
+ * --timestamps adds the arrival time of every advertisement as "time_us",
+ * --report lists the models the generator cannot synthesize instead.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "advert_generator.h"
+
+int main(int argc, char** argv) {
+  StreamConfig config;
+  size_t count = 10000;
+  bool timestamps = false;
+  bool report = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--count" && i + 1 < argc) {
+      count = std::stoul(argv[++i]);
+    } else if (arg == "--devices" && i + 1 < argc) {
+      config.devices = std::stoul(argv[++i]);
+    } else if (arg == "--known" && i + 1 < argc) {
+      config.known_share = std::stod(argv[++i]);
+    } else if (arg == "--zipf" && i + 1 < argc) {
+      config.zipf_s = std::stod(argv[++i]);
+    } else if (arg == "--rate" && i + 1 < argc) {
+      config.rate = std::stod(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      config.seed = std::stoul(argv[++i]);
+    } else if (arg == "--timestamps") {
+      timestamps = true;
+    } else if (arg == "--report") {
+      report = true;
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--count N] [--devices N] [--known share] [--zipf s]"
+                << " [--rate per_s] [--seed N] [--timestamps] [--report]" << std::endl;
+      return 1;
+    }
+  }
+
+  AdvertGenerator generator(config.seed);
+  generator.probeModels();
+  if (report) {
+    TheengsDecoder decoder;
+    std::cout << generator.models().size() << " of " << TheengsDecoder::BLE_ID_MAX
+              << " models synthesized, failed:" << std::endl;
+    for (int model : generator.failedModels()) {
+      std::cout << model << " " << decoder.getTheengAttribute(model, "model_id") << std::endl;
+    }
+    return 0;
+  }
+
+  AdvertStream stream(generator, config);
+  std::cerr << config.devices << " devices, " << stream.knownDevices() << " of known models" << std::endl;
+  for (size_t i = 0; i < count; ++i) {
+    const SyntheticAdvert& advert = stream.next();
+    std::string json = advert.json();
+    if (timestamps) {
+      json.insert(json.size() - 1, ",\"time_us\":" + std::to_string(advert.time_us));
+    }
+    std::cout << json << "\n";
+  }
+  return 0;
+}
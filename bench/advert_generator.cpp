@@ -0,0 +1,490 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "advert_generator.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+enum Field {
+  FIELD_SVC,
+  FIELD_MFG,
+  FIELD_NAME,
+  FIELD_UUID,
+  FIELD_NO_MFG,
+  FIELD_COUNT
+};
+
+enum Kind {
+  KIND_NONE,
+  KIND_INDEX,
+  KIND_CONTAIN,
+  KIND_MAC,
+  KIND_REVMAC
+};
+
+static bool isOperator(const JsonVariant& element) {
+  if (!element.is<const char*>()) {
+    return false;
+  }
+  const char* str = element.as<const char*>();
+  return strcmp(str, "&") == 0 || strcmp(str, "|") == 0;
+}
+
+static int fieldOf(const char* str) {
+  if (strcmp(str, "servicedata") == 0) return FIELD_SVC;
+  if (strcmp(str, "manufacturerdata") == 0) return FIELD_MFG;
+  if (strcmp(str, "name") == 0) return FIELD_NAME;
+  if (strcmp(str, "uuid") == 0) return FIELD_UUID;
+  if (strcmp(str, "no-mfgdata") == 0) return FIELD_NO_MFG;
+  return -1;
+}
+
+std::string SyntheticAdvert::json() const {
+  StaticJsonDocument<512> doc;
+  const char* keys[] = {"id", "name", "servicedatauuid", "servicedata", "manufacturerdata"};
+  const std::string* values[] = {&id, &name, &uuid, &svc, &mfg};
+  for (int i = 0; i < 5; ++i) {
+    if (!values[i]->empty()) {
+      doc[keys[i]] = values[i]->c_str();
+    }
+  }
+  std::string text;
+  serializeJson(doc, text);
+  return text;
+}
+
+/*
+ * @brief Decodes the advertisement as a gateway would, from a JSON object
+ * holding its fields, and returns the model index or -1.
+ */
+int SyntheticAdvert::decode(TheengsDecoder& decoder, JsonDocument& doc) const {
+  doc.clear();
+  JsonObject object = doc.to<JsonObject>();
+  if (!id.empty()) object["id"] = id.c_str();
+  if (!name.empty()) object["name"] = name.c_str();
+  if (!uuid.empty()) object["servicedatauuid"] = uuid.c_str();
+  if (!svc.empty()) object["servicedata"] = svc.c_str();
+  if (!mfg.empty()) object["manufacturerdata"] = mfg.c_str();
+  return decoder.decodeBLEJson(object);
+}
+
+AdvertGenerator::AdvertGenerator(uint32_t seed)
+    : m_doc(2048), m_condition(4096), m_properties(m_decoder.getDocMax()), m_rng(seed) {}
+
+std::string AdvertGenerator::randomHex(size_t chars) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex(chars, '0');
+  for (size_t i = 0; i < chars; ++i) {
+    hex[i] = digits[m_rng() & 0x0f];
+  }
+  return hex;
+}
+
+std::string AdvertGenerator::randomMac() {
+  static const char digits[] = "0123456789ABCDEF";
+  std::string mac;
+  for (int i = 0; i < 6; ++i) {
+    uint32_t byte = m_rng();
+    mac += (i ? ":" : "");
+    mac += digits[(byte >> 4) & 0x0f];
+    mac += digits[byte & 0x0f];
+  }
+  return mac;
+}
+
+/*
+ * @brief Appends to clauses the fields of one way of satisfying condition:
+ * one term of every run of "|" between the "&", nested arrays being
+ * conditions of their own.
+ */
+void AdvertGenerator::pickClauses(const JsonArray& condition, std::vector<Clause>& clauses) {
+  size_t size = condition.size();
+  std::vector<std::vector<size_t> > groups(1);
+  for (size_t i = 0; i < size;) {
+    groups.back().push_back(i);
+    ++i;
+    while (i < size && !condition[i - 1].is<JsonArray>() && !isOperator(condition[i])) {
+      ++i;
+    }
+    if (i < size && strcmp(condition[i].as<const char*>(), "&") == 0) {
+      groups.push_back(std::vector<size_t>());
+    }
+    ++i;
+  }
+
+  for (const std::vector<size_t>& group : groups) {
+    if (group.empty()) {
+      continue;
+    }
+    size_t i = group[m_rng() % group.size()];
+    if (condition[i].is<JsonArray>()) {
+      pickClauses(condition[i], clauses);
+      continue;
+    }
+
+    Clause clause = {fieldOf(condition[i].as<const char*>()), "", 0, KIND_NONE, 0, "", false};
+    if (clause.field < 0) {
+      continue;
+    }
+    ++i;
+    if (i + 1 < size && condition[i + 1].is<size_t>() && !isOperator(condition[i]) &&
+        strlen(condition[i].as<const char*>()) <= 2) {
+      clause.op = condition[i].as<const char*>();
+      clause.length = condition[i + 1].as<size_t>();
+      i += 2;
+    }
+    if (i < size && !isOperator(condition[i])) {
+      const char* kind = condition[i].as<const char*>();
+      if (strcmp(kind, "contain") == 0) {
+        clause.kind = KIND_CONTAIN;
+        clause.value = condition[i + 1].as<const char*>();
+      } else if (strstr(kind, "mac@index") != nullptr) {
+        clause.kind = strcmp(kind, "revmac@index") == 0 ? KIND_REVMAC : KIND_MAC;
+        clause.index = condition[i + 1].as<size_t>();
+      } else if (strcmp(kind, "index") == 0) {
+        clause.kind = KIND_INDEX;
+        clause.index = condition[i + 1].as<size_t>();
+        clause.negate = strcmp(condition[i + 2].as<const char*>(), "!") == 0;
+        clause.value = condition[i + 2 + clause.negate].as<const char*>();
+      }
+    }
+    clauses.push_back(clause);
+  }
+}
+
+/*
+ * @brief Reads from the properties of model the data length their decoders
+ * need and the values their conditions look for, which random bytes would
+ * seldom hold.
+ */
+void AdvertGenerator::loadProperties(int model) {
+  m_needs[FIELD_SVC] = m_needs[FIELD_MFG] = 0;
+  m_hints.clear();
+  m_properties.clear();
+  if (deserializeJson(m_properties, m_decoder.getTheengAttribute(model, "properties"))) {
+    return;
+  }
+  for (JsonPair kv : m_properties.as<JsonObject>()) {
+    JsonArray decoder = kv.value()["decoder"];
+    int field = decoder[1].is<const char*>() ? fieldOf(decoder[1].as<const char*>()) : -1;
+    if ((field == FIELD_SVC || field == FIELD_MFG) && decoder[2].is<int>()) {
+      size_t need = decoder[2].as<size_t>() + (decoder[3].is<int>() ? decoder[3].as<size_t>() : 12);
+      m_needs[field] = std::max(m_needs[field], need);
+    }
+
+    JsonArray condition = kv.value()["condition"];
+    std::vector<Clause> hints;
+    for (size_t i = 0; i + 2 < condition.size(); ++i) {
+      field = condition[i].is<const char*>() ? fieldOf(condition[i].as<const char*>()) : -1;
+      if ((field == FIELD_SVC || field == FIELD_MFG) && condition[i + 1].is<int>() &&
+          condition[i + 2].is<const char*>() && strcmp(condition[i + 2].as<const char*>(), "!") != 0 &&
+          strcmp(condition[i + 2].as<const char*>(), "bit") != 0) {
+        Clause hint = {field, "", 0, KIND_INDEX, condition[i + 1].as<size_t>(), condition[i + 2].as<const char*>(), false};
+        hints.push_back(hint);
+      }
+    }
+    if (!hints.empty()) {
+      m_hints.push_back(hints);
+    }
+  }
+}
+
+/*
+ * @brief Fills data with random hex of a length within the bounds of the
+ * clauses on field, long enough for the property decoders if possible, then
+ * writes the hints and over them the values and MAC of the clauses.
+ */
+bool AdvertGenerator::buildData(int field, const std::vector<Clause>& clauses, const std::vector<Clause>& hints,
+                                const std::string& mac, std::string& data) {
+  size_t min_len = 0;
+  size_t max_len = static_cast<size_t>(-1);
+  size_t exact = 0;
+  for (const Clause& c : clauses) {
+    if (c.field != field) {
+      continue;
+    }
+    if (c.op.empty()) {
+      min_len = std::max<size_t>(min_len, field == FIELD_SVC ? 20 : 16); // decoder defaults
+    } else if (c.op == "=") {
+      if (exact != 0 && exact != c.length) {
+        return false;
+      }
+      exact = c.length;
+    } else if (c.op == ">=") {
+      min_len = std::max(min_len, c.length);
+    } else if (c.op == ">") {
+      min_len = std::max(min_len, c.length + 1);
+    } else if (c.op == "<=") {
+      max_len = std::min(max_len, c.length);
+    } else if (c.op == "<") {
+      if (c.length == 0) {
+        return false;
+      }
+      max_len = std::min(max_len, c.length - 1);
+    }
+    if (c.kind == KIND_INDEX) {
+      min_len = std::max(min_len, c.index + c.value.size());
+    } else if (c.kind == KIND_MAC || c.kind == KIND_REVMAC) {
+      min_len = std::max(min_len, c.index + 12);
+    }
+  }
+
+  size_t len;
+  if (exact != 0) {
+    if (exact < min_len || exact > max_len) {
+      return false;
+    }
+    len = exact;
+  } else {
+    min_len = std::max(min_len, std::min(m_needs[field], max_len));
+    min_len += min_len & 1; // whole bytes
+    if (min_len > max_len) {
+      return false;
+    }
+    len = std::min(max_len, min_len + 2 * (m_rng() % 5));
+    len -= len & 1 && len > min_len;
+  }
+
+  data = randomHex(len);
+  std::string bare_mac;
+  for (char ch : mac) {
+    if (ch != ':') {
+      bare_mac += static_cast<char>(tolower(ch));
+    }
+  }
+  for (const Clause& c : hints) {
+    if (c.field == field && c.index + c.value.size() <= len) {
+      data.replace(c.index, c.value.size(), c.value);
+    }
+  }
+  for (const Clause& c : clauses) {
+    if (c.field != field || c.negate) {
+      continue;
+    }
+    if (c.kind == KIND_INDEX) {
+      data.replace(c.index, c.value.size(), c.value);
+    } else if (c.kind == KIND_MAC) {
+      data.replace(c.index, 12, bare_mac);
+    } else if (c.kind == KIND_REVMAC && bare_mac.size() == 12) {
+      for (size_t b = 0; b < 6; ++b) {
+        data.replace(c.index + 2 * b, 2, bare_mac, 10 - 2 * b, 2);
+      }
+    } else if (c.kind == KIND_CONTAIN) {
+      data.replace(m_rng() % (len - c.value.size() + 1), c.value.size(), c.value);
+    }
+  }
+  for (const Clause& c : clauses) {
+    if (c.field == field && c.negate && data.compare(c.index, c.value.size(), c.value) == 0) {
+      data[c.index] = data[c.index] == '0' ? '1' : '0';
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Sets the fields of out from clauses, returns false if they
+ * contradict each other.
+ */
+bool AdvertGenerator::build(const std::vector<Clause>& clauses, const std::string& mac, SyntheticAdvert& out) {
+  bool used[FIELD_COUNT] = {};
+  for (const Clause& c : clauses) {
+    used[c.field] = true;
+  }
+  if (used[FIELD_NO_MFG] && used[FIELD_MFG]) {
+    return false;
+  }
+
+  // the conditions of every property hold or not, at random
+  std::vector<Clause> hints;
+  for (const std::vector<Clause>& property : m_hints) {
+    if (m_rng() & 1) {
+      hints.insert(hints.end(), property.begin(), property.end());
+    }
+  }
+
+  out.id = mac;
+  out.svc.clear();
+  out.mfg.clear();
+  bool svc = used[FIELD_SVC] || m_needs[FIELD_SVC] > 0;
+  bool mfg = used[FIELD_MFG] || (m_needs[FIELD_MFG] > 0 && !used[FIELD_NO_MFG]);
+  if ((svc && !buildData(FIELD_SVC, clauses, hints, mac, out.svc)) ||
+      (mfg && !buildData(FIELD_MFG, clauses, hints, mac, out.mfg))) {
+    return false;
+  }
+  if (!svc && !mfg && !used[FIELD_NAME]) {
+    out.svc = randomHex(2 * (1 + m_rng() % 8)); // the decoder needs some data, a uuid comes with service data
+  }
+
+  // the name and uuid hold their index values over random characters
+  static const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+  for (int field = FIELD_NAME; field <= FIELD_UUID; ++field) {
+    std::string& text = field == FIELD_NAME ? out.name : out.uuid;
+    text.clear();
+    if (!used[field]) {
+      continue;
+    }
+    size_t len = field == FIELD_UUID ? 4 : 0;
+    for (const Clause& c : clauses) {
+      if (c.field == field) {
+        len = std::max(len, c.index + c.value.size());
+      }
+    }
+    text = field == FIELD_UUID ? randomHex(len) : std::string(len, ' ');
+    if (field == FIELD_NAME) {
+      for (char& ch : text) {
+        ch = letters[m_rng() % (sizeof(letters) - 1)];
+      }
+    }
+    for (const Clause& c : clauses) {
+      if (c.field != field) {
+        continue;
+      }
+      if (c.kind == KIND_CONTAIN) {
+        text.replace(m_rng() % (len - c.value.size() + 1), c.value.size(), c.value);
+      } else if (c.kind == KIND_INDEX && !c.negate) {
+        text.replace(c.index, c.value.size(), c.value);
+      }
+    }
+    if (field == FIELD_UUID) {
+      text = "0x" + text;
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Synthesizes in out an advertisement of the device mac decoding to
+ * model, trying up to attempts combinations of the alternatives of its
+ * condition and random bytes. Returns false if none decoded to model: the
+ * conditions of an earlier model may catch all of them, or the properties of
+ * the model need more than random bytes.
+ */
+bool AdvertGenerator::synthesize(int model, const std::string& mac, SyntheticAdvert& out, int attempts) {
+  if (model < 0 || model >= TheengsDecoder::BLE_ID_MAX) {
+    return false;
+  }
+  if (model != m_model) {
+    m_model = -1;
+    m_condition.clear();
+    if (deserializeJson(m_condition, m_decoder.getTheengAttribute(model, "condition")) ||
+        !m_condition.is<JsonArray>()) {
+      return false;
+    }
+    loadProperties(model);
+    m_model = model;
+  }
+  JsonArray condition = m_condition.as<JsonArray>();
+  std::vector<Clause> clauses;
+  for (int attempt = 0; attempt < attempts; ++attempt) {
+    clauses.clear();
+    pickClauses(condition, clauses);
+    if (build(clauses, mac, out) && out.decode(m_decoder, m_doc) == model) {
+      out.model = model;
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief Random traffic of the device mac that no model decodes: unknown
+ * manufacturer data, service data or iBeacons.
+ */
+void AdvertGenerator::unknown(const std::string& mac, SyntheticAdvert& out) {
+  do {
+    out.id = mac;
+    out.name.clear();
+    out.uuid.clear();
+    out.svc.clear();
+    out.mfg.clear();
+    switch (m_rng() % 3) {
+      case 0:
+        out.mfg = randomHex(8 + 2 * (m_rng() % 24));
+        break;
+      case 1:
+        out.uuid = "0x" + randomHex(4);
+        out.svc = randomHex(8 + 2 * (m_rng() % 16));
+        break;
+      default:
+        out.mfg = "4c000215" + randomHex(42);
+        break;
+    }
+  } while (out.decode(m_decoder, m_doc) >= 0);
+  out.model = -1;
+}
+
+/*
+ * @brief Sorts the catalog models into the ones synthesize() succeeds for
+ * within attempts and the others.
+ */
+void AdvertGenerator::probeModels(int attempts) {
+  m_models.clear();
+  m_failed.clear();
+  SyntheticAdvert advert;
+  for (int i = 0; i < TheengsDecoder::BLE_ID_MAX; ++i) {
+    if (synthesize(i, randomMac(), advert, attempts)) {
+      m_models.push_back(i);
+    } else {
+      m_failed.push_back(i);
+    }
+  }
+}
+
+AdvertStream::AdvertStream(AdvertGenerator& generator, const StreamConfig& config)
+    : m_gap(config.rate > 0 ? config.rate / 1e6 : 1), m_rng(config.seed) {
+  if (generator.models().empty()) {
+    generator.probeModels();
+  }
+  const std::vector<int>& models = generator.models();
+  std::uniform_real_distribution<double> share(0, 1);
+  std::vector<double> weights;
+  size_t variants = std::max<size_t>(1, config.variants);
+  for (size_t d = 0; d < std::max<size_t>(1, config.devices); ++d) {
+    std::string mac = generator.randomMac();
+    std::vector<SyntheticAdvert> payloads(variants);
+    bool known = !models.empty() && share(m_rng) < config.known_share;
+    int model = known ? models[m_rng() % models.size()] : -1;
+    for (SyntheticAdvert& payload : payloads) {
+      if (!known || !generator.synthesize(model, mac, payload)) {
+        generator.unknown(mac, payload);
+      }
+    }
+    m_known += known;
+    m_devices.push_back(payloads);
+    weights.push_back(1.0 / std::pow(static_cast<double>(d + 1), config.zipf_s));
+  }
+  m_zipf = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+/*
+ * @brief The next advertisement: a device drawn by its Zipf weight sends
+ * one of its payloads after an exponentially distributed gap.
+ */
+const SyntheticAdvert& AdvertStream::next() {
+  std::vector<SyntheticAdvert>& payloads = m_devices[m_zipf(m_rng)];
+  SyntheticAdvert& advert = payloads[m_rng() % payloads.size()];
+  m_time_us += m_gap(m_rng);
+  advert.time_us = static_cast<uint64_t>(m_time_us);
+  return advert;
+}
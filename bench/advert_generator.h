@@ -0,0 +1,142 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ADVERT_GENERATOR_H_
+#define _ADVERT_GENERATOR_H_
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+
+/*
+ * An advertisement as a gateway hands it to the decoder, the fields left
+ * empty being absent.
+ */
+struct SyntheticAdvert {
+  int model; // catalog index it decodes to, -1 for unknown traffic
+  std::string id;
+  std::string name;
+  std::string uuid;
+  std::string svc;
+  std::string mfg;
+  uint64_t time_us; // arrival time in the stream
+
+  std::string json() const;
+  int decode(TheengsDecoder& decoder, JsonDocument& doc) const;
+};
+
+/*
+ * Synthesizes advertisements from the catalog itself: the condition of a
+ * model is walked, picking one alternative of every "|", and the fields are
+ * filled with random bytes satisfying the length, index, contain and mac
+ * constraints picked. Every candidate is decoded to check that it lands on
+ * the model, others being retried with new choices.
+ */
+class AdvertGenerator {
+public:
+  explicit AdvertGenerator(uint32_t seed = 1);
+
+  bool synthesize(int model, const std::string& mac, SyntheticAdvert& out, int attempts = 64);
+  void unknown(const std::string& mac, SyntheticAdvert& out);
+  std::string randomMac();
+
+  // models synthesize() succeeded for on their first try, see probeModels()
+  const std::vector<int>& models() const { return m_models; }
+  const std::vector<int>& failedModels() const { return m_failed; }
+  void probeModels(int attempts = 256);
+
+  std::mt19937& rng() { return m_rng; }
+
+private:
+  /*
+   * One field of a condition with its constraints, e.g.
+   * "servicedata","=",42,"index",2,"09".
+   */
+  struct Clause {
+    int field;
+    std::string op; // length operator, empty without one
+    size_t length;
+    int kind;
+    size_t index;
+    std::string value;
+    bool negate;
+  };
+
+  void pickClauses(const JsonArray& condition, std::vector<Clause>& clauses);
+  void loadProperties(int model);
+  bool build(const std::vector<Clause>& clauses, const std::string& mac, SyntheticAdvert& out);
+  bool buildData(int field, const std::vector<Clause>& clauses, const std::vector<Clause>& hints,
+                 const std::string& mac, std::string& data);
+  std::string randomHex(size_t chars);
+
+  TheengsDecoder m_decoder;
+  DynamicJsonDocument m_doc;
+  // condition and properties of m_model
+  int m_model = -1;
+  DynamicJsonDocument m_condition;
+  DynamicJsonDocument m_properties;
+  size_t m_needs[2] = {}; // service and manufacturer data length the decoders read
+  std::vector<std::vector<Clause> > m_hints; // the index conditions of every property
+  std::mt19937 m_rng;
+  std::vector<int> m_models;
+  std::vector<int> m_failed;
+};
+
+/*
+ * Stream parameters: devices advertising, the share of them being catalog
+ * models (the others unknown devices), the Zipf exponent of how often each
+ * device advertises, and the mean rate of the Poisson arrivals.
+ */
+struct StreamConfig {
+  size_t devices = 1000;
+  double known_share = 0.3;
+  double zipf_s = 1.1;
+  double rate = 1000; // advertisements per second
+  size_t variants = 4; // payloads pregenerated per device
+  uint32_t seed = 1;
+};
+
+/*
+ * An endless stream of advertisements from a population of devices, each a
+ * random MAC with a model drawn uniformly among the ones the generator can
+ * synthesize or unknown, and a few payloads of its own.
+ */
+class AdvertStream {
+public:
+  AdvertStream(AdvertGenerator& generator, const StreamConfig& config);
+
+  const SyntheticAdvert& next();
+  size_t knownDevices() const { return m_known; }
+
+private:
+  std::vector<std::vector<SyntheticAdvert> > m_devices;
+  std::discrete_distribution<size_t> m_zipf;
+  std::exponential_distribution<double> m_gap;
+  std::mt19937 m_rng;
+  double m_time_us = 0;
+  size_t m_known = 0;
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * catalog_gen - writes count synthetic device definitions, in the schema of
+ * src/devices/*.h, as entries of the _devices array to be included through
+ * DECODER_EXTRA_DEVICES, and the corpus of catalog_scaling:
+ *
+ *   catalog_gen count entries.h corpus.jsonl [--seed N]
+ *
+ * The definitions look like the catalog ones: manufacturer data keyed by a
+ * company ID, service data keyed by a 16 bit UUID or a name prefix, a
+ * length constraint and a product code, and 1 to 4 properties. As in the
+ * catalog, where 37 of the 116 models have no condition ENGINE_INDEXED can
+ * key them by, about a third of them give the product code as alternatives
+ * joined by "|", or the name as a pattern, and are tried for every
+ * advertisement.
+ *
+ * The corpus lines are {"stream":name,"advert":{...}}, the streams being
+ * "real" for advertisements of the catalog models, "unknown" for ones no
+ * model decodes and "synthetic" for ones of the generated definitions.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "advert_generator.h"
+
+// Company IDs seen most in the field, most frequent first, the others being uniform
+static const uint16_t company_ids[] = {0x004c, 0x0006, 0x0075, 0x00e0, 0x0059, 0x038f, 0x02e5, 0x0499,
+                                       0xec88, 0x0ba9, 0x006b, 0x0211, 0x0131, 0x0157, 0x0087, 0x0310};
+// 16 bit UUIDs of sensors in the catalog
+static const uint16_t service_uuids[] = {0xfe95, 0xfdcd, 0x181a, 0xfeaa, 0xfcd2, 0xfd3d, 0x181b, 0x181d,
+                                         0xfe9f, 0xfd6f, 0xfeed, 0xfff0};
+// Data lengths of the catalog conditions, in hex characters
+static const int mfg_lengths[] = {12, 18, 24, 26, 28, 32, 36, 40, 42, 44, 48, 50, 52};
+static const int svc_lengths[] = {12, 14, 18, 20, 22, 26, 28, 30, 32, 34, 36, 42, 48};
+// Share of the catalog models without a key condition, 37 of 116
+static const double keyless_share = 37.0 / 116;
+
+struct Property {
+  const char* key;
+  const char* unit;
+  const char* name;
+  int chars;
+  const char* decoder_tail;
+};
+
+static const Property properties[] = {
+    {"tempc", "°C", "temperature", 4, "true,true],\"post_proc\":[\"/\",100]"},
+    {"hum", "%", "humidity", 4, "true,false],\"post_proc\":[\"/\",100]"},
+    {"batt", "%", "battery", 2, "false,false]"},
+    {"volt", "V", "voltage", 4, "true,false],\"post_proc\":[\"/\",1000]"},
+};
+
+struct Definition {
+  std::string json;
+  std::string props;
+  std::string advert;
+};
+
+static std::string hex(uint32_t value, int digits) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%0*x", digits, value);
+  return buf;
+}
+
+static std::string hexLE16(uint16_t value) {
+  return hex(value & 0xff, 2) + hex(value >> 8, 2);
+}
+
+static std::string randomHex(std::mt19937& rng, size_t chars) {
+  std::string data;
+  while (data.size() < chars) {
+    data += hex(rng() & 0xff, 2);
+  }
+  return data.substr(0, chars);
+}
+
+// A product code distinct for every n < 2^24
+static std::string productCode(size_t n) {
+  return hex((n * 2654435761u) & 0xffffff, 6);
+}
+
+static std::string cString(const std::string& json) {
+  std::string out = "\"";
+  for (char ch : json) {
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+    }
+    out += ch;
+  }
+  return out + "\"";
+}
+
+/*
+ * @brief Definition number n, identified by a code unique to it, with an
+ * advertisement it decodes. A keyless definition accepts a second code, that
+ * of no other definition, or matches the name with "contain".
+ */
+static Definition makeDefinition(size_t n, std::mt19937& rng, std::discrete_distribution<int>& popular) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  std::string code = productCode(n);
+  std::string other_code = productCode(n + 0x800000); // n < 2^23
+  bool keyless = unit(rng) < keyless_share;
+  std::string model_id = "SYN" + hex(n, 6);
+  int prop_count = 1 + rng() % 4;
+  int start;
+  std::string field;
+  std::string condition;
+  std::string mac = "";
+  for (int i = 0; i < 6; ++i) {
+    mac += (i ? ":" : "") + hex(rng() & 0xff, 2);
+  }
+  std::string advert = "{\"stream\":\"synthetic\",\"advert\":{\"id\":\"" + mac + "\"";
+
+  double kind = unit(rng);
+  if (kind < 0.45) {
+    // manufacturer data: company ID then product code
+    uint16_t company = unit(rng) < 0.7 ? company_ids[popular(rng)] : static_cast<uint16_t>(rng() & 0x0fff);
+    int len = std::max(mfg_lengths[rng() % 13], 10 + 4 * prop_count);
+    bool exact = unit(rng) < 0.7;
+    field = "manufacturerdata";
+    std::string length = "\"manufacturerdata\",\"" + std::string(exact ? "=" : ">=") + "\"," + std::to_string(len);
+    if (keyless) {
+      // the product codes of a model, e.g. M1017
+      condition = length + ",\"index\",0,\"" + hexLE16(company) + code + "\",\"|\"," + length + ",\"index\",0,\"" +
+                  hexLE16(company) + other_code + "\"";
+    } else {
+      condition = length + ",\"index\",0,\"" + hexLE16(company) + "\",\"&\",\"manufacturerdata\",\"index\",4,\"" +
+                  code + "\"";
+    }
+    start = 10;
+    int advert_len = exact ? len : len + 2 * (rng() % 4);
+    advert += ",\"manufacturerdata\":\"" + hexLE16(company) + code + randomHex(rng, advert_len - 10) + "\"";
+  } else if (kind < 0.85) {
+    // service data: product code under a UUID
+    uint16_t uuid = unit(rng) < 0.4 ? service_uuids[rng() % 12] : static_cast<uint16_t>(0xfc00 + rng() % 0x300);
+    int len = std::max(svc_lengths[rng() % 13], 6 + 4 * prop_count);
+    field = "servicedata";
+    std::string length = "\"servicedata\",\"=\"," + std::to_string(len);
+    // the product codes of a model under its UUID, e.g. CGDN1
+    condition = length + ",\"index\",0,\"" + code + "\"" +
+                (keyless ? ",\"|\"," + length + ",\"index\",0,\"" + other_code + "\"" : std::string()) +
+                ",\"&\",\"uuid\",\"index\",0,\"" + hex(uuid, 4) + "\"";
+    start = 6;
+    advert += ",\"servicedatauuid\":\"0x" + hex(uuid, 4) + "\",\"servicedata\":\"" + code +
+              randomHex(rng, len - 6) + "\"";
+  } else {
+    // name prefix with manufacturer data
+    uint16_t company = company_ids[popular(rng)];
+    int len = std::max(mfg_lengths[rng() % 13], 4 + 4 * prop_count);
+    std::string name = "SYN-" + code;
+    field = "manufacturerdata";
+    // a name pattern, like the "contain" conditions of the catalog
+    condition = "\"name\",\"" + std::string(keyless ? "contain\",\"" : "index\",0,\"") + name + "\"" +
+                ",\"&\",\"manufacturerdata\",\">=\"," + std::to_string(len) + ",\"index\",0,\"" + hexLE16(company) + "\"";
+    start = 4;
+    advert += ",\"name\":\"" + name + "\",\"manufacturerdata\":\"" + hexLE16(company) + randomHex(rng, len - 4) + "\"";
+  }
+  advert += "}}";
+
+  std::string props_json;
+  std::string props_meta;
+  for (int p = 0; p < prop_count; ++p) {
+    const Property& prop = properties[p];
+    props_json += std::string(p ? "," : "") + "\"" + prop.key + "\":{\"decoder\":[\"value_from_hex_data\",\"" + field +
+                  "\"," + std::to_string(start) + "," + std::to_string(prop.chars) + "," + prop.decoder_tail + "}";
+    props_meta += std::string(p ? "," : "") + "\"" + prop.key + "\":{\"unit\":\"" + prop.unit +
+                  "\",\"name\":\"" + prop.name + "\"}";
+    start += 4;
+  }
+
+  Definition def;
+  def.json = "{\"brand\":\"Synthetic\",\"model\":\"Sensor " + std::to_string(n) + "\",\"model_id\":\"" + model_id +
+             "\",\"tag\":\"0101\",\"condition\":[" + condition + "],\"properties\":{" + props_json + "}}";
+  def.props = "{\"properties\":{" + props_meta + "}}";
+  def.advert = advert;
+  return def;
+}
+
+int main(int argc, char** argv) {
+  uint32_t seed = 1;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--seed" && i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else {
+      args.push_back(arg);
+    }
+  }
+  if (args.size() != 3) {
+    std::cerr << "usage: " << argv[0] << " count entries.h corpus.jsonl [--seed N]" << std::endl;
+    return 1;
+  }
+  size_t count = std::stoul(args[0]);
+
+  std::mt19937 rng(seed);
+  std::vector<double> weights;
+  for (size_t rank = 1; rank <= sizeof(company_ids) / sizeof(company_ids[0]); ++rank) {
+    weights.push_back(1.0 / rank);
+  }
+  std::discrete_distribution<int> popular(weights.begin(), weights.end());
+
+  std::ofstream header(args[1]);
+  std::ofstream corpus(args[2]);
+  AdvertGenerator generator(seed);
+  generator.probeModels();
+  SyntheticAdvert advert;
+  for (int model : generator.models()) {
+    for (int i = 0; i < 2; ++i) {
+      if (generator.synthesize(model, generator.randomMac(), advert)) {
+        corpus << "{\"stream\":\"real\",\"advert\":" << advert.json() << "}\n";
+      }
+    }
+  }
+  for (int i = 0; i < 256; ++i) {
+    generator.unknown(generator.randomMac(), advert);
+    corpus << "{\"stream\":\"unknown\",\"advert\":" << advert.json() << "}\n";
+  }
+
+  header << "// " << count << " synthetic device definitions generated by catalog_gen, do not edit\n";
+  // the corpus spreads up to 4096 advertisements evenly over the definitions
+  size_t step = count > 4096 ? count / 4096 : 1;
+  for (size_t n = 0; n < count; ++n) {
+    Definition def = makeDefinition(n, rng, popular);
+    header << "{" << cString(def.json) << ", " << cString(def.props) << "},\n";
+    if (n % step == 0) {
+      corpus << def.advert << "\n";
+    }
+  }
+  if (!header || !corpus) {
+    std::cerr << "cannot write " << args[1] << " or " << args[2] << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,234 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * catalog_scaling - measures the decoder built with the catalog extended by
+ * the definitions of catalog_gen, on the corpus written with them:
+ *
+ *   catalog_scaling_N corpus.jsonl [--out results.jsonl] [--ms N] [--max-exponent e]
+ *                     [--engine reference|conditions|indexed]
+ *
+ * It prints one JSON line with the catalog size, the engine, the resident
+ * memory and the mean decode time of every stream of the corpus with the
+ * share of it decoded. The engine is ENGINE_INDEXED unless given. With --out
+ * the line is appended to results.jsonl, and the growth of each stream
+ * against the first line holding it with the same engine is given as the
+ * exponent e of cost ~ models^e. The run fails if one reaches the maximum, 1
+ * by default for a sublinear growth, 0 turning the check off.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "advert_generator.h"
+
+#ifdef __linux__
+#  include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static long rssKiB() {
+  long pages = 0;
+#ifdef __linux__
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm != nullptr) {
+    if (fscanf(statm, "%*ld %ld", &pages) != 1) {
+      pages = 0;
+    }
+    fclose(statm);
+  }
+  pages *= sysconf(_SC_PAGESIZE) / 1024;
+#endif
+  return pages;
+}
+
+static std::string stringField(JsonObject object, const char* key) {
+  const char* value = object[key].as<const char*>();
+  return value != nullptr ? value : "";
+}
+
+static bool readCorpus(const char* path, std::map<std::string, std::vector<SyntheticAdvert> >& streams) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  std::string line;
+  DynamicJsonDocument doc(4096);
+  while (std::getline(in, line)) {
+    if (deserializeJson(doc, line) || !doc["advert"].is<JsonObject>()) {
+      continue;
+    }
+    JsonObject fields = doc["advert"];
+    SyntheticAdvert advert;
+    advert.model = -1;
+    advert.time_us = 0;
+    advert.id = stringField(fields, "id");
+    advert.name = stringField(fields, "name");
+    advert.uuid = stringField(fields, "servicedatauuid");
+    advert.svc = stringField(fields, "servicedata");
+    advert.mfg = stringField(fields, "manufacturerdata");
+    streams[stringField(doc.as<JsonObject>(), "stream")].push_back(advert);
+  }
+  // the slowest runs only decode the first adverts, which must not all sit early in the catalog
+  std::mt19937 rng(1);
+  for (auto& stream : streams) {
+    std::shuffle(stream.second.begin(), stream.second.end(), rng);
+  }
+  return true;
+}
+
+// Adverts decoded at least by every run, however slow
+static const size_t MIN_RUN_ADVERTS = 16;
+
+/*
+ * @brief Mean time of decoding the adverts in turn, the median of 3 runs of
+ * at least ms milliseconds. decoded receives the share of the adverts of the
+ * first run a model decoded.
+ */
+static double meanDecodeNs(TheengsDecoder& decoder, JsonDocument& doc, const std::vector<SyntheticAdvert>& adverts,
+                           double ms, double* decoded) {
+  double runs[3];
+  for (int r = 0; r < 3; ++r) {
+    Clock::time_point start = Clock::now();
+    size_t count = 0;
+    size_t matches = 0;
+    double elapsed = 0;
+    while (count < std::min(adverts.size(), MIN_RUN_ADVERTS) || elapsed < ms * 1e6) {
+      matches += adverts[count % adverts.size()].decode(decoder, doc) >= 0;
+      ++count;
+      elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+    runs[r] = elapsed / count;
+    if (r == 0) {
+      *decoded = static_cast<double>(matches) / count;
+    }
+  }
+  std::sort(runs, runs + 3);
+  return runs[1];
+}
+
+int main(int argc, char** argv) {
+  const char* corpus_path = nullptr;
+  const char* out_path = nullptr;
+  double ms = 200;
+  double max_exponent = 1;
+  const char* engine_names[TheengsDecoder::ENGINE_COUNT] = {"reference", "conditions", "indexed"};
+  int engine = TheengsDecoder::ENGINE_INDEXED;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (arg == "--ms" && i + 1 < argc) {
+      ms = std::stod(argv[++i]);
+    } else if (arg == "--max-exponent" && i + 1 < argc) {
+      max_exponent = std::stod(argv[++i]);
+    } else if (arg == "--engine" && i + 1 < argc) {
+      std::string name = argv[++i];
+      engine = 0;
+      while (engine < TheengsDecoder::ENGINE_COUNT && name != engine_names[engine]) {
+        ++engine;
+      }
+      if (engine == TheengsDecoder::ENGINE_COUNT) {
+        corpus_path = nullptr;
+        break;
+      }
+    } else if (arg[0] != '-' && corpus_path == nullptr) {
+      corpus_path = argv[i];
+    } else {
+      corpus_path = nullptr;
+      break;
+    }
+  }
+  std::map<std::string, std::vector<SyntheticAdvert> > streams;
+  if (corpus_path == nullptr || !readCorpus(corpus_path, streams)) {
+    std::cerr << "usage: " << argv[0] << " corpus.jsonl [--out results.jsonl] [--ms N] [--max-exponent e]"
+              << " [--engine reference|conditions|indexed]" << std::endl;
+    return 1;
+  }
+
+  TheengsDecoder decoder;
+  decoder.setEngine(static_cast<TheengsDecoder::MatchEngine>(engine));
+  size_t models;
+  decoder.getCatalog(&models);
+  DynamicJsonDocument doc(decoder.getDocMax());
+
+  std::ostringstream line;
+  line << "{\"models\":" << models << ",\"extra_models\":" << models - TheengsDecoder::BLE_ID_MAX << ",\"engine\":\""
+       << engine_names[engine] << "\"";
+  std::map<std::string, double> costs;
+  for (const auto& stream : streams) {
+    double decoded;
+    double ns = meanDecodeNs(decoder, doc, stream.second, ms, &decoded);
+    costs[stream.first] = ns;
+    line << ",\"" << stream.first << "_ns\":" << std::llround(ns) << ",\"" << stream.first
+         << "_decoded\":" << std::round(decoded * 1000) / 1000;
+  }
+  line << ",\"rss_kib\":" << rssKiB();
+
+  // growth against the first line measuring each stream
+  bool failed = false;
+  if (out_path != nullptr) {
+    std::ifstream previous(out_path);
+    std::string text;
+    std::map<std::string, bool> compared;
+    DynamicJsonDocument base(4096);
+    while (std::getline(previous, text)) {
+      if (deserializeJson(base, text) || stringField(base.as<JsonObject>(), "engine") != engine_names[engine]) {
+        continue;
+      }
+      double base_models = base["models"].as<double>();
+      for (const auto& cost : costs) {
+        double base_ns = base[cost.first + "_ns"].as<double>();
+        if (compared[cost.first] || base_ns <= 0 || base_models <= 0 || base_models >= models) {
+          continue;
+        }
+        compared[cost.first] = true;
+        double exponent = std::log(cost.second / base_ns) / std::log(models / base_models);
+        line << ",\"" << cost.first << "_exponent\":" << std::round(exponent * 1000) / 1000;
+        if (max_exponent > 0 && exponent >= max_exponent) {
+          std::cerr << cost.first << " decode time grows as models^" << exponent << " from "
+                    << base_models << " to " << models << " models" << std::endl;
+          failed = true;
+        }
+      }
+    }
+  }
+  line << "}";
+
+  std::cout << line.str() << std::endl;
+  if (out_path != nullptr) {
+    std::ofstream out(out_path, std::ios::app);
+    out << line.str() << "\n";
+  }
+  return failed ? 1 : 0;
+}
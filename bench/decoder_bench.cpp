@@ -0,0 +1,410 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * decoder_bench - measures the decoder on the BLE test vectors and on
+ * synthetic traffic mixes, and writes the results as JSON so that runs can
+ * be compared across commits:
+ *
+ *   decoder_bench [--quick] [--out results.json]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "json_scanner.h"
+#include "shared/theengs.h"
+#include "test_ble_adverts.h"
+
+static std::string randomHex(std::mt19937& rng, size_t bytes) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  for (size_t i = 0; i < bytes * 2; ++i) {
+    hex += digits[rng() & 0x0f];
+  }
+  return hex;
+}
+
+/*
+ * @brief Generates adverts of devices absent from the catalog, like most of
+ * what a gateway hears: manufacturer data of random companies, service data
+ * of random UUIDs and iBeacon frames of unknown UUIDs. Candidates decoded by
+ * some model are dropped.
+ */
+static std::vector<Advert> unknownAdverts(TheengsDecoder& decoder, size_t count, std::deque<std::string>& strings) {
+  std::mt19937 rng(42);
+  std::vector<Advert> adverts;
+  while (adverts.size() < count) {
+    const char* mfg = nullptr;
+    const char* svc = nullptr;
+    const char* uuid = nullptr;
+    switch (rng() % 3) {
+      case 0:
+        strings.push_back(randomHex(rng, 4 + rng() % 24));
+        mfg = strings.back().c_str();
+        break;
+      case 1:
+        strings.push_back("0x" + randomHex(rng, 2));
+        uuid = strings.back().c_str();
+        strings.push_back(randomHex(rng, 4 + rng() % 16));
+        svc = strings.back().c_str();
+        break;
+      default:
+        strings.push_back("4c000215" + randomHex(rng, 21));
+        mfg = strings.back().c_str();
+        break;
+    }
+    Advert advert = makeAdvert("unknown", -1, nullptr, nullptr, uuid, svc, mfg);
+    StaticJsonDocument<2048> doc;
+    deserializeJson(doc, advert.json);
+    JsonObject object = doc.as<JsonObject>();
+    if (decoder.decodeBLEJson(object) < 0) {
+      adverts.push_back(advert);
+    }
+  }
+  return adverts;
+}
+
+// Timing of one operation, in nanoseconds
+struct Timing {
+  double median;
+  double min;
+};
+
+static double sample_ms = 20;
+static const int SAMPLES = 5;
+static volatile int sink; // keeps the measured calls from being optimized out
+
+/*
+ * @brief Times op, run repeatedly for about sample_ms per sample after
+ * calibrating the repetitions, and returns the median and minimum of the
+ * samples per call.
+ */
+static Timing measure(const std::function<int()>& op) {
+  typedef std::chrono::steady_clock clock;
+  size_t reps = 1;
+  for (;;) {
+    clock::time_point start = clock::now();
+    for (size_t i = 0; i < reps; ++i) {
+      sink = op();
+    }
+    double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    if (ms >= sample_ms / 4 || reps >= (1u << 24)) {
+      reps = std::max<size_t>(1, static_cast<size_t>(reps * sample_ms / std::max(ms, 1e-3)));
+      break;
+    }
+    reps *= 4;
+  }
+
+  std::vector<double> samples;
+  for (int s = 0; s < SAMPLES; ++s) {
+    clock::time_point start = clock::now();
+    for (size_t i = 0; i < reps; ++i) {
+      sink = op();
+    }
+    samples.push_back(std::chrono::duration<double, std::nano>(clock::now() - start).count() / reps);
+  }
+  std::sort(samples.begin(), samples.end());
+  Timing timing = {samples[SAMPLES / 2], samples[0]};
+  return timing;
+}
+
+/*
+ * @brief Same as above for a pass calling op on each of count items, returning
+ * the timing per item so that every item weighs the same in each sample.
+ */
+static Timing measureEach(size_t count, const std::function<int(size_t)>& op) {
+  Timing timing = measure([&]() {
+    int res = 0;
+    for (size_t i = 0; i < count; ++i) {
+      res += op(i);
+    }
+    return res;
+  });
+  timing.median /= count;
+  timing.min /= count;
+  return timing;
+}
+
+static std::string number(double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.1f", value);
+  return buf;
+}
+
+static std::string timingJson(const Timing& timing) {
+  return "{\"median_ns\":" + number(timing.median) + ",\"min_ns\":" + number(timing.min) + "}";
+}
+
+/*
+ * @brief Per vector decode latency, the vectors grouped by the model they decode to.
+ */
+static std::string benchVectors(TheengsDecoder& decoder, const std::vector<Advert>& vectors) {
+  StaticJsonDocument<2048> doc;
+  std::map<int, std::vector<const Advert*> > models;
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    models[vectors[i].expected].push_back(&vectors[i]);
+  }
+
+  std::ostringstream out;
+  out << "[";
+  for (std::map<int, std::vector<const Advert*> >::iterator it = models.begin(); it != models.end(); ++it) {
+    std::string model_id = decoder.getTheengAttribute(it->first, "model_id");
+    out << (it == models.begin() ? "" : ",") << "\n    {\"model\":" << it->first
+        << ",\"model_id\":" << jsonString(model_id.c_str()) << ",\"vectors\":[";
+    double total = 0;
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      const Advert& advert = *it->second[i];
+      if (decodeAdvert(decoder, doc, advert) != advert.expected) {
+        std::cerr << "vector " << advert.test << " " << advert.json << " not decoded to " << advert.expected << std::endl;
+      }
+      Timing timing = measure([&]() { return decodeAdvert(decoder, doc, advert); });
+      total += timing.median;
+      out << (i ? "," : "") << "\n      {\"test\":" << jsonString(advert.test)
+          << ",\"input\":" << jsonString(advert.json.c_str()) << ",\"latency\":" << timingJson(timing) << "}";
+    }
+    out << "],\"mean_median_ns\":" << number(total / it->second.size()) << "}";
+  }
+  out << "\n  ]";
+  return out.str();
+}
+
+/*
+ * @brief Throughput of a stream where a known_share of the adverts come from
+ * catalog models drawn with a Zipf distribution of exponent s over the test
+ * vectors, the others from unknown devices.
+ */
+static std::string benchMix(TheengsDecoder& decoder, const std::vector<Advert>& vectors,
+                            const std::vector<Advert>& unknown, double known_share, double s) {
+  const size_t stream_len = 1024;
+  std::mt19937 rng(7);
+
+  std::vector<double> weights;
+  for (size_t rank = 1; rank <= vectors.size(); ++rank) {
+    weights.push_back(1.0 / std::pow(static_cast<double>(rank), s));
+  }
+  std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+  std::vector<size_t> order(vectors.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), rng); // popularity is unrelated to catalog order
+  std::uniform_real_distribution<double> share(0, 1);
+
+  std::vector<const Advert*> stream;
+  for (size_t i = 0; i < stream_len; ++i) {
+    if (share(rng) < known_share) {
+      stream.push_back(&vectors[order[zipf(rng)]]);
+    } else {
+      stream.push_back(&unknown[rng() % unknown.size()]);
+    }
+  }
+
+  StaticJsonDocument<2048> doc;
+  Timing timing = measureEach(stream_len, [&](size_t i) { return decodeAdvert(decoder, doc, *stream[i]); });
+  std::ostringstream out;
+  out << "{\"known_share\":" << known_share << ",\"zipf_s\":" << s
+      << ",\"per_advert\":" << timingJson(timing)
+      << ",\"adverts_per_s\":" << number(1e9 / timing.median) << "}";
+  return out.str();
+}
+
+/*
+ * @brief Cost of rejecting the adverts no model decodes.
+ */
+static std::string benchReject(TheengsDecoder& decoder, const std::vector<Advert>& unknown) {
+  StaticJsonDocument<2048> doc;
+  Advert cases[] = {
+      makeAdvert("empty", -1, nullptr, nullptr, nullptr, nullptr, nullptr),
+      makeAdvert("name_only", -1, "AA:BB:CC:DD:EE:FF", "unknown device", nullptr, nullptr, nullptr),
+      makeAdvert("short_mfgdata", -1, nullptr, nullptr, nullptr, nullptr, "ffff01"),
+      makeAdvert("unknown_ibeacon", -1, nullptr, nullptr, nullptr, nullptr, "4c000215000102030405060708090a0b0c0d0e0f00010002c5"),
+      makeAdvert("unknown_svcdata", -1, nullptr, nullptr, "0xfa11", "123456789abcdef0", nullptr),
+  };
+
+  std::ostringstream out;
+  out << "{";
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    const Advert& advert = cases[i];
+    out << (i ? "," : "") << "\n    " << jsonString(advert.test) << ":"
+        << timingJson(measure([&]() { return decodeAdvert(decoder, doc, advert); }));
+  }
+  Timing generated = measureEach(unknown.size(), [&](size_t i) { return decodeAdvert(decoder, doc, unknown[i]); });
+  out << ",\n    \"generated_unknown\":" << timingJson(generated) << "\n  }";
+  return out.str();
+}
+
+/*
+ * @brief Latency of the catalog getters, cycling through every model.
+ */
+static std::string benchGetters(TheengsDecoder& decoder) {
+  std::vector<std::string> model_ids;
+  for (int i = 0; i < TheengsDecoder::BLE_ID_NUM::BLE_ID_MAX; ++i) {
+    model_ids.push_back(decoder.getTheengAttribute(i, "model_id"));
+  }
+  size_t count = model_ids.size();
+
+  std::ostringstream out;
+  out << "{\n    \"getTheengModel\":"
+      << timingJson(measureEach(count, [&](size_t i) { return decoder.getTheengModel(model_ids[i].c_str()); }))
+      << ",\n    \"getTheengAttribute_brand\":"
+      << timingJson(measureEach(count, [&](size_t i) { return static_cast<int>(decoder.getTheengAttribute(model_ids[i].c_str(), "brand").size()); }))
+      << ",\n    \"getTheengAttribute_condition\":"
+      << timingJson(measureEach(count, [&](size_t i) { return static_cast<int>(decoder.getTheengAttribute(model_ids[i].c_str(), "condition").size()); }))
+      << ",\n    \"getTheengProperties\":"
+      << timingJson(measureEach(count, [&](size_t i) { return static_cast<int>(decoder.getTheengProperties(model_ids[i].c_str()).size()); }))
+      << ",\n    \"getCatalog\":"
+      << timingJson(measure([&]() {
+           size_t models;
+           return decoder.getCatalog(&models) != nullptr ? static_cast<int>(models) : 0;
+         }))
+      << "\n  }";
+  return out.str();
+}
+
+/*
+ * @brief Cost per advert of decoding the test vectors as JSON text in C++,
+ * through the complete document or scanned, and through the C API functions.
+ */
+static std::string benchCApi(TheengsDecoder& decoder, const std::vector<Advert>& vectors) {
+  void* handle = Theengs_NewDecoder();
+  std::vector<char> out(4096);
+  size_t count = vectors.size();
+
+  DynamicJsonDocument doc(4096);
+  std::string text;
+  Timing cpp = measureEach(count, [&](size_t i) {
+    const Advert& advert = vectors[i];
+    doc.clear();
+    deserializeJson(doc, advert.json);
+    JsonObject object = doc.as<JsonObject>();
+    int res = decoder.decodeBLEJson(object);
+    if (res >= 0) {
+      text.clear();
+      serializeJson(object, text);
+    }
+    return res;
+  });
+  DynamicJsonDocument devices(decoder.getDocMax());
+  Timing scanned = measureEach(count, [&](size_t i) {
+    return decodeBLEJsonText(decoder, devices, vectors[i].json.c_str(), text);
+  });
+  Timing into = measureEach(count, [&](size_t i) {
+    size_t len;
+    return static_cast<int>(Theengs_DecodeBLEInto(handle, vectors[i].json.c_str(), out.data(), out.size(), &len));
+  });
+  Timing strings = measureEach(count, [&](size_t i) {
+    const char* decoded = Theengs_DecodeBLE(handle, vectors[i].json.c_str());
+    Theengs_FreeString(decoded);
+    return decoded != nullptr;
+  });
+
+  std::string inputs;
+  std::vector<size_t> lens;
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    inputs += vectors[i].json;
+    lens.push_back(vectors[i].json.size());
+  }
+  std::vector<Theengs_Result> results(vectors.size());
+  std::vector<char> arena(vectors.size() * 1024);
+  Timing batch = measure([&]() {
+    size_t used;
+    return static_cast<int>(Theengs_DecodeBLEBatch(handle, inputs.data(), lens.data(), lens.size(),
+                                                   arena.data(), arena.size(), results.data(), &used));
+  });
+  batch.median /= count;
+  batch.min /= count;
+  Theengs_DestroyDecoder(handle);
+
+  std::ostringstream out_json;
+  out_json << "{\n    \"cpp_json_text\":" << timingJson(cpp)
+           << ",\n    \"cpp_scanned_text\":" << timingJson(scanned)
+           << ",\n    \"Theengs_DecodeBLEInto\":" << timingJson(into)
+           << ",\n    \"Theengs_DecodeBLE\":" << timingJson(strings)
+           << ",\n    \"Theengs_DecodeBLEBatch\":" << timingJson(batch)
+           << ",\n    \"into_overhead_ns\":" << number(into.median - cpp.median)
+           << ",\n    \"string_overhead_ns\":" << number(strings.median - cpp.median)
+           << "\n  }";
+  return out_json.str();
+}
+
+int main(int argc, char** argv) {
+  const char* out_path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--quick") == 0) {
+      sample_ms = 2;
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--quick] [--out results.json]" << std::endl;
+      return 1;
+    }
+  }
+
+  TheengsDecoder decoder;
+  std::vector<Advert> vectors = testVectors();
+  std::deque<std::string> strings;
+  std::vector<Advert> unknown = unknownAdverts(decoder, 256, strings);
+
+  std::ostringstream json;
+  json << "{\n  \"benchmark\":\"decoder_bench\",\n  \"models\":" << TheengsDecoder::BLE_ID_NUM::BLE_ID_MAX
+       << ",\n  \"sample_ms\":" << sample_ms << ",\n  \"samples\":" << SAMPLES;
+  std::cerr << "vectors" << std::endl;
+  json << ",\n  \"vectors\":" << benchVectors(decoder, vectors);
+  std::cerr << "mixes" << std::endl;
+  json << ",\n  \"mixes\":[\n    " << benchMix(decoder, vectors, unknown, 0.0, 1.0)
+       << ",\n    " << benchMix(decoder, vectors, unknown, 0.1, 1.0)
+       << ",\n    " << benchMix(decoder, vectors, unknown, 0.3, 1.2)
+       << ",\n    " << benchMix(decoder, vectors, unknown, 1.0, 1.0) << "\n  ]";
+  std::cerr << "reject" << std::endl;
+  json << ",\n  \"reject\":" << benchReject(decoder, unknown);
+  std::cerr << "getters" << std::endl;
+  json << ",\n  \"getters\":" << benchGetters(decoder);
+  std::cerr << "C API" << std::endl;
+  json << ",\n  \"c_api\":" << benchCApi(decoder, vectors) << "\n}\n";
+
+  if (out_path != nullptr) {
+    std::ofstream file(out_path);
+    file << json.str();
+    if (!file) {
+      std::cerr << "cannot write " << out_path << std::endl;
+      return 1;
+    }
+  } else {
+    std::cout << json.str();
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+"""Measures the Python binding on the test vectors of a decoder_bench run.
+
+    python decoder_bench.py decoder_bench.json [--out python_bench.json]
+
+The inputs are read from the JSON written by decoder_bench and the overhead
+of each entry point is reported against its C++ "cpp_json_text" timing, the
+same vectors decoded from JSON text without Python.
+"""
+
+import argparse
+import json
+import statistics
+import time
+
+import TheengsDecoder
+
+SAMPLES = 5
+
+
+def measure(op, count, sample_s):
+    """Returns the median and minimum time per item of op, a pass over count items."""
+    reps = 1
+    while True:
+        start = time.perf_counter()
+        for _ in range(reps):
+            op()
+        elapsed = time.perf_counter() - start
+        if elapsed >= sample_s / 4:
+            reps = max(1, int(reps * sample_s / elapsed))
+            break
+        reps *= 4
+
+    samples = []
+    for _ in range(SAMPLES):
+        start = time.perf_counter()
+        for _ in range(reps):
+            op()
+        samples.append((time.perf_counter() - start) * 1e9 / (reps * count))
+    return {"median_ns": round(statistics.median(samples), 1), "min_ns": round(min(samples), 1)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("cpp_results", help="JSON written by decoder_bench")
+    parser.add_argument("--out", help="file receiving the results, stdout otherwise")
+    parser.add_argument("--quick", action="store_true", help="shorter samples")
+    args = parser.parse_args()
+
+    with open(args.cpp_results) as f:
+        cpp = json.load(f)
+    texts = [vector["input"] for model in cpp["vectors"] for vector in model["vectors"]]
+    dicts = [json.loads(text) for text in texts]
+    sample_s = 0.002 if args.quick else 0.02
+
+    decoder = TheengsDecoder.Decoder()
+    results = {
+        "decodeBLE": measure(lambda: [TheengsDecoder.decodeBLE(t) for t in texts], len(texts), sample_s),
+        "Decoder.decodeBLE": measure(lambda: [decoder.decodeBLE(d) for d in dicts], len(dicts), sample_s),
+        "decode_many": measure(lambda: TheengsDecoder.decode_many(dicts), len(dicts), sample_s),
+    }
+    baseline = cpp["c_api"]["cpp_json_text"]["median_ns"]
+    for timing in results.values():
+        timing["overhead_ns"] = round(timing["median_ns"] - baseline, 1)
+
+    output = json.dumps({"benchmark": "decoder_bench.py", "vectors": len(texts), "python": results}, indent=2)
+    if args.out:
+        with open(args.out, "w") as f:
+            f.write(output + "\n")
+    else:
+        print(output)
+
+
+if __name__ == "__main__":
+    main()
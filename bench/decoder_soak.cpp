@@ -0,0 +1,203 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * decoder_soak - decodes a synthetic advertisement stream for a long time
+ * and prints, every interval, one JSON line with the throughput and its
+ * drift from the first interval, the resident memory and its growth, and
+ * the latency percentiles of a sample of the decodes:
+ *
+ *   decoder_soak [--adverts N] [--duration s] [--interval s] [--pool N]
+ *                [--devices N] [--known share] [--zipf s] [--seed N]
+ *                [--max-rss-growth KiB]
+ *
+ * It stops after N advertisements (1e9 by default) or s seconds, and fails
+ * if the resident memory grew by more than the given KiB since the end of
+ * the first interval, which warms the allocator and the catalog caches up.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "advert_generator.h"
+
+#ifdef __linux__
+#  include <unistd.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// One decode out of SAMPLE_EVERY is timed
+static const uint64_t SAMPLE_EVERY = 64;
+// The clock is checked for the end of an interval every CHECK_EVERY decodes
+static const uint64_t CHECK_EVERY = 256;
+
+static long rssKiB() {
+#ifdef __linux__
+  long pages = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm != nullptr) {
+    if (fscanf(statm, "%*ld %ld", &pages) != 1) {
+      pages = 0;
+    }
+    fclose(statm);
+  }
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#  ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // bytes, and the peak only
+#  else
+  return usage.ru_maxrss;
+#  endif
+#endif
+}
+
+static uint64_t percentile(std::vector<uint32_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+int main(int argc, char** argv) {
+  StreamConfig config;
+  config.devices = 5000;
+  uint64_t adverts = 1000000000ULL;
+  double duration = 0;
+  double interval = 10;
+  size_t pool_size = 1 << 16;
+  long max_growth = 1024;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--adverts" && i + 1 < argc) {
+      adverts = static_cast<uint64_t>(std::stod(argv[++i]));
+    } else if (arg == "--duration" && i + 1 < argc) {
+      duration = std::stod(argv[++i]);
+    } else if (arg == "--interval" && i + 1 < argc) {
+      interval = std::max(0.1, std::stod(argv[++i]));
+    } else if (arg == "--pool" && i + 1 < argc) {
+      pool_size = std::max<size_t>(1, std::stoul(argv[++i]));
+    } else if (arg == "--devices" && i + 1 < argc) {
+      config.devices = std::stoul(argv[++i]);
+    } else if (arg == "--known" && i + 1 < argc) {
+      config.known_share = std::stod(argv[++i]);
+    } else if (arg == "--zipf" && i + 1 < argc) {
+      config.zipf_s = std::stod(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      config.seed = std::stoul(argv[++i]);
+    } else if (arg == "--max-rss-growth" && i + 1 < argc) {
+      max_growth = std::stol(argv[++i]);
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--adverts N] [--duration s] [--interval s] [--pool N]"
+                << " [--devices N] [--known share] [--zipf s] [--seed N] [--max-rss-growth KiB]" << std::endl;
+      return 1;
+    }
+  }
+
+  // the stream is generated up front and replayed, so that only the decoder runs in the loop
+  AdvertGenerator generator(config.seed);
+  AdvertStream stream(generator, config);
+  std::vector<SyntheticAdvert> pool;
+  pool.reserve(pool_size);
+  for (size_t i = 0; i < pool_size; ++i) {
+    pool.push_back(stream.next());
+  }
+  std::cerr << generator.models().size() << " models synthesized, " << config.devices << " devices, "
+            << stream.knownDevices() << " of known models, pool of " << pool_size << std::endl;
+
+  TheengsDecoder decoder;
+  DynamicJsonDocument doc(2048);
+  std::vector<uint32_t> samples;
+  samples.reserve(static_cast<size_t>(interval * 2e7 / SAMPLE_EVERY)); // up to 20M decodes/s
+  Clock::time_point start = Clock::now();
+  Clock::time_point interval_start = start;
+  uint64_t done = 0;
+  uint64_t interval_done = 0;
+  uint64_t decoded = 0;
+  double first_rate = 0;
+  long base_rss = 0;
+  long rss_growth = 0;
+  int intervals = 0;
+  bool finished = false;
+
+  while (!finished) {
+    const SyntheticAdvert& advert = pool[done % pool_size];
+    if (done % SAMPLE_EVERY == 0) {
+      Clock::time_point t = Clock::now();
+      decoded += advert.decode(decoder, doc) >= 0;
+      samples.push_back(static_cast<uint32_t>(std::min<int64_t>(
+          UINT32_MAX, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count())));
+    } else {
+      decoded += advert.decode(decoder, doc) >= 0;
+    }
+    ++done;
+    ++interval_done;
+    finished = done >= adverts;
+    if (done % CHECK_EVERY != 0 && !finished) {
+      continue;
+    }
+
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - start).count();
+    double interval_s = std::chrono::duration<double>(now - interval_start).count();
+    finished = finished || (duration > 0 && elapsed >= duration);
+    if (interval_s < interval && !finished) {
+      continue;
+    }
+
+    double rate = interval_done / interval_s;
+    long rss = rssKiB();
+    if (intervals++ == 0) {
+      first_rate = rate;
+      base_rss = rss;
+    }
+    rss_growth = rss - base_rss;
+    std::sort(samples.begin(), samples.end());
+    printf("{\"interval\":%d,\"elapsed_s\":%.1f,\"adverts\":%llu,\"decoded\":%llu,\"adverts_per_s\":%.0f,"
+           "\"drift\":%.4f,\"rss_kib\":%ld,\"rss_growth_kib\":%ld,\"p50_ns\":%llu,\"p99_ns\":%llu,"
+           "\"p999_ns\":%llu,\"max_ns\":%llu}\n",
+           intervals, elapsed, (unsigned long long)done, (unsigned long long)decoded, rate,
+           rate / first_rate - 1, rss, rss_growth,
+           (unsigned long long)percentile(samples, 0.5), (unsigned long long)percentile(samples, 0.99),
+           (unsigned long long)percentile(samples, 0.999),
+           (unsigned long long)(samples.empty() ? 0 : samples.back()));
+    fflush(stdout);
+    samples.clear();
+    interval_start = now;
+    interval_done = 0;
+  }
+
+  if (rss_growth > max_growth) {
+    std::cerr << "resident memory grew by " << rss_growth << " KiB, more than " << max_growth << std::endl;
+    return 1;
+  }
+  return 0;
+}
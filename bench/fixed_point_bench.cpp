@@ -0,0 +1,116 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * fixed_point_bench - decodes the BLE test vectors in double and in fixed
+ * point and compares the time of the two modes:
+ *
+ *   fixed_point_bench [--repeat N] [--diff]
+ *
+ * The gap is the point of the fixed-point mode on targets emulating the
+ * double arithmetic in software: the run_fixed_point_bench target of a build
+ * configured with toolchains/arm-softfloat.cmake runs it on a soft-float ARM
+ * under qemu-arm. It also counts the advertisements whose JSON output
+ * differs in text between the two modes, the exact fixed-point value of a
+ * tie printing one apart in its last decimal, --diff printing them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "test_ble_adverts.h"
+
+/* Decodes the advertisements once, returns the time taken in ns */
+static uint64_t decodeAll(TheengsDecoder& decoder, const std::vector<Advert>& adverts, JsonDocument& doc) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (const Advert& advert : adverts) {
+    decodeAdvert(decoder, doc, advert);
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  int repeat = 20;
+  bool print_diff = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--diff") {
+      print_diff = true;
+    } else {
+      std::cout << "usage: " << argv[0] << " [--repeat N] [--diff]" << std::endl;
+      return 1;
+    }
+  }
+
+  // the advertisements decoded, their properties being what the modes differ in
+  std::vector<Advert> adverts;
+  for (const Advert& advert : testVectors()) {
+    if (advert.expected >= 0) {
+      adverts.push_back(advert);
+    }
+  }
+
+  TheengsDecoder decoder;
+  TheengsDecoder fixed_decoder;
+  decoder.setFixedPoint(false);
+  fixed_decoder.setFixedPoint(true);
+  DynamicJsonDocument doc(4096);
+
+  size_t different = 0;
+  for (const Advert& advert : adverts) {
+    std::string text, fixed_text;
+    decodeAdvert(decoder, doc, advert);
+    serializeJson(doc, text);
+    decodeAdvert(fixed_decoder, doc, advert);
+    serializeJson(doc, fixed_text);
+    if (text != fixed_text) {
+      different++;
+      if (print_diff) {
+        std::cout << advert.test << "\n  double      " << text << "\n  fixed point " << fixed_text << std::endl;
+      }
+    }
+  }
+
+  // the passes of the two modes alternate, sharing the drifts of the machine
+  uint64_t double_ns = 0;
+  uint64_t fixed_ns = 0;
+  for (int pass = 0; pass < repeat; ++pass) {
+    double_ns += decodeAll(decoder, adverts, doc);
+    fixed_ns += decodeAll(fixed_decoder, adverts, doc);
+  }
+
+  double count = static_cast<double>(adverts.size()) * repeat;
+  std::cout << adverts.size() << " advertisements x " << repeat << ", " << different
+            << " written differently in fixed point" << std::endl;
+  printf("%-12s %10.0f ns/advert\n", "double", double_ns / count);
+  printf("%-12s %10.0f ns/advert, %.2fx\n", "fixed point", fixed_ns / count,
+         static_cast<double>(double_ns) / static_cast<double>(fixed_ns));
+  return 0;
+}
@@ -0,0 +1,161 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * match_profile - replays a corpus of advertisements through a decoder built
+ * with DECODER_PROFILE and lists the device definitions costing the most to
+ * match and decode:
+ *
+ *   match_profile [--top N] [--sort ns|comparisons|evaluations] [--repeat N] [corpus.jsonl]
+ *
+ * The corpus holds one advertisement JSON object per line, as published by a
+ * gateway; without one the BLE test vectors are replayed.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "test_ble_adverts.h"
+
+#ifndef DECODER_PROFILE
+#  error "match_profile needs the decoder built with DECODER_PROFILE"
+#endif
+
+enum SortKey {
+  SORT_NS,
+  SORT_COMPARISONS,
+  SORT_EVALUATIONS
+};
+
+static uint64_t sortValue(const TheengsDecoder::MatchProfile& profile, SortKey key) {
+  switch (key) {
+    case SORT_COMPARISONS: return profile.comparisons;
+    case SORT_EVALUATIONS: return profile.evaluations;
+    default: return profile.match_ns + profile.prop_ns;
+  }
+}
+
+static bool readCorpus(const char* path, std::vector<std::string>& corpus) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find('{') != std::string::npos) {
+      corpus.push_back(line);
+    }
+  }
+  return true;
+}
+
+static double ratio(uint64_t num, uint64_t den) {
+  return den == 0 ? 0 : static_cast<double>(num) / den;
+}
+
+int main(int argc, char** argv) {
+  size_t top = 20;
+  int repeat = 10;
+  SortKey sort = SORT_NS;
+  const char* corpus_path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--top" && i + 1 < argc) {
+      top = std::stoul(argv[++i]);
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::stoi(argv[++i]));
+    } else if (arg == "--sort" && i + 1 < argc) {
+      std::string key = argv[++i];
+      sort = key == "comparisons" ? SORT_COMPARISONS : key == "evaluations" ? SORT_EVALUATIONS : SORT_NS;
+    } else if (arg[0] != '-' && corpus_path == nullptr) {
+      corpus_path = argv[i];
+    } else {
+      std::cout << "usage: " << argv[0] << " [--top N] [--sort ns|comparisons|evaluations] [--repeat N] [corpus.jsonl]" << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::string> corpus;
+  if (corpus_path != nullptr) {
+    if (!readCorpus(corpus_path, corpus)) {
+      std::cout << "cannot read " << corpus_path << std::endl;
+      return 1;
+    }
+  } else {
+    std::vector<Advert> adverts = testVectors();
+    for (const Advert& advert : adverts) {
+      corpus.push_back(advert.json);
+    }
+  }
+
+  TheengsDecoder decoder;
+  size_t decoded = 0;
+  size_t invalid = 0;
+  for (int pass = 0; pass < repeat; ++pass) {
+    for (const std::string& json : corpus) {
+      DynamicJsonDocument doc(json.size() * 2 + 1024);
+      if (deserializeJson(doc, json) || !doc.is<JsonObject>()) {
+        invalid += pass == 0;
+        continue;
+      }
+      JsonObject object = doc.as<JsonObject>();
+      if (decoder.decodeBLEJson(object) >= 0) {
+        decoded += pass == 0;
+      }
+    }
+  }
+
+  size_t count;
+  const TheengsDecoder::MatchProfile* profiles = decoder.getMatchProfile(&count);
+  std::vector<int> order;
+  uint64_t total_ns = 0;
+  for (size_t i = 0; i < count; ++i) {
+    order.push_back(static_cast<int>(i));
+    total_ns += profiles[i].match_ns + profiles[i].prop_ns;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return sortValue(profiles[a], sort) > sortValue(profiles[b], sort);
+  });
+
+  std::cout << corpus.size() << " advertisements x " << repeat << ", " << decoded << " decoded, "
+            << invalid << " not JSON objects" << std::endl;
+  printf("%4s %5s %-26s %10s %8s %12s %8s %12s %8s %12s %6s\n",
+         "rank", "index", "model_id", "evals", "matches", "comparisons", "cmp/eval",
+         "match ns", "ns/eval", "props ns", "share");
+  for (size_t r = 0; r < top && r < order.size(); ++r) {
+    const TheengsDecoder::MatchProfile& p = profiles[order[r]];
+    uint64_t ns = p.match_ns + p.prop_ns;
+    printf("%4zu %5d %-26s %10llu %8llu %12llu %8.1f %12llu %8.1f %12llu %5.1f%%\n",
+           r + 1, order[r], decoder.getTheengAttribute(order[r], "model_id").c_str(),
+           (unsigned long long)p.evaluations, (unsigned long long)p.matches,
+           (unsigned long long)p.comparisons, ratio(p.comparisons, p.evaluations),
+           (unsigned long long)p.match_ns, ratio(p.match_ns, p.evaluations),
+           (unsigned long long)p.prop_ns, 100 * ratio(ns, total_ns));
+  }
+  return 0;
+}
@@ -0,0 +1,23 @@
+# Cross builds for a 32 bit ARM without an FPU, the double arithmetic being
+# emulated in software as on the ESP8266, and runs the programs under
+# qemu-arm. On Debian the g++-arm-linux-gnueabi and qemu-user packages
+# provide both:
+#
+#   cmake -S . -B build-softfloat -DCMAKE_TOOLCHAIN_FILE=bench/toolchains/arm-softfloat.cmake
+#   cmake --build build-softfloat --target run_fixed_point_bench
+
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(ARM_SOFTFLOAT_TRIPLE arm-linux-gnueabi CACHE STRING "Prefix of the soft-float ARM toolchain")
+set(CMAKE_C_COMPILER ${ARM_SOFTFLOAT_TRIPLE}-gcc)
+set(CMAKE_CXX_COMPILER ${ARM_SOFTFLOAT_TRIPLE}-g++)
+set(CMAKE_C_FLAGS_INIT "-march=armv5te -mfloat-abi=soft")
+set(CMAKE_CXX_FLAGS_INIT "-march=armv5te -mfloat-abi=soft")
+
+set(CMAKE_FIND_ROOT_PATH /usr/${ARM_SOFTFLOAT_TRIPLE})
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+
+set(CMAKE_CROSSCOMPILING_EMULATOR qemu-arm -L /usr/${ARM_SOFTFLOAT_TRIPLE})
@@ -0,0 +1,177 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * trace_format - renders the decode trace records written by an application
+ * (TheengsDecoder::readTrace output saved as is) as text:
+ *
+ *   trace_format trace.bin
+ *   trace_format --capture trace.bin [corpus.jsonl]
+ *
+ * --capture decodes a corpus of advertisement JSON lines, or the BLE test
+ * vectors, with tracing on and saves the records, as a gateway would.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "test_ble_adverts.h"
+
+static const char* const event_names[TheengsDecoder::TRACE_EVENT_COUNT] = {
+    "decode_start", "device", "data_length", "compare", "invalid_index", "property", "value", "decode_end"};
+
+static std::string modelName(TheengsDecoder& decoder, int device) {
+  if (device < 0 || device >= TheengsDecoder::BLE_ID_MAX) {
+    return "-";
+  }
+  return decoder.getTheengAttribute(device, "model_id");
+}
+
+/*
+ * @brief Renders record as one line, its time relative to the previous record.
+ */
+static std::string formatRecord(TheengsDecoder& decoder, const TheengsDecoder::TraceRecord& record, uint32_t previous) {
+  char line[256];
+  const char* event = record.event < TheengsDecoder::TRACE_EVENT_COUNT ? event_names[record.event] : "unknown";
+  int n = snprintf(line, sizeof(line), "+%8u ns %-13s ", record.time - previous, event);
+  std::string model = modelName(decoder, record.device);
+  const char* yes_no = record.result ? "yes" : "no";
+  switch (record.event) {
+    case TheengsDecoder::TRACE_DECODE_START:
+      snprintf(line + n, sizeof(line) - n, "servicedata %d chars, manufacturerdata %d chars", record.aux, record.value);
+      break;
+    case TheengsDecoder::TRACE_DEVICE:
+      snprintf(line + n, sizeof(line) - n, "%s matched %s", model.c_str(), yes_no);
+      break;
+    case TheengsDecoder::TRACE_DATA_LENGTH:
+      snprintf(line + n, sizeof(line) - n, "%s condition[%d] length %d, %d required, valid %s",
+               model.c_str(), record.condition, record.aux, record.value, yes_no);
+      break;
+    case TheengsDecoder::TRACE_COMPARE:
+      snprintf(line + n, sizeof(line) - n, "%s condition[%d] %d chars at %d, equal %s",
+               model.c_str(), record.condition, record.value, record.aux, yes_no);
+      break;
+    case TheengsDecoder::TRACE_INVALID_INDEX:
+      snprintf(line + n, sizeof(line) - n, "%s condition[%d] index %d beyond %d chars",
+               model.c_str(), record.condition, record.aux, record.value);
+      break;
+    case TheengsDecoder::TRACE_PROPERTY:
+      snprintf(line + n, sizeof(line) - n, "%s property #%d", model.c_str(), record.condition);
+      break;
+    case TheengsDecoder::TRACE_VALUE: {
+      float value;
+      memcpy(&value, &record.value, sizeof(value));
+      snprintf(line + n, sizeof(line) - n, "%s %d chars at %d = %g", model.c_str(), record.aux, record.condition, value);
+      break;
+    }
+    case TheengsDecoder::TRACE_DECODE_END:
+      if (record.device >= 0) {
+        snprintf(line + n, sizeof(line) - n, "%s in %d ns", model.c_str(), record.value);
+      } else {
+        const char* reason = TheengsDecoder::getRejectReasonName(record.result);
+        snprintf(line + n, sizeof(line) - n, "rejected %s in %d ns", reason != nullptr ? reason : "?", record.value);
+      }
+      break;
+    default:
+      snprintf(line + n, sizeof(line) - n, "device %d condition %d aux %d value %d",
+               record.device, record.condition, record.aux, record.value);
+      break;
+  }
+  return line;
+}
+
+static int capture(const char* path, const char* corpus_path) {
+  std::vector<std::string> corpus;
+  if (corpus_path != nullptr) {
+    std::ifstream in(corpus_path);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (line.find('{') != std::string::npos) {
+        corpus.push_back(line);
+      }
+    }
+  } else {
+    std::vector<Advert> adverts = testVectors();
+    for (const Advert& advert : adverts) {
+      corpus.push_back(advert.json);
+    }
+  }
+
+  FILE* out = fopen(path, "wb");
+  if (out == nullptr) {
+    std::cout << "cannot write " << path << std::endl;
+    return 1;
+  }
+  TheengsDecoder decoder;
+  decoder.setTrace(true);
+  std::vector<TheengsDecoder::TraceRecord> records(1024);
+  size_t total = 0;
+  for (const std::string& json : corpus) {
+    DynamicJsonDocument doc(json.size() * 2 + 1024);
+    if (deserializeJson(doc, json) || !doc.is<JsonObject>()) {
+      continue;
+    }
+    JsonObject object = doc.as<JsonObject>();
+    decoder.decodeBLEJson(object);
+    // drained after every advertisement, so that the ring never wraps
+    size_t count = TheengsDecoder::readTrace(records.data(), records.size());
+    fwrite(records.data(), sizeof(records[0]), count, out);
+    total += count;
+  }
+  fclose(out);
+  TheengsDecoder::releaseTrace();
+  std::cout << total << " records of " << corpus.size() << " advertisements written to " << path << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 3 && strcmp(argv[1], "--capture") == 0) {
+    return capture(argv[2], argc > 3 ? argv[3] : nullptr);
+  }
+  if (argc != 2 || argv[1][0] == '-') {
+    std::cout << "usage: " << argv[0] << " trace.bin | --capture trace.bin [corpus.jsonl]" << std::endl;
+    return 1;
+  }
+
+  FILE* in = fopen(argv[1], "rb");
+  if (in == nullptr) {
+    std::cout << "cannot read " << argv[1] << std::endl;
+    return 1;
+  }
+  TheengsDecoder decoder;
+  TheengsDecoder::TraceRecord record;
+  uint32_t previous = 0;
+  bool first = true;
+  while (fread(&record, sizeof(record), 1, in) == 1) {
+    std::cout << formatRecord(decoder, record, first ? record.time : previous) << std::endl;
+    previous = record.time;
+    first = false;
+  }
+  fclose(in);
+  return 0;
+}
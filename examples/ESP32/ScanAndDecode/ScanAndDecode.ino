@@ -10,7 +10,8 @@ NimBLEScan* pBLEScan;
 
 TheengsDecoder decoder;
 
-StaticJsonDocument<512> doc;
+// the advertisement, its service data entries and the properties decoded from each of them
+StaticJsonDocument<2048> doc;
 
 class MyAdvertisedDeviceCallbacks: public NimBLEAdvertisedDeviceCallbacks {
 
@@ -45,29 +46,48 @@ class MyAdvertisedDeviceCallbacks: public NimBLEAdvertisedDeviceCallbacks {
       BLEdata["txpower"] = (int8_t)advertisedDevice->getTXPower();
 
     if (advertisedDevice->haveServiceData()) {
+      // every service data entry is decoded on its own, the results are added to the entries
+      JsonArray serviceDataEntries = BLEdata.createNestedArray("servicedata");
       int serviceDataCount = advertisedDevice->getServiceDataCount();
       for (int j = 0; j < serviceDataCount; j++) {
+        JsonObject entry = serviceDataEntries.createNestedObject();
         std::string service_data = convertServiceData(advertisedDevice->getServiceData(j));
-        BLEdata["servicedata"] = (char*)service_data.c_str();
+        entry["servicedata"] = (char*)service_data.c_str();
         std::string serviceDatauuid = advertisedDevice->getServiceDataUUID(j).toString();
-        BLEdata["servicedatauuid"] = (char*)serviceDatauuid.c_str();
+        entry["servicedatauuid"] = (char*)serviceDatauuid.c_str();
       }
     }
 
-    if (decoder.decodeBLEJson(BLEdata)) {
-      BLEdata.remove("manufacturerdata");
-      BLEdata.remove("servicedata");
-      BLEdata.remove("servicedatauuid");
-      BLEdata.remove("type");
-      BLEdata.remove("cidc");
-      BLEdata.remove("acts");
-      BLEdata.remove("cont");
-      BLEdata.remove("track");
-      Serial.print("TheengsDecoder found device: ");
-      serializeJson(BLEdata, Serial);
-      Serial.println("");
+    if (decoder.decodeBLEJson(BLEdata) >= 0) {
+      if (doc.overflowed()) {
+        // some members were left out, the output would be incomplete
+        Serial.println("TheengsDecoder: advertisement too large for the document, skipped");
+        return;
+      }
+      for (JsonObject entry : BLEdata["servicedata"].as<JsonArray>()) {
+        if (entry.containsKey("model_id")) {
+          printDevice(entry);
+        }
+      }
+      if (BLEdata.containsKey("model_id")) {
+        printDevice(BLEdata);
+      }
     }
   }
+
+  void printDevice(JsonObject device) {
+    device.remove("manufacturerdata");
+    device.remove("servicedata");
+    device.remove("servicedatauuid");
+    device.remove("type");
+    device.remove("cidc");
+    device.remove("acts");
+    device.remove("cont");
+    device.remove("track");
+    Serial.print("TheengsDecoder found device: ");
+    serializeJson(device, Serial);
+    Serial.println("");
+  }
 };
 
 void setup() {
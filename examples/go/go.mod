@@ -0,0 +1,3 @@
+module github.com/theengs/decoder/examples/go
+
+go 1.18
@@ -0,0 +1,153 @@
+// Package theengs decodes BLE advertisements with the Theengs decoder
+// library, crossing into C once per batch of advertisements.
+package theengs
+
+// #cgo CFLAGS: -I${SRCDIR}/../../../include
+// #cgo LDFLAGS: -L${SRCDIR}/../../../build -ldecoder -lstdc++
+// #include <stdlib.h>
+// #include "shared/theengs.h"
+import "C"
+
+import (
+	"unsafe"
+)
+
+// Result is the outcome of decoding one advertisement of a batch.
+type Result struct {
+	// Model is the decoded model index, -1 if the advertisement was not decoded.
+	Model int
+	// JSON is the advertisement followed by its decoded properties, nil if
+	// not decoded. It points into the decoder's output arena and is only
+	// valid until the next call on the decoder.
+	JSON []byte
+}
+
+// Decoder holds a native decoder and the arenas reused by its calls.
+// It must not be used by several goroutines at the same time.
+type Decoder struct {
+	ptr     unsafe.Pointer
+	out     []byte
+	input   []byte
+	lens    []C.size_t
+	arena   []byte
+	results []C.Theengs_Result
+	batch   []Result
+}
+
+// NewDecoder creates a decoder, to be released with Close.
+func NewDecoder() *Decoder {
+	return &Decoder{
+		ptr: C.Theengs_NewDecoder(),
+		out: make([]byte, 1024),
+	}
+}
+
+// Close releases the native decoder.
+func (d *Decoder) Close() {
+	if d.ptr != nil {
+		C.Theengs_DestroyDecoder(d.ptr)
+		d.ptr = nil
+	}
+}
+
+func bytePtr(b []byte) *C.char {
+	if len(b) == 0 {
+		return nil
+	}
+	return (*C.char)(unsafe.Pointer(&b[0]))
+}
+
+// DecodeBLE decodes one advertisement JSON object, returning the
+// advertisement followed by its decoded properties, or false if it is not
+// recognized.
+func (d *Decoder) DecodeBLE(advert string) (string, bool) {
+	results := d.DecodeBatch([]string{advert})
+	if results[0].JSON == nil {
+		return "", false
+	}
+	return string(results[0].JSON), true
+}
+
+// DecodeBLEString is DecodeBLE through the string returning C function,
+// allocating the input and output copies for each call.
+func (d *Decoder) DecodeBLEString(advert string) string {
+	cs_data := C.CString(advert)
+	defer C.free(unsafe.Pointer(cs_data))
+	cs_result := C.Theengs_DecodeBLE(d.ptr, cs_data)
+	if cs_result == nil {
+		return ""
+	}
+	defer C.Theengs_FreeString(cs_result)
+	return C.GoString(cs_result)
+}
+
+// DecodeBatch decodes advertisement JSON objects in a single call into the
+// library. The inputs are laid out in an arena owned by the decoder and the
+// outputs written into another, both reused and grown as needed. The
+// returned slice and the JSON it points to are valid until the next call.
+func (d *Decoder) DecodeBatch(adverts []string) []Result {
+	count := len(adverts)
+	d.input = d.input[:0]
+	d.lens = d.lens[:0]
+	for _, advert := range adverts {
+		d.input = append(d.input, advert...)
+		d.lens = append(d.lens, C.size_t(len(advert)))
+	}
+	if cap(d.results) < count {
+		d.results = make([]C.Theengs_Result, count)
+		d.batch = make([]Result, count)
+	}
+	d.results = d.results[:count]
+	d.batch = d.batch[:count]
+	if count == 0 {
+		return d.batch
+	}
+	if needed := len(d.input) + 512*count; len(d.arena) < needed {
+		d.arena = make([]byte, needed)
+	}
+
+	for {
+		var used C.size_t
+		status := C.Theengs_DecodeBLEBatch(d.ptr, bytePtr(d.input), &d.lens[0], C.size_t(count),
+			bytePtr(d.arena), C.size_t(len(d.arena)), &d.results[0], &used)
+		if status != C.THEENGS_BUFFER_TOO_SMALL {
+			break
+		}
+		// grow the arena to hold every output and decode the batch again
+		needed := 0
+		for _, result := range d.results {
+			if result.status == C.THEENGS_OK || result.status == C.THEENGS_BUFFER_TOO_SMALL {
+				needed += int(result.length) + 1
+			}
+		}
+		d.arena = make([]byte, needed)
+	}
+
+	for i, result := range d.results {
+		d.batch[i] = Result{Model: int(result.model)}
+		if result.status == C.THEENGS_OK {
+			d.batch[i].JSON = d.arena[result.offset : result.offset+result.length]
+		}
+	}
+	return d.batch
+}
+
+// GetProperties returns the properties JSON of a model ID.
+func (d *Decoder) GetProperties(model_id string) string {
+	cs_model := C.CString(model_id)
+	defer C.free(unsafe.Pointer(cs_model))
+	cs_result := C.Theengs_GetProperties(d.ptr, cs_model)
+	defer C.Theengs_FreeString(cs_result)
+	return C.GoString(cs_result)
+}
+
+// GetAttribute returns the named attribute of a model ID.
+func (d *Decoder) GetAttribute(model_id string, attribute string) string {
+	cs_model := C.CString(model_id)
+	cs_attr := C.CString(attribute)
+	defer C.free(unsafe.Pointer(cs_model))
+	defer C.free(unsafe.Pointer(cs_attr))
+	cs_result := C.Theengs_GetAttribute(d.ptr, cs_model, cs_attr)
+	defer C.Theengs_FreeString(cs_result)
+	return C.GoString(cs_result)
+}
@@ -0,0 +1,91 @@
+package theengs
+
+import (
+	"encoding/json"
+	"testing"
+)
+
+var adverts = []string{
+	`{"id":"AA:BB:CC:DD:EE:FF","name":"LYWSD02","rssi":-67,"servicedata":"70205b043941e480012ee7090a10012500","servicedatauuid":"0xfe95"}`,
+	`{"id":"AA:BB:CC:DD:EE:FF","servicedata":"712098004a63b6658d7cc40d071003f32600","servicedatauuid":"fe95"}`,
+	`{"name":"sps","manufacturerdata":"660a03150110805908","rssi":-70}`,
+	`{"id":"AA:BB:CC:DD:EE:FF","servicedata":"123456789abcdef","servicedatauuid":"fa11"}`,
+}
+
+var expected = []string{"LYWSD02", "HHCCJCY01HHCC", "IBS-TH1/TH2/P01B/ITH-12S", ""}
+
+func modelID(t *testing.T, data []byte) string {
+	var decoded map[string]interface{}
+	if err := json.Unmarshal(data, &decoded); err != nil {
+		t.Fatalf("invalid output %s: %v", data, err)
+	}
+	model_id, _ := decoded["model_id"].(string)
+	return model_id
+}
+
+func TestDecodeBatch(t *testing.T) {
+	d := NewDecoder()
+	defer d.Close()
+
+	// a small arena is grown
+	d.arena = make([]byte, 16)
+	for round := 0; round < 2; round++ {
+		results := d.DecodeBatch(adverts)
+		for i, result := range results {
+			if expected[i] == "" {
+				if result.Model != -1 || result.JSON != nil {
+					t.Errorf("advert %d decoded, not expected", i)
+				}
+				continue
+			}
+			if got := modelID(t, result.JSON); got != expected[i] {
+				t.Errorf("advert %d decoded as %q, %q expected", i, got, expected[i])
+			}
+			if string(result.JSON) != d.DecodeBLEString(adverts[i]) {
+				t.Errorf("advert %d batch output differs from DecodeBLEString", i)
+			}
+		}
+	}
+
+	if _, ok := d.DecodeBLE(adverts[3]); ok {
+		t.Errorf("unknown advert decoded")
+	}
+	if out, ok := d.DecodeBLE(adverts[0]); !ok || modelID(t, []byte(out)) != expected[0] {
+		t.Errorf("DecodeBLE returned %q", out)
+	}
+}
+
+func batchOf(size int) []string {
+	batch := make([]string, size)
+	for i := range batch {
+		batch[i] = adverts[i%len(adverts)]
+	}
+	return batch
+}
+
+// BenchmarkDecodeBLEString is the per advertisement cost with one cgo call
+// and a C string allocated and freed for each input and result.
+func BenchmarkDecodeBLEString(b *testing.B) {
+	d := NewDecoder()
+	defer d.Close()
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		d.DecodeBLEString(adverts[i%len(adverts)])
+	}
+}
+
+// BenchmarkDecodeBatch is the per advertisement cost in batches of 256
+// decoded by one cgo call into reused arenas.
+func BenchmarkDecodeBatch(b *testing.B) {
+	d := NewDecoder()
+	defer d.Close()
+	batch := batchOf(256)
+	b.ReportAllocs()
+	for i := 0; i < b.N; i += len(batch) {
+		n := len(batch)
+		if b.N-i < n {
+			n = b.N - i
+		}
+		d.DecodeBatch(batch[:n])
+	}
+}
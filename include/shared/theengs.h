@@ -22,15 +22,162 @@
 #ifndef _THEENGS_H_
 #define _THEENGS_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*
+ * A decoder handle is created by Theengs_NewDecoder and released by
+ * Theengs_DestroyDecoder. It owns the buffers reused by the decode calls
+ * and must not be used by two threads at the same time.
+ */
 void* Theengs_NewDecoder();
 void Theengs_DestroyDecoder(void* decoder);
+
+/*
+ * The strings returned by the functions below are allocated by the library
+ * and must be released with Theengs_FreeString. Theengs_DecodeBLE returns
+ * NULL when the advertisement is not decoded.
+ */
 const char* Theengs_DecodeBLE(void* decoder, const char* json_data);
 const char* Theengs_GetProperties(void* decoder, const char* model_id);
 const char* Theengs_GetAttribute(void* decoder, const char* model_id, const char* attribute);
+void Theengs_FreeString(const char* str);
+
+typedef enum {
+  THEENGS_OK = 0,
+  THEENGS_NO_MATCH = 1, // no device recognized, nothing written
+  THEENGS_BUFFER_TOO_SMALL = 2, // nothing written, the length needed is reported
+  THEENGS_INVALID_INPUT = 3, // the input is not a JSON object
+  THEENGS_INVALID_ARGUMENT = 4
+} Theengs_Status;
+
+/*
+ * Decodes the advertisement JSON object json_data into out_buf, written as
+ * the input followed by the decoded members and null terminated.
+ * *out_len receives the length of the output without its null terminator,
+ * also when THEENGS_BUFFER_TOO_SMALL is returned so that the call can be
+ * retried with out_cap > *out_len, and 0 with any other status, when
+ * out_len is not NULL. The library allocates nothing the caller has to
+ * release.
+ */
+Theengs_Status Theengs_DecodeBLEInto(void* decoder, const char* json_data,
+                                     char* out_buf, size_t out_cap, size_t* out_len);
+
+/* Outcome of one advertisement of a batch */
+typedef struct {
+  int32_t status; // Theengs_Status
+  int32_t model; // decoded model index, -1 if not decoded
+  size_t offset; // offset of the null terminated output in the arena
+  size_t length; // length of the output, or needed for THEENGS_BUFFER_TOO_SMALL
+} Theengs_Result;
+
+/*
+ * Decodes count advertisement JSON objects laid out back to back in inputs,
+ * input_lens giving their lengths, into results[count]. The outputs are
+ * written one after the other into arena; an output not fitting in what
+ * remains of it is reported THEENGS_BUFFER_TOO_SMALL and the following ones
+ * are still decoded. Returns THEENGS_BUFFER_TOO_SMALL if any output did not
+ * fit, THEENGS_OK otherwise; *arena_used receives the bytes written.
+ */
+Theengs_Status Theengs_DecodeBLEBatch(void* decoder, const char* inputs, const size_t* input_lens,
+                                      size_t count, char* arena, size_t arena_cap,
+                                      Theengs_Result* results, size_t* arena_used);
+
+/*
+ * An advertisement as received from the radio, the data fields as raw bytes.
+ * Absent fields are NULL, with a zero length for the byte arrays.
+ */
+typedef struct {
+  const char* id; // MAC address, "AA:BB:CC:DD:EE:FF"
+  const char* name;
+  const char* servicedatauuid; // "0xfe95"
+  const uint8_t* servicedata;
+  size_t servicedata_len;
+  const uint8_t* manufacturerdata;
+  size_t manufacturerdata_len;
+} Theengs_Advert;
+
+/*
+ * Same as Theengs_DecodeBLEInto and Theengs_DecodeBLEBatch for raw
+ * advertisements, the output holding only the decoded members.
+ */
+Theengs_Status Theengs_DecodeBLERawInto(void* decoder, const Theengs_Advert* advert,
+                                        char* out_buf, size_t out_cap, size_t* out_len);
+Theengs_Status Theengs_DecodeBLERawBatch(void* decoder, const Theengs_Advert* adverts, size_t count,
+                                         char* arena, size_t arena_cap,
+                                         Theengs_Result* results, size_t* arena_used);
+
+/* Tags of a catalog model, set in Theengs_Model.flags */
+#define THEENGS_FLAG_CIDC 0x01 // not Company ID compliant
+#define THEENGS_FLAG_ACTS 0x02 // active scanning required
+#define THEENGS_FLAG_CONT 0x04 // continuous scanning required
+#define THEENGS_FLAG_TRACK 0x08 // discoverable as device tracker
+#define THEENGS_FLAG_PRMAC 0x10 // potential random MAC address device
+
+/* A decoded property of a catalog model */
+typedef struct {
+  const char* key;
+  const char* unit;
+  const char* name;
+} Theengs_Property;
+
+/* A model of the device catalog with its property metadata */
+typedef struct {
+  int32_t index; // model index, as reported in Theengs_Result.model
+  const char* model_id;
+  const char* brand;
+  const char* model;
+  const char* tag;
+  const char* type; // NULL if the tag has no known type
+  uint32_t flags; // THEENGS_FLAG_* bits
+  int32_t encr; // encryption mode, 0 if none
+  const Theengs_Property* properties;
+  size_t property_count;
+} Theengs_Model;
+
+/*
+ * Returns all the models of the catalog, *count receiving their number.
+ * The array is built on the first call and owned by the library; it is
+ * never released and remains valid after the decoder is destroyed.
+ */
+const Theengs_Model* Theengs_GetCatalog(void* decoder, size_t* count);
+
+/* Why an advertisement was not decoded, indexes of Theengs_Stats.reject_reasons */
+typedef enum {
+  THEENGS_REJECT_NO_DATA = 0, // no service data, manufacturer data or name
+  THEENGS_REJECT_TOO_SHORT = 1, // its data is shorter than the minimum lengths
+  THEENGS_REJECT_INVALID_INDEX = 2, // a model condition compared beyond the end of its data
+  THEENGS_REJECT_CATALOG_ERROR = 3, // a catalog entry could not be parsed
+  THEENGS_REJECT_NO_PROPERTIES = 4, // a model matched but none of its properties decoded
+  THEENGS_REJECT_NO_MATCH = 5, // no model matched
+  THEENGS_REJECT_TOO_MANY_ENTRIES = 6, // none of the first service data entries decoded, the others left out
+  THEENGS_REJECT_REASON_COUNT = 7
+} Theengs_RejectReason;
+
+#define THEENGS_LATENCY_BUCKETS 20
+
+/* Counters of the decodes of all the decoders of the process */
+typedef struct {
+  uint64_t adverts;
+  uint64_t matches;
+  uint64_t rejects;
+  uint64_t reject_reasons[THEENGS_REJECT_REASON_COUNT];
+  uint64_t truncated; // advertisements with service data entries beyond the decoded ones, left out
+  uint64_t latency[THEENGS_LATENCY_BUCKETS]; // decodes taking less than 512 << i ns, the last bucket any longer
+  uint64_t latency_sum_us; // time spent in all the decodes, in microseconds
+} Theengs_Stats;
+
+/*
+ * Copies the counters into stats and the matches of each model, indexed by
+ * model index, into model_matches[model_cap] (which may be NULL with a zero
+ * model_cap). With reset non zero the counters are reset as they are read.
+ * Returns the number of models. Safe to call while other threads decode.
+ */
+size_t Theengs_GetStats(Theengs_Stats* stats, uint64_t* model_matches, size_t model_cap, int reset);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -1,3 +1,38 @@
+import functools
+
+from ._decoder import Decoder  # noqa: F401
 from ._decoder import decodeBLE  # noqa: F401
 from ._decoder import getAttribute  # noqa: F401
-from ._decoder import getProperties  # noqa: F401
\ No newline at end of file
+from ._decoder import getProperties  # noqa: F401
+from ._decoder import getStats  # noqa: F401
+from ._decoder import decode_many  # noqa: F401
+
+
+@functools.lru_cache(maxsize=None)
+def getCatalog():
+    """Returns a tuple describing every model of the device catalog.
+
+    Each model is a dict holding its index, model_id, brand, model, tag,
+    type, flags (the names of its tags), encr and properties, the latter
+    mapping each property key to its unit and name. The tuple is built on
+    the first call and shared by the following ones, do not modify it.
+    """
+    from ._decoder import _get_catalog
+
+    return _get_catalog()
+
+
+def decode_columns(properties, threads=1, **payloads):
+    """Decodes columns of advertisement fields into NumPy arrays.
+
+    The id, name, servicedata, servicedatauuid and manufacturerdata keyword
+    arguments are sequences of the same length holding strings, bytes or
+    None. Returns a dict holding the "model" index array, -1 where not
+    decoded, and a float array per requested property, NaN where absent.
+    """
+    import numpy
+
+    from ._decoder import _decode_columns
+
+    columns = _decode_columns(properties, threads=threads, **payloads)
+    return {name: numpy.asarray(column) for name, column in columns.items()}
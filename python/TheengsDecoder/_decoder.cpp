@@ -2,9 +2,22 @@
 #include <Python.h>
 
 #include "decoder.h"
+#include "json_scanner.h"
 
 // STD includes
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 //-----------------------------------------------------------------------------
 static PyObject *decode_BLE(PyObject *self, PyObject *args)
@@ -14,18 +27,11 @@ static PyObject *decode_BLE(PyObject *self, PyObject *args)
   if (!PyArg_ParseTuple(args, "s", &strArg))
     return NULL;
 
-  StaticJsonDocument<1024> doc;
-  DeserializationError err = deserializeJson(doc, strArg);
-  if (!err) {
-    TheengsDecoder decoder;
-    JsonObject bleObject;
-    bleObject = doc.as<JsonObject>();
-
-    if (decoder.decodeBLEJson(bleObject) >= 0) {
-      std::string buf;
-      serializeJson(bleObject, buf);
-      return Py_BuildValue("s", buf.c_str());
-    }
+  TheengsDecoder decoder;
+  DynamicJsonDocument devices(decoder.getDocMax());
+  std::string buf;
+  if (decodeBLEJsonText(decoder, devices, strArg, buf) >= 0) {
+    return Py_BuildValue("s", buf.c_str());
   }
 
   Py_RETURN_NONE;
@@ -46,6 +52,122 @@ static PyObject *decode_getTheengProperties(PyObject *self, PyObject *args)
   Py_RETURN_NONE;
 }
 
+static const char* const tag_flag_names[] = {"cidc", "acts", "cont", "track", "prmac"};
+
+static PyObject *catalogModel(const TheengsDecoder::CatalogEntry& entry)
+{
+  PyObject *flags = PyList_New(0);
+  PyObject *properties = PyDict_New();
+  if (flags == NULL || properties == NULL) {
+    Py_XDECREF(flags);
+    Py_XDECREF(properties);
+    return NULL;
+  }
+
+  bool failed = false;
+  for (size_t i = 0; i < sizeof(tag_flag_names) / sizeof(tag_flag_names[0]) && !failed; i++) {
+    if (entry.flags & (1 << i)) {
+      PyObject *name = Py_BuildValue("s", tag_flag_names[i]);
+      failed = name == NULL || PyList_Append(flags, name) < 0;
+      Py_XDECREF(name);
+    }
+  }
+  for (size_t i = 0; i < entry.property_count && !failed; i++) {
+    const TheengsDecoder::CatalogProperty& prop = entry.properties[i];
+    PyObject *meta = Py_BuildValue("{s:s,s:s}", "unit", prop.unit, "name", prop.name);
+    failed = meta == NULL || PyDict_SetItemString(properties, prop.key, meta) < 0;
+    Py_XDECREF(meta);
+  }
+
+  PyObject *model = NULL;
+  if (!failed) {
+    model = Py_BuildValue("{s:i,s:s,s:s,s:s,s:s,s:z,s:O,s:i,s:O}",
+                          "index", entry.index, "model_id", entry.model_id,
+                          "brand", entry.brand, "model", entry.model, "tag", entry.tag,
+                          "type", entry.type, "flags", flags, "encr", entry.encr,
+                          "properties", properties);
+  }
+  Py_DECREF(flags);
+  Py_DECREF(properties);
+  return model;
+}
+
+static PyObject *decode_getCatalog(PyObject *self, PyObject *args)
+{
+  TheengsDecoder decoder;
+  size_t count;
+  const TheengsDecoder::CatalogEntry* entries = decoder.getCatalog(&count);
+
+  PyObject *catalog = PyTuple_New(count);
+  if (catalog == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    PyObject *model = catalogModel(entries[i]);
+    if (model == NULL) {
+      Py_DECREF(catalog);
+      return NULL;
+    }
+    PyTuple_SET_ITEM(catalog, i, model);
+  }
+  return catalog;
+}
+
+static bool setCount(PyObject *dict, PyObject *key, uint64_t count)
+{
+  PyObject *value = PyLong_FromUnsignedLongLong(count);
+  bool failed = key == NULL || value == NULL || PyDict_SetItem(dict, key, value) < 0;
+  Py_XDECREF(key);
+  Py_XDECREF(value);
+  return !failed;
+}
+
+static PyObject *decode_getStats(PyObject *self, PyObject *args, PyObject *kwds)
+{
+  static const char* kwlist[] = {"reset", NULL};
+  int reset = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", const_cast<char**>(kwlist), &reset))
+    return NULL;
+
+  TheengsDecoder::Stats stats;
+  TheengsDecoder::getStats(stats, reset != 0);
+
+  PyObject *reasons = PyDict_New();
+  PyObject *models = PyDict_New();
+  PyObject *latency = PyList_New(TheengsDecoder::STATS_LATENCY_BUCKETS);
+  bool failed = reasons == NULL || models == NULL || latency == NULL;
+  for (int i = 0; i < TheengsDecoder::REJECT_REASON_COUNT && !failed; i++) {
+    failed = !setCount(reasons, Py_BuildValue("s", TheengsDecoder::getRejectReasonName(i)), stats.reject_reasons[i]);
+  }
+  for (int i = 0; i < TheengsDecoder::BLE_ID_MAX && !failed; i++) {
+    if (stats.model_matches[i] != 0) {
+      failed = !setCount(models, PyLong_FromLong(i), stats.model_matches[i]);
+    }
+  }
+  for (int i = 0; i < TheengsDecoder::STATS_LATENCY_BUCKETS && !failed; i++) {
+    PyObject *count = PyLong_FromUnsignedLongLong(stats.latency[i]);
+    failed = count == NULL;
+    if (!failed) {
+      PyList_SET_ITEM(latency, i, count);
+    }
+  }
+
+  PyObject *result = NULL;
+  if (!failed) {
+    result = Py_BuildValue("{s:K,s:K,s:K,s:K,s:O,s:O,s:O,s:K}",
+                           "adverts", (unsigned long long)stats.adverts,
+                           "matches", (unsigned long long)stats.matches,
+                           "rejects", (unsigned long long)stats.rejects,
+                           "truncated", (unsigned long long)stats.truncated,
+                           "reject_reasons", reasons, "models", models, "latency", latency,
+                           "latency_sum_us", (unsigned long long)stats.latency_sum_us);
+  }
+  Py_XDECREF(reasons);
+  Py_XDECREF(models);
+  Py_XDECREF(latency);
+  return result;
+}
+
 static PyObject *decode_getTheengAttribute(PyObject *self, PyObject *args)
 {
   const char *model;
@@ -62,6 +184,962 @@ static PyObject *decode_getTheengAttribute(PyObject *self, PyObject *args)
   Py_RETURN_NONE;
 }
 
+#if PY_VERSION_HEX >= 0x03070000
+//-----------------------------------------------------------------------------
+// Decoder type, holding one native decoder and the buffers reused by its calls
+
+enum AdvertField {
+  FIELD_ID,
+  FIELD_NAME,
+  FIELD_SERVICEDATA,
+  FIELD_SERVICEDATAUUID,
+  FIELD_MANUFACTURERDATA,
+  FIELD_COUNT
+};
+
+static const char* const field_names[FIELD_COUNT] = {"id", "name", "servicedata", "servicedatauuid", "manufacturerdata"};
+static PyObject* field_keys[FIELD_COUNT];
+
+struct DecoderState {
+  TheengsDecoder decoder;
+  DynamicJsonDocument devices; // device definitions while matching
+  StaticJsonDocument<DECODED_DOC_SIZE> decoded;
+  std::string hex; // bytes payloads converted to hexadecimal
+
+  DecoderState() : devices(decoder.getDocMax()) {}
+};
+
+typedef struct {
+  PyObject_HEAD
+  DecoderState* state;
+} DecoderObject;
+
+static PyObject* toPython(JsonVariant value);
+
+static bool isField(const char* key) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (strcmp(key, field_names[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Sets the members of obj into dict, except the advertisement fields if skip_fields.
+ */
+static bool updateDict(PyObject* dict, JsonObject obj, bool skip_fields)
+{
+  for (JsonPair kv : obj) {
+    if (skip_fields && isField(kv.key().c_str())) {
+      continue;
+    }
+    PyObject* value = toPython(kv.value());
+    if (value == NULL) {
+      return false;
+    }
+    int res = PyDict_SetItemString(dict, kv.key().c_str(), value);
+    Py_DECREF(value);
+    if (res < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static PyObject* toPython(JsonVariant value)
+{
+  if (value.is<bool>()) {
+    return PyBool_FromLong(value.as<bool>());
+  }
+  if (value.is<long long>()) {
+    return PyLong_FromLongLong(value.as<long long>());
+  }
+  if (value.is<double>()) {
+    return PyFloat_FromDouble(value.as<double>());
+  }
+  if (value.is<const char*>()) {
+    return PyUnicode_FromString(value.as<const char*>());
+  }
+  if (value.is<JsonArray>()) {
+    JsonArray array = value.as<JsonArray>();
+    PyObject* list = PyList_New(array.size());
+    if (list == NULL) {
+      return NULL;
+    }
+    Py_ssize_t i = 0;
+    for (JsonVariant element : array) {
+      PyObject* item = toPython(element);
+      if (item == NULL) {
+        Py_DECREF(list);
+        return NULL;
+      }
+      PyList_SET_ITEM(list, i++, item);
+    }
+    return list;
+  }
+  if (value.is<JsonObject>()) {
+    PyObject* dict = PyDict_New();
+    if (dict != NULL && !updateDict(dict, value.as<JsonObject>(), false)) {
+      Py_CLEAR(dict);
+    }
+    return dict;
+  }
+  double number; // a raw number of the fixed-point mode
+  if (TheengsDecoder::readNumber(value, &number)) {
+    return PyFloat_FromDouble(number);
+  }
+  Py_RETURN_NONE;
+}
+
+static size_t hexLength(PyObject* value)
+{
+  if (value != NULL && PyBytes_Check(value)) {
+    return PyBytes_GET_SIZE(value) * 2 + 1;
+  }
+  if (value != NULL && PyByteArray_Check(value)) {
+    return PyByteArray_GET_SIZE(value) * 2 + 1;
+  }
+  return 0;
+}
+
+/*
+ * Points *out to the string value, or to its bytes converted to hexadecimal
+ * at hex; nullptr for the other types. Returns false with an exception set
+ * on error.
+ */
+static bool fieldString(PyObject* value, char*& hex, const char** out)
+{
+  static const char digits[] = "0123456789abcdef";
+  const char* data;
+  Py_ssize_t len;
+
+  *out = nullptr;
+  if (value == NULL) {
+    return true;
+  }
+  if (PyUnicode_Check(value)) {
+    *out = PyUnicode_AsUTF8(value);
+    return *out != nullptr;
+  }
+  if (PyBytes_Check(value)) {
+    data = PyBytes_AS_STRING(value);
+    len = PyBytes_GET_SIZE(value);
+  } else if (PyByteArray_Check(value)) {
+    data = PyByteArray_AS_STRING(value);
+    len = PyByteArray_GET_SIZE(value);
+  } else {
+    return true;
+  }
+
+  *out = hex;
+  for (Py_ssize_t i = 0; i < len; i++) {
+    unsigned char byte = static_cast<unsigned char>(data[i]);
+    *hex++ = digits[byte >> 4];
+    *hex++ = digits[byte & 0x0f];
+  }
+  *hex++ = '\0';
+  return true;
+}
+
+/*
+ * Returns a new reference to dict[key], NULL if absent or on error.
+ */
+static PyObject* getField(PyObject* dict, PyObject* key)
+{
+#if PY_VERSION_HEX >= 0x030D0000
+  PyObject* value;
+  PyDict_GetItemRef(dict, key, &value);
+  return value;
+#else
+  PyObject* value = PyDict_GetItemWithError(dict, key);
+  Py_XINCREF(value);
+  return value;
+#endif
+}
+
+/*
+ * Stores new references to the advertisement fields of advert into items.
+ * Returns false with an exception set on error.
+ */
+static bool getFields(PyObject* advert, PyObject** items)
+{
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    items[i] = getField(advert, field_keys[i]);
+    if (items[i] == NULL && PyErr_Occurred()) {
+      for (int j = 0; j < i; j++) {
+        Py_XDECREF(items[j]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+static void releaseFields(PyObject** items)
+{
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    Py_CLEAR(items[i]);
+  }
+}
+
+static bool hasEntries(PyObject** items)
+{
+  return items[FIELD_SERVICEDATA] != NULL && PyList_Check(items[FIELD_SERVICEDATA]);
+}
+
+/*
+ * Decodes an advertisement whose servicedata is a list of entries, the
+ * entries of the result being copies of the input ones with their decoded
+ * members.
+ */
+static PyObject* decodeEntries(DecoderState* state, PyObject* advert, const char* const* values, PyObject* list)
+{
+  PyObject* entries = PySequence_Fast(list, "servicedata must be a list");
+  if (entries == NULL) {
+    return NULL;
+  }
+  Py_ssize_t count = PySequence_Fast_GET_SIZE(entries);
+  DynamicJsonDocument doc(DECODED_DOC_SIZE * (count + 1));
+  std::vector<PyObject*> items(count * 2, NULL);
+  std::string hex;
+  size_t hex_len = 0;
+  PyObject* result = NULL;
+  PyObject* decoded_entries = NULL;
+
+  for (Py_ssize_t i = 0; i < count; i++) {
+    PyObject* entry = PySequence_Fast_GET_ITEM(entries, i);
+    if (PyDict_Check(entry)) {
+      for (int field = 0; field < 2; field++) {
+        PyObject* item = getField(entry, field_keys[FIELD_SERVICEDATA + field]);
+        if (item == NULL && PyErr_Occurred()) {
+          goto error;
+        }
+        items[i * 2 + field] = item;
+        hex_len += hexLength(item);
+      }
+    }
+  }
+  hex.resize(hex_len);
+
+  {
+    char* hex_pos = &hex[0];
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      if (values[i] != nullptr) {
+        doc[field_names[i]] = values[i];
+      }
+    }
+    JsonArray array = doc.createNestedArray(field_names[FIELD_SERVICEDATA]);
+    for (Py_ssize_t i = 0; i < count; i++) {
+      JsonObject entry_obj = array.createNestedObject();
+      for (int field = 0; field < 2; field++) {
+        const char* value;
+        if (!fieldString(items[i * 2 + field], hex_pos, &value)) {
+          goto error;
+        }
+        if (value != nullptr) {
+          entry_obj[field_names[FIELD_SERVICEDATA + field]] = value;
+        }
+      }
+    }
+
+    JsonObject bleObject = doc.as<JsonObject>();
+    if (state->decoder.decodeBLEJson(bleObject) < 0) {
+      result = Py_None;
+      Py_INCREF(result);
+      goto done;
+    }
+
+    result = PyDict_Copy(advert);
+    decoded_entries = PyList_New(count);
+    if (result == NULL || decoded_entries == NULL || !updateDict(result, bleObject, true)) {
+      goto error;
+    }
+    for (Py_ssize_t i = 0; i < count; i++) {
+      PyObject* entry = PySequence_Fast_GET_ITEM(entries, i);
+      PyObject* decoded_entry;
+      if (PyDict_Check(entry)) {
+        decoded_entry = PyDict_Copy(entry);
+        if (decoded_entry == NULL) {
+          goto error;
+        }
+        PyList_SET_ITEM(decoded_entries, i, decoded_entry);
+        if (!updateDict(decoded_entry, array[i].as<JsonObject>(), true)) {
+          goto error;
+        }
+      } else {
+        Py_INCREF(entry);
+        PyList_SET_ITEM(decoded_entries, i, entry);
+      }
+    }
+    if (PyDict_SetItem(result, field_keys[FIELD_SERVICEDATA], decoded_entries) < 0) {
+      goto error;
+    }
+    goto done;
+  }
+
+error:
+  Py_CLEAR(result);
+done:
+  Py_XDECREF(decoded_entries);
+  for (size_t i = 0; i < items.size(); i++) {
+    Py_XDECREF(items[i]);
+  }
+  Py_DECREF(entries);
+  return result;
+}
+
+/*
+ * Returns a copy of the advertisement dict with its decoded members, None if
+ * not decoded.
+ */
+static PyObject* decodeAdvert(DecoderState* state, PyObject* advert)
+{
+  PyObject* items[FIELD_COUNT];
+  if (!getFields(advert, items)) {
+    return NULL;
+  }
+
+  // the bytes payloads are converted into one buffer sized beforehand
+  size_t hex_len = 0;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    hex_len += hexLength(items[i]);
+  }
+  state->hex.resize(hex_len);
+  char* hex = &state->hex[0];
+
+  PyObject* result = NULL;
+  const char* values[FIELD_COUNT];
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (!fieldString(items[i], hex, &values[i])) {
+      releaseFields(items);
+      return NULL;
+    }
+  }
+
+  if (hasEntries(items)) {
+    result = decodeEntries(state, advert, values, items[FIELD_SERVICEDATA]);
+  } else {
+    JsonObject decoded = state->decoded.to<JsonObject>();
+    if (state->decoder.decodeBLE(state->devices, decoded, values[FIELD_SERVICEDATA], values[FIELD_MANUFACTURERDATA],
+                                 values[FIELD_NAME], values[FIELD_SERVICEDATAUUID], values[FIELD_ID]) < 0) {
+      result = Py_None;
+      Py_INCREF(result);
+    } else {
+      result = PyDict_Copy(advert);
+      if (result != NULL && !updateDict(result, decoded, false)) {
+        Py_CLEAR(result);
+      }
+    }
+  }
+
+  releaseFields(items);
+  return result;
+}
+
+/*
+ * The methods of a Decoder use its buffers, free-threaded builds serialize
+ * them on the object.
+ */
+#if PY_VERSION_HEX >= 0x030D0000
+#  define DECODER_LOCK(self) Py_BEGIN_CRITICAL_SECTION(self)
+#  define DECODER_UNLOCK() Py_END_CRITICAL_SECTION()
+#else
+#  define DECODER_LOCK(self) {
+#  define DECODER_UNLOCK() }
+#endif
+
+static PyObject *Decoder_decodeBLE(DecoderObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  if (nargs != 1 || !PyDict_Check(args[0])) {
+    PyErr_SetString(PyExc_TypeError, "decodeBLE() expects an advertisement dict");
+    return NULL;
+  }
+
+  PyObject* result;
+  DECODER_LOCK(self);
+  result = decodeAdvert(self->state, args[0]);
+  DECODER_UNLOCK();
+  return result;
+}
+
+static PyObject *Decoder_getProperties(DecoderObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  const char* model_id;
+  if (nargs != 1 || !PyUnicode_Check(args[0])) {
+    PyErr_SetString(PyExc_TypeError, "getProperties() expects a model_id string");
+    return NULL;
+  }
+  if ((model_id = PyUnicode_AsUTF8(args[0])) == NULL) {
+    return NULL;
+  }
+
+  PyObject* result = NULL;
+  DECODER_LOCK(self);
+  DecoderState* state = self->state;
+  std::string prop = state->decoder.getTheengProperties(model_id);
+  if (prop.empty() || deserializeJson(state->devices, prop)) {
+    result = Py_None;
+    Py_INCREF(result);
+  } else {
+    result = toPython(state->devices.as<JsonVariant>());
+  }
+  DECODER_UNLOCK();
+  return result;
+}
+
+static PyObject *Decoder_getAttribute(DecoderObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+  const char* model_id;
+  const char* attribute;
+  if (nargs != 2 || !PyUnicode_Check(args[0]) || !PyUnicode_Check(args[1])) {
+    PyErr_SetString(PyExc_TypeError, "getAttribute() expects model_id and attribute strings");
+    return NULL;
+  }
+  if ((model_id = PyUnicode_AsUTF8(args[0])) == NULL || (attribute = PyUnicode_AsUTF8(args[1])) == NULL) {
+    return NULL;
+  }
+
+  std::string prop = self->state->decoder.getTheengAttribute(model_id, attribute);
+  if (!prop.empty()) {
+    return PyUnicode_FromStringAndSize(prop.data(), prop.size());
+  }
+
+  Py_RETURN_NONE;
+}
+
+//-----------------------------------------------------------------------------
+// Batch decoding, the native part running without the GIL
+
+struct BatchItem {
+  PyObject* advert; // borrowed from the batch sequence
+  PyObject* items[FIELD_COUNT];
+  const char* values[FIELD_COUNT];
+  bool entries; // servicedata is a list of entries, decoded with the GIL
+  bool failed; // out of memory while decoding
+  std::unique_ptr<DynamicJsonDocument> decoded;
+};
+
+static void decodeBatchItems(DecoderState* state, std::vector<BatchItem>& batch, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; i++) {
+    BatchItem& item = batch[i];
+    if (item.advert == NULL || item.entries) {
+      continue;
+    }
+    JsonObject decoded = state->decoded.to<JsonObject>();
+    // an exception leaving a native thread would terminate the interpreter
+    try {
+      if (state->decoder.decodeBLE(state->devices, decoded, item.values[FIELD_SERVICEDATA], item.values[FIELD_MANUFACTURERDATA],
+                                   item.values[FIELD_NAME], item.values[FIELD_SERVICEDATAUUID], item.values[FIELD_ID]) >= 0) {
+        item.decoded.reset(new DynamicJsonDocument(state->decoded.memoryUsage()));
+        item.failed = !item.decoded->set(decoded); // its pool left unallocated
+      }
+    } catch (const std::bad_alloc&) {
+      item.failed = true;
+    }
+  }
+}
+
+/*
+ * Runs work(state, begin, end) over count items split between the decoder
+ * states, one native thread each, the calling one included.
+ */
+template <typename Work>
+static void spreadBatch(std::vector<std::unique_ptr<DecoderState> >& states, size_t count, Work work)
+{
+  size_t workers = states.size();
+  size_t chunk = (count + workers - 1) / workers;
+  std::vector<std::thread> threads;
+
+  for (size_t w = 1; w < workers; w++) {
+    size_t begin = w * chunk;
+    size_t end = std::min(count, begin + chunk);
+    if (begin >= end) {
+      break;
+    }
+    try {
+      threads.push_back(std::thread(work, states[w].get(), begin, end));
+    } catch (const std::system_error&) {
+      work(states[w].get(), begin, end);
+    }
+  }
+  work(states[0].get(), 0, std::min(count, chunk));
+  for (size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+}
+
+/*
+ * Creates a decoder state per thread, thread_count being bounded by the batch size.
+ * Returns false with an exception set on error.
+ */
+static bool newStates(std::vector<std::unique_ptr<DecoderState> >& states, int thread_count, size_t count)
+{
+  if (thread_count < 1) {
+    thread_count = 1;
+  }
+  if (static_cast<size_t>(thread_count) > count) {
+    thread_count = count > 0 ? count : 1;
+  }
+  for (int t = 0; t < thread_count; t++) {
+    states.push_back(std::unique_ptr<DecoderState>(new (std::nothrow) DecoderState()));
+    if (!states.back()) {
+      PyErr_NoMemory();
+      return false;
+    }
+  }
+  return true;
+}
+
+static PyObject *decode_many(PyObject *self, PyObject *args, PyObject *kwds)
+{
+  static const char* kwlist[] = {"adverts", "threads", NULL};
+  PyObject* adverts_arg;
+  int thread_count = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|i", const_cast<char**>(kwlist), &adverts_arg, &thread_count))
+    return NULL;
+
+  PyObject* adverts = PySequence_Fast(adverts_arg, "decode_many() expects a sequence of advertisement dicts");
+  if (adverts == NULL) {
+    return NULL;
+  }
+  size_t count = PySequence_Fast_GET_SIZE(adverts);
+  std::vector<BatchItem> batch(count);
+  std::vector<std::unique_ptr<DecoderState> > states;
+  std::string hex;
+  size_t hex_len = 0;
+  PyObject* results = NULL;
+
+  // the inputs are converted with the GIL held
+  for (size_t i = 0; i < count; i++) {
+    BatchItem& item = batch[i];
+    item.advert = NULL;
+    item.entries = false;
+    item.failed = false;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      item.items[f] = NULL;
+    }
+    PyObject* advert = PySequence_Fast_GET_ITEM(adverts, i);
+    if (!PyDict_Check(advert)) {
+      PyErr_SetString(PyExc_TypeError, "decode_many() expects a sequence of advertisement dicts");
+      goto done;
+    }
+    if (!getFields(advert, item.items)) {
+      goto done;
+    }
+    item.advert = advert;
+    item.entries = hasEntries(item.items);
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      hex_len += hexLength(item.items[f]);
+    }
+  }
+  hex.resize(hex_len);
+  {
+    char* hex_pos = &hex[0];
+    for (size_t i = 0; i < count; i++) {
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        if (!fieldString(batch[i].items[f], hex_pos, &batch[i].values[f])) {
+          goto done;
+        }
+      }
+    }
+  }
+
+  if (!newStates(states, thread_count, count)) {
+    goto done;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  spreadBatch(states, count, [&batch](DecoderState* state, size_t begin, size_t end) {
+    decodeBatchItems(state, batch, begin, end);
+  });
+  Py_END_ALLOW_THREADS
+
+  // and the results built once it is held again
+  for (size_t i = 0; i < count; i++) {
+    if (batch[i].failed) {
+      PyErr_NoMemory();
+      goto done;
+    }
+  }
+  results = PyList_New(count);
+  if (results == NULL) {
+    goto done;
+  }
+  for (size_t i = 0; i < count; i++) {
+    BatchItem& item = batch[i];
+    PyObject* result;
+    if (item.entries) {
+      result = decodeEntries(states[0].get(), item.advert, item.values, item.items[FIELD_SERVICEDATA]);
+    } else if (item.decoded) {
+      result = PyDict_Copy(item.advert);
+      if (result != NULL && !updateDict(result, item.decoded->as<JsonObject>(), false)) {
+        Py_CLEAR(result);
+      }
+    } else {
+      result = Py_None;
+      Py_INCREF(result);
+    }
+    if (result == NULL) {
+      Py_CLEAR(results);
+      goto done;
+    }
+    PyList_SET_ITEM(results, i, result);
+  }
+
+done:
+  for (size_t i = 0; i < count; i++) {
+    releaseFields(batch[i].items);
+  }
+  Py_DECREF(adverts);
+  return results;
+}
+
+//-----------------------------------------------------------------------------
+// Columnar decoding, one value per advertisement in each column exported
+// through the buffer protocol
+
+typedef struct {
+  PyObject_HEAD
+  void* data;
+  Py_ssize_t length;
+  Py_ssize_t itemsize;
+  char format[2];
+} ColumnObject;
+
+static PyTypeObject ColumnType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  "TheengsDecoder._decoder.Column",
+};
+
+static ColumnObject* newColumn(char format, Py_ssize_t itemsize, Py_ssize_t length)
+{
+  ColumnObject* column = PyObject_New(ColumnObject, &ColumnType);
+  if (column == NULL) {
+    return NULL;
+  }
+  column->data = PyMem_Malloc(length > 0 ? length * itemsize : 1);
+  column->length = length;
+  column->itemsize = itemsize;
+  column->format[0] = format;
+  column->format[1] = '\0';
+  if (column->data == NULL) {
+    Py_DECREF(column);
+    PyErr_NoMemory();
+    return NULL;
+  }
+  return column;
+}
+
+static void Column_dealloc(ColumnObject *self)
+{
+  PyMem_Free(self->data);
+  PyObject_Del(self);
+}
+
+static Py_ssize_t Column_length(ColumnObject *self)
+{
+  return self->length;
+}
+
+static int Column_getbuffer(ColumnObject *self, Py_buffer *view, int flags)
+{
+  view->obj = reinterpret_cast<PyObject*>(self);
+  Py_INCREF(self);
+  view->buf = self->data;
+  view->len = self->length * self->itemsize;
+  view->readonly = 0;
+  view->itemsize = self->itemsize;
+  view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) ? &self->length : NULL;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->itemsize : NULL;
+  view->suboffsets = NULL;
+  view->internal = NULL;
+  return 0;
+}
+
+static PyBufferProcs Column_as_buffer;
+static PySequenceMethods Column_as_sequence;
+
+/*
+ * Converts the payload columns with the GIL held, their items being kept
+ * alive by the lists copied from the input sequences.
+ */
+struct ColumnsInput {
+  PyObject* lists[FIELD_COUNT];
+  std::vector<const char*> values; // FIELD_COUNT per advertisement
+  std::string hex;
+  size_t count;
+
+  ColumnsInput() : count(0) {
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      lists[f] = NULL;
+    }
+  }
+  ~ColumnsInput() {
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      Py_XDECREF(lists[f]);
+    }
+  }
+
+  bool convert(PyObject** sequences) {
+    bool sized = false;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      if (sequences[f] == NULL || sequences[f] == Py_None) {
+        continue;
+      }
+      if ((lists[f] = PySequence_List(sequences[f])) == NULL) {
+        return false;
+      }
+      size_t len = PyList_GET_SIZE(lists[f]);
+      if (sized && len != count) {
+        PyErr_Format(PyExc_ValueError, "%s has %zu items, %zu expected", field_names[f], len, count);
+        return false;
+      }
+      count = len;
+      sized = true;
+    }
+
+    size_t hex_len = 0;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+      for (size_t i = 0; lists[f] != NULL && i < count; i++) {
+        hex_len += hexLength(PyList_GET_ITEM(lists[f], i));
+      }
+    }
+    hex.resize(hex_len);
+    values.assign(count * FIELD_COUNT, nullptr);
+
+    char* hex_pos = &hex[0];
+    for (size_t i = 0; i < count; i++) {
+      for (int f = 0; f < FIELD_COUNT; f++) {
+        if (lists[f] != NULL && !fieldString(PyList_GET_ITEM(lists[f], i), hex_pos, &values[i * FIELD_COUNT + f])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+static void decodeColumnsItems(DecoderState* state, const ColumnsInput& input, const std::vector<const char*>& properties,
+                               int32_t* models, double* const* columns, size_t begin, size_t end,
+                               std::atomic<bool>& failed)
+{
+  for (size_t i = begin; i < end; i++) {
+    const char* const* values = &input.values[i * FIELD_COUNT];
+    JsonObject decoded = state->decoded.to<JsonObject>();
+    // an exception leaving a native thread would terminate the interpreter
+    try {
+      models[i] = state->decoder.decodeBLE(state->devices, decoded, values[FIELD_SERVICEDATA], values[FIELD_MANUFACTURERDATA],
+                                           values[FIELD_NAME], values[FIELD_SERVICEDATAUUID], values[FIELD_ID]);
+    } catch (const std::bad_alloc&) {
+      models[i] = -1;
+      decoded = state->decoded.to<JsonObject>();
+      failed = true;
+    }
+    for (size_t p = 0; p < properties.size(); p++) {
+      JsonVariant value = decoded[properties[p]];
+      if (value.is<bool>()) {
+        columns[p][i] = value.as<bool>() ? 1 : 0;
+      } else if (!TheengsDecoder::readNumber(value, &columns[p][i])) {
+        columns[p][i] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  }
+}
+
+static PyObject *decode_columns(PyObject *self, PyObject *args, PyObject *kwds)
+{
+  static const char* kwlist[] = {"properties", "id", "name", "servicedata", "servicedatauuid", "manufacturerdata", "threads", NULL};
+  PyObject* properties_arg;
+  PyObject* sequences[FIELD_COUNT] = {NULL, NULL, NULL, NULL, NULL};
+  int thread_count = 1;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|OOOOOi", const_cast<char**>(kwlist), &properties_arg,
+                                   &sequences[FIELD_ID], &sequences[FIELD_NAME], &sequences[FIELD_SERVICEDATA],
+                                   &sequences[FIELD_SERVICEDATAUUID], &sequences[FIELD_MANUFACTURERDATA], &thread_count))
+    return NULL;
+
+  PyObject* property_list = PySequence_List(properties_arg);
+  if (property_list == NULL) {
+    return NULL;
+  }
+  ColumnsInput input;
+  std::vector<const char*> properties;
+  std::vector<double*> columns;
+  std::vector<std::unique_ptr<DecoderState> > states;
+  ColumnObject* models = NULL;
+  std::atomic<bool> failed(false); // out of memory in a decoding thread
+  PyObject* result = PyDict_New();
+  if (result == NULL || !input.convert(sequences)) {
+    goto error;
+  }
+
+  models = newColumn('i', sizeof(int32_t), input.count);
+  if (models == NULL || PyDict_SetItemString(result, "model", reinterpret_cast<PyObject*>(models)) < 0) {
+    goto error;
+  }
+  for (Py_ssize_t p = 0; p < PyList_GET_SIZE(property_list); p++) {
+    PyObject* name = PyList_GET_ITEM(property_list, p);
+    const char* property = PyUnicode_Check(name) ? PyUnicode_AsUTF8(name) : NULL;
+    if (property == NULL) {
+      if (!PyErr_Occurred()) {
+        PyErr_SetString(PyExc_TypeError, "properties must be strings");
+      }
+      goto error;
+    }
+    // a second column of the same name would replace the first, freeing the buffer it decodes into
+    int duplicate = PyDict_Contains(result, name);
+    if (duplicate != 0) {
+      if (duplicate > 0) {
+        PyErr_Format(PyExc_ValueError, "property %s requested twice or named as the model column", property);
+      }
+      goto error;
+    }
+    ColumnObject* column = newColumn('d', sizeof(double), input.count);
+    if (column == NULL) {
+      goto error;
+    }
+    int res = PyDict_SetItem(result, name, reinterpret_cast<PyObject*>(column));
+    Py_DECREF(column);
+    if (res < 0) {
+      goto error;
+    }
+    properties.push_back(property);
+    columns.push_back(static_cast<double*>(column->data));
+  }
+  if (!newStates(states, thread_count, input.count)) {
+    goto error;
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  {
+    int32_t* model_data = static_cast<int32_t*>(models->data);
+    double* const* column_data = columns.empty() ? NULL : &columns[0];
+    spreadBatch(states, input.count, [&](DecoderState* state, size_t begin, size_t end) {
+      decodeColumnsItems(state, input, properties, model_data, column_data, begin, end, failed);
+    });
+  }
+  Py_END_ALLOW_THREADS
+  if (failed) {
+    PyErr_NoMemory();
+    goto error;
+  }
+
+  Py_DECREF(models);
+  Py_DECREF(property_list);
+  return result;
+
+error:
+  Py_XDECREF(models);
+  Py_XDECREF(result);
+  Py_DECREF(property_list);
+  return NULL;
+}
+
+static bool initColumnType(PyObject *module)
+{
+  Column_as_buffer.bf_getbuffer = reinterpret_cast<getbufferproc>(Column_getbuffer);
+  Column_as_sequence.sq_length = reinterpret_cast<lenfunc>(Column_length);
+
+  ColumnType.tp_basicsize = sizeof(ColumnObject);
+  ColumnType.tp_flags = Py_TPFLAGS_DEFAULT;
+  ColumnType.tp_doc = "Column of decoded values, exported through the buffer protocol.";
+  ColumnType.tp_dealloc = reinterpret_cast<destructor>(Column_dealloc);
+  ColumnType.tp_as_buffer = &Column_as_buffer;
+  ColumnType.tp_as_sequence = &Column_as_sequence;
+  if (PyType_Ready(&ColumnType) < 0) {
+    return false;
+  }
+
+  Py_INCREF(&ColumnType);
+  if (PyModule_AddObject(module, "Column", reinterpret_cast<PyObject*>(&ColumnType)) < 0) {
+    Py_DECREF(&ColumnType);
+    return false;
+  }
+  return true;
+}
+
+static PyObject *Decoder_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+  if (PyTuple_GET_SIZE(args) != 0 || (kwds != NULL && PyDict_Size(kwds) != 0)) {
+    PyErr_SetString(PyExc_TypeError, "Decoder() takes no arguments");
+    return NULL;
+  }
+  DecoderObject* self = reinterpret_cast<DecoderObject*>(type->tp_alloc(type, 0));
+  if (self == NULL) {
+    return NULL;
+  }
+  self->state = new (std::nothrow) DecoderState();
+  if (self->state == NULL) {
+    Py_DECREF(self);
+    return PyErr_NoMemory();
+  }
+  return reinterpret_cast<PyObject*>(self);
+}
+
+static void Decoder_dealloc(DecoderObject *self)
+{
+  delete self->state;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static PyMethodDef Decoder_methods[] = {
+  {
+    "decodeBLE",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Decoder_decodeBLE)),
+    METH_FASTCALL,
+    "Decodes a BLE advertisement dict, returning a copy of it with the decoded data or None. "
+    "The servicedata and manufacturerdata payloads may be hexadecimal strings or bytes."
+  },
+  {
+    "getAttribute",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Decoder_getAttribute)),
+    METH_FASTCALL,
+    "Returns the named attribute of a model ID or None."
+  },
+  {
+    "getProperties",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Decoder_getProperties)),
+    METH_FASTCALL,
+    "Returns the properties dict of a model ID or None."
+  },
+  {NULL, NULL, 0, NULL}        /* Sentinel */
+};
+
+static PyTypeObject DecoderType = {
+  PyVarObject_HEAD_INIT(NULL, 0)
+  "TheengsDecoder._decoder.Decoder",
+};
+
+static bool initDecoderType(PyObject *module)
+{
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (field_keys[i] == NULL && (field_keys[i] = PyUnicode_InternFromString(field_names[i])) == NULL) {
+      return false;
+    }
+  }
+
+  DecoderType.tp_basicsize = sizeof(DecoderObject);
+  DecoderType.tp_flags = Py_TPFLAGS_DEFAULT;
+  DecoderType.tp_doc = "BLE advertisement decoder keeping its buffers between calls.";
+  DecoderType.tp_new = Decoder_new;
+  DecoderType.tp_dealloc = reinterpret_cast<destructor>(Decoder_dealloc);
+  DecoderType.tp_methods = Decoder_methods;
+  if (PyType_Ready(&DecoderType) < 0) {
+    return false;
+  }
+
+  Py_INCREF(&DecoderType);
+  if (PyModule_AddObject(module, "Decoder", reinterpret_cast<PyObject*>(&DecoderType)) < 0) {
+    Py_DECREF(&DecoderType);
+    return false;
+  }
+  return true;
+}
+#endif /* PY_VERSION_HEX >= 0x03070000 */
+
 //-----------------------------------------------------------------------------
 static PyMethodDef decoder_methods[] = {
   {
@@ -82,6 +1160,35 @@ static PyMethodDef decoder_methods[] = {
     METH_VARARGS,
     "Decodes a BLE advertisement packet into JSON data."
   },
+  {
+    "_get_catalog",
+    decode_getCatalog,
+    METH_NOARGS,
+    "Returns a tuple of dicts describing every model of the device catalog."
+  },
+  {
+    "getStats",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(decode_getStats)),
+    METH_VARARGS | METH_KEYWORDS,
+    "Returns the decode counters of the process as a dict, resetting them "
+    "if reset is true."
+  },
+#if PY_VERSION_HEX >= 0x03070000
+  {
+    "decode_many",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(decode_many)),
+    METH_VARARGS | METH_KEYWORDS,
+    "Decodes a sequence of BLE advertisement dicts without holding the GIL, "
+    "over threads native threads; returns a list of decoded dicts or None."
+  },
+  {
+    "_decode_columns",
+    reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(decode_columns)),
+    METH_VARARGS | METH_KEYWORDS,
+    "Decodes columns of BLE advertisement fields without holding the GIL, "
+    "returning the model index column and a column per requested property."
+  },
+#endif
   {NULL, NULL, 0, NULL}        /* Sentinel */
 };
 
@@ -102,6 +1209,18 @@ static struct PyModuleDef decoder_module_def = {
 
 PyMODINIT_FUNC PyInit__decoder(void)
 {
-  return PyModule_Create(&decoder_module_def);
+  PyObject *module = PyModule_Create(&decoder_module_def);
+#if PY_VERSION_HEX >= 0x03070000
+  if (module != NULL && (!initDecoderType(module) || !initColumnType(module))) {
+    Py_CLEAR(module);
+  }
+#endif
+#ifdef Py_GIL_DISABLED
+  // the decoders only share the immutable device catalog
+  if (module != NULL) {
+    PyUnstable_Module_SetGIL(module, Py_MOD_GIL_NOT_USED);
+  }
+#endif
+  return module;
 }
 #endif /* PY_MAJOR_VERSION >= 3 */
@@ -0,0 +1,78 @@
+"""Generate the document sizes of the device catalog.
+
+Counts, for every device definition listed in src/devices.h, the values and
+the string bytes ArduinoJson stores when parsing it, and writes them as a C++
+header that the decoder includes when built with DECODER_NO_HEAP, to size
+the document it parses the definitions into:
+
+    python scripts/catalog_doc_size.py [--devices LIST] [output.h]
+
+The strings are counted as if none were shared, each key and string value
+with its null, which bounds the size whatever the string deduplication of
+ArduinoJson. The output defaults to src/devices_doc_size.h. With --devices,
+only the models of the list are counted, the others needing no document.
+"""
+import json
+
+from catalog_msgpack import arguments, catalog, model_names, selection
+
+
+def doc_size(value) -> tuple:
+    """The values under value, itself excluded, and the bytes of its strings."""
+    values = 0
+    strings = 0
+    if isinstance(value, dict):
+        items = value.items()
+    elif isinstance(value, list):
+        items = ((None, item) for item in value)
+    else:
+        return 0, len(value.encode("utf-8")) + 1 if isinstance(value, str) else 0
+    for key, item in items:
+        item_values, item_strings = doc_size(item)
+        values += 1 + item_values
+        strings += item_strings
+        if key is not None:
+            strings += len(key.encode("utf-8")) + 1
+    return values, strings
+
+
+def main():
+    args = arguments("Generate the document sizes of the device catalog.", "devices_doc_size.h")
+    models = catalog()
+    selected = selection(models, args.devices)
+    names = model_names()
+    sizes = [doc_size(json.loads(definition)) if chosen else (0, 0) for (definition, _), chosen in zip(models, selected)]
+    # the largest at 16 bytes a value, as on 32 bit targets, for the comment only
+    largest = max(range(len(sizes)), key=lambda i: sizes[i][0] * 16 + sizes[i][1])
+
+    lines = [
+        "// Generated by scripts/catalog_doc_size.py from src/devices.h, do not edit",
+        f"// {sum(selected)} of {len(models)} definitions, the largest {names[largest]}: "
+        f"{sizes[largest][0]} values, {sizes[largest][1]} bytes of strings",
+        "",
+        "#ifndef _DEVICES_DOC_SIZE_H_",
+        "#define _DEVICES_DOC_SIZE_H_",
+        "",
+        "#include <stddef.h>",
+        "",
+        "struct DeviceDocSize {",
+        "  size_t values; // the root excluded",
+        "  size_t strings; // bytes, nulls included",
+        "};",
+        "",
+        "/* What parsing every definition stores, nothing for a model left out */",
+        "constexpr DeviceDocSize _devices_doc_size[] = {",
+    ]
+    for i, (values, strings) in enumerate(sizes):
+        lines.append(f"    {{{values}, {strings}}}, // {i} {names[i]}")
+    lines += [
+        "};",
+        "",
+        "#endif",
+        "",
+    ]
+    args.output.write_text("\n".join(lines), encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,266 @@
+"""Generate the MessagePack device catalog.
+
+Encodes the device definitions listed in src/devices.h into MessagePack, in
+the catalog order, and writes them as a C++ header that the decoder includes
+instead of src/devices.h when built with DECODER_MSGPACK_CATALOG:
+
+    python scripts/catalog_msgpack.py [--devices LIST] [output.h]
+
+The header holds the definitions one after the other in one byte array, the
+offset of each, the spans of its brand, model, model_id and tag strings in it
+and the property metadata strings, which stay in JSON. The output defaults to
+src/devices_msgpack.h. With --devices, only the models of the list are
+encoded, the others keeping their index with an empty definition.
+"""
+import argparse
+import json
+import re
+import struct
+from pathlib import Path
+
+SRC = Path(__file__).resolve().parent.parent / "src"
+ATTRIBUTES = ("brand", "model", "model_id", "tag")
+
+# The device types of the first octet of the model tags, as the decoder names them
+TAG_TYPES = {
+    1: "THB", 2: "THBX", 3: "BBQ", 4: "CTMO", 5: "SCALE", 6: "BCON", 7: "ACEL", 8: "BATT", 9: "PLANT",
+    10: "TIRE", 11: "BODY", 12: "ENRG", 13: "WCVR", 14: "ACTR", 15: "AIR", 16: "TRACK", 17: "BTN",
+    254: "RMAC", 255: "UNIQ",
+}
+
+
+class Encoder:
+    """MessagePack encoder keeping the key order and the JSON number types."""
+
+    def __init__(self):
+        self.out = bytearray()
+        self.strings = {}  # top level string values, to their offset and size
+
+    def str(self, value: str) -> int:
+        data = value.encode("utf-8")
+        if len(data) < 32:
+            self.out.append(0xA0 | len(data))
+        elif len(data) < 0x100:
+            self.out += bytes((0xD9, len(data)))
+        elif len(data) < 0x10000:
+            self.out += b"\xda" + struct.pack(">H", len(data))
+        else:
+            self.out += b"\xdb" + struct.pack(">I", len(data))
+        offset = len(self.out)
+        self.out += data
+        return offset
+
+    def int(self, value: int):
+        if 0 <= value < 0x80:
+            self.out.append(value)
+        elif -32 <= value < 0:
+            self.out.append(value & 0xFF)
+        elif 0 <= value < 0x100:
+            self.out += bytes((0xCC, value))
+        elif 0 <= value < 0x10000:
+            self.out += b"\xcd" + struct.pack(">H", value)
+        elif 0 <= value < 0x100000000:
+            self.out += b"\xce" + struct.pack(">I", value)
+        elif 0 <= value:
+            self.out += b"\xcf" + struct.pack(">Q", value)
+        elif -0x80 <= value:
+            self.out += b"\xd0" + struct.pack(">b", value)
+        elif -0x8000 <= value:
+            self.out += b"\xd1" + struct.pack(">h", value)
+        elif -0x80000000 <= value:
+            self.out += b"\xd2" + struct.pack(">i", value)
+        else:
+            self.out += b"\xd3" + struct.pack(">q", value)
+
+    def float(self, value: float):
+        # a float32 only when it holds the value the JSON text gives exactly
+        single = struct.pack(">f", value)
+        if struct.unpack(">f", single)[0] == value:
+            self.out += b"\xca" + single
+        else:
+            self.out += b"\xcb" + struct.pack(">d", value)
+
+    def value(self, value, top_key=None):
+        if value is None:
+            self.out.append(0xC0)
+        elif value is True:
+            self.out.append(0xC3)
+        elif value is False:
+            self.out.append(0xC2)
+        elif isinstance(value, int):
+            self.int(value)
+        elif isinstance(value, float):
+            self.float(value)
+        elif isinstance(value, str):
+            offset = self.str(value)
+            if top_key is not None:
+                self.strings[top_key] = (offset, len(value.encode("utf-8")))
+        elif isinstance(value, list):
+            self.header(len(value), 0x90, b"\xdc", b"\xdd")
+            for item in value:
+                self.value(item)
+        elif isinstance(value, dict):
+            self.header(len(value), 0x80, b"\xde", b"\xdf")
+            for key, item in value.items():
+                self.str(key)
+                self.value(item)
+        else:
+            raise TypeError(f"cannot encode {value!r}")
+
+    def header(self, count: int, fix: int, code16: bytes, code32: bytes):
+        if count < 16:
+            self.out.append(fix | count)
+        elif count < 0x10000:
+            self.out += code16 + struct.pack(">H", count)
+        else:
+            self.out += code32 + struct.pack(">I", count)
+
+    def definition(self, definition: dict):
+        self.header(len(definition), 0x80, b"\xde", b"\xdf")
+        for key, item in definition.items():
+            self.str(key)
+            self.value(item, key if key in ATTRIBUTES else None)
+
+
+def c_strings(source: str) -> dict:
+    """The const char* strings of a device header, by name."""
+    strings = {}
+    for name, literal in re.findall(r'const char\* (\w+)\s*=\s*"((?:[^"\\]|\\.)*)";', source):
+        strings[name] = re.sub(r"\\(.)", r"\1", literal)
+    for name, alias in re.findall(r"const char\* (\w+)\s*=\s*(\w+);", source):
+        strings[name] = alias
+    return strings
+
+
+def catalog() -> list:
+    """The (definition, properties) JSON strings in the order of src/devices.h."""
+    devices = (SRC / "devices.h").read_text(encoding="utf-8")
+    strings = {}
+    for header in sorted((SRC / "devices").glob("*.h")):
+        strings.update(c_strings(header.read_text(encoding="utf-8")))
+    table = devices[devices.index("_devices[][2]"):]
+    table = table[: table.index("#ifdef DECODER_EXTRA_DEVICES")]
+    for name, value in strings.items():
+        while value in strings:  # shared strings, defined by name
+            value = strings[value]
+        strings[name] = value
+    return [(strings[json], strings[props]) for json, props in re.findall(r"\{(\w+),\s*(\w+)\}", table)]
+
+
+def model_names() -> list:
+    """The BLE_ID_NUM names of the models of src/decoder.h, in the catalog order."""
+    header = (SRC / "decoder.h").read_text(encoding="utf-8")
+    enum = header[header.index("enum BLE_ID_NUM {") : header.index("BLE_ID_MAX")]
+    return [name for name in re.findall(r"^\s*(\w+)(?:\s*=\s*-?\d+)?,", enum, re.M) if name != "UNKNOWN_MODEL"]
+
+
+def selection(models: list, devices: str) -> list:
+    """Whether each model is selected by devices, BLE_ID_NUM names and tag
+    types separated by ; or , selecting all the models when empty."""
+    if not devices:
+        return [True] * len(models)
+    names = model_names()
+    if len(names) != len(models):
+        raise ValueError(f"{len(names)} BLE_ID_NUM models for {len(models)} definitions")
+    types = []
+    for definition, _ in models:
+        tag = json.loads(definition).get("tag", "")
+        types.append(TAG_TYPES.get(int(tag[:2], 16)) if len(tag) >= 2 else None)
+    selected = [False] * len(models)
+    for item in filter(None, re.split(r"[;,\s]+", devices)):
+        if item in names and item in types:
+            raise ValueError(f"{item} is both a model and a tag type")
+        chosen = [i for i in range(len(models)) if item in (names[i], types[i])]
+        if not chosen:
+            raise ValueError(f"{item} is neither a BLE_ID_NUM model nor a tag type")
+        for i in chosen:
+            selected[i] = True
+    if not any(selected):
+        raise ValueError("no model selected")
+    return selected
+
+
+def arguments(description: str, default: str) -> argparse.Namespace:
+    """The output header and the models selected of a generator."""
+    parser = argparse.ArgumentParser(description=description)
+    parser.add_argument("--devices", default="", help="BLE_ID_NUM names and tag types to compile in, all by default")
+    parser.add_argument("output", nargs="?", type=Path, default=SRC / default)
+    return parser.parse_args()
+
+
+def c_literal(text: str) -> str:
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def main():
+    args = arguments("Generate the MessagePack device catalog.", "devices_msgpack.h")
+    models = catalog()
+    selected = selection(models, args.devices)
+    blob = bytearray()
+    offsets = []
+    spans = []
+    json_size = 0
+    for (definition, _), chosen in zip(models, selected):
+        if not chosen:
+            offsets.append(len(blob))
+            spans.append([(0, 0)] * len(ATTRIBUTES))
+            continue
+        json_size += len(definition.encode("utf-8")) + 1
+        encoder = Encoder()
+        encoder.definition(json.loads(definition))
+        if len(encoder.out) > 0xFFFF:
+            raise ValueError("a definition exceeds the 16 bit attribute offsets")
+        offsets.append(len(blob))
+        spans.append([encoder.strings.get(attr, (0, 0)) for attr in ATTRIBUTES])
+        blob += encoder.out
+    offsets.append(len(blob))
+
+    lines = [
+        "// Generated by scripts/catalog_msgpack.py from src/devices.h, do not edit",
+        f"// {sum(selected)} of {len(models)} definitions, {len(blob)} bytes of MessagePack for {json_size} bytes of JSON",
+        "",
+        "#ifndef _DEVICES_MSGPACK_H_",
+        "#define _DEVICES_MSGPACK_H_",
+        "",
+        "#include <stdint.h>",
+        "",
+        "/* The device definitions in MessagePack, one after the other */",
+        "const uint8_t _devices_msgpack[] = {",
+    ]
+    for i, (begin, end) in enumerate(zip(offsets, offsets[1:])):
+        if not selected[i]:
+            continue
+        chunk = blob[begin:end]
+        lines.append(f"    // {i} {json.loads(models[i][0]).get('model_id', '')}")
+        for row in range(0, len(chunk), 16):
+            lines.append("    " + " ".join(f"0x{b:02x}," for b in chunk[row : row + 16]))
+    lines += [
+        "};",
+        "",
+        "/* The offset of every definition in _devices_msgpack, then its size, a model left out being empty */",
+        "const uint32_t _devices_msgpack_offsets[] = {",
+    ]
+    for row in range(0, len(offsets), 8):
+        lines.append("    " + " ".join(f"{o}," for o in offsets[row : row + 8]))
+    lines += [
+        "};",
+        "",
+        "/* Offset in its definition and size of the brand, model, model_id and tag strings, 0 if absent */",
+        "const uint16_t _devices_msgpack_attributes[][8] = {",
+    ]
+    for span in spans:
+        lines.append("    {" + ", ".join(f"{o}, {s}" for o, s in span) + "},")
+    lines += [
+        "};",
+        "",
+        "/* The property metadata of every definition, in JSON, null for a model left out */",
+        "const char* const _devices_props[] = {",
+    ]
+    for (_, props), chosen in zip(models, selected):
+        lines.append(f"    {c_literal(props) if chosen else 'nullptr'},")
+    lines += ["};", "", "#endif", ""]
+    args.output.write_text("\n".join(lines), encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,224 @@
+"""Generate the pooled device catalog.
+
+Splits the device definitions and property metadata listed in src/devices.h
+into the members of their JSON objects, down to the members of every
+property, and stores each distinct member once. The decoder built with
+DECODER_POOLED_CATALOG includes the generated header instead of
+src/devices.h and rebuilds the JSON text of a definition from its members
+when it parses it:
+
+    python scripts/catalog_pool.py [--devices LIST] [output.h]
+
+The header holds the distinct members one after the other in one string
+pool, the members of every object as indexes in that pool, the objects of
+every model and the spans of its brand, model, model_id and tag strings in
+the pool. The output defaults to src/devices_pool.h. With --devices, only
+the models of the list are pooled, the others keeping their index.
+"""
+import json
+
+from catalog_msgpack import ATTRIBUTES, arguments, c_literal, catalog, selection
+
+# The object members split further, the properties and each of their members
+SPLIT_DEPTH = 3
+NESTED = 0x8000  # a member whose value is the object that follows
+ABSENT = 0xFFFF  # the objects of a model left out
+
+
+def members(text: str) -> list:
+    """The members of the JSON object text, as they are written."""
+    text = text.strip()
+    if text[0] != "{" or text[-1] != "}":
+        raise ValueError(f"not a JSON object: {text[:40]}")
+    out = []
+    depth = 0
+    start = 1
+    in_string = False
+    i = 1
+    while i < len(text) - 1:
+        ch = text[i]
+        if in_string:
+            if ch == "\\":
+                i += 1
+            elif ch == '"':
+                in_string = False
+        elif ch == '"':
+            in_string = True
+        elif ch in "[{":
+            depth += 1
+        elif ch in "]}":
+            depth -= 1
+        elif ch == "," and depth == 0:
+            out.append(text[start:i].strip())
+            start = i + 1
+        i += 1
+    last = text[start : len(text) - 1].strip()
+    if last:
+        out.append(last)
+    return out
+
+
+def split_member(member: str) -> tuple:
+    """The key of the member, with its colon, and its value."""
+    i = 1
+    while member[i] != '"':
+        i += 2 if member[i] == "\\" else 1
+    colon = member.index(":", i + 1)
+    return member[: colon + 1], member[colon + 1 :].strip()
+
+
+class Pool:
+    """The distinct members and objects of the catalog."""
+
+    def __init__(self):
+        self.fragments = {}  # member text to its index
+        self.texts = []
+        self.offsets = []
+        self.size = 0
+        self.objects = {}  # tuple of member references to the object index
+        self.object_members = []
+
+    def fragment(self, text: str) -> int:
+        if text not in self.fragments:
+            self.fragments[text] = len(self.texts)
+            self.texts.append(text)
+            self.offsets.append(self.size)
+            self.size += len(text.encode("utf-8"))
+        return self.fragments[text]
+
+    def object(self, text: str, depth: int = 1) -> int:
+        refs = []
+        for member in members(text):
+            key, value = split_member(member)
+            if value.startswith("{") and depth < SPLIT_DEPTH:
+                refs += [NESTED | self.fragment(key), self.object(value, depth + 1)]
+            else:
+                refs.append(self.fragment(member))
+        refs = tuple(refs)
+        if refs not in self.objects:
+            self.objects[refs] = len(self.object_members)
+            self.object_members.append(refs)
+        return self.objects[refs]
+
+    def rebuild(self, index: int) -> str:
+        """The JSON text of the object, as the decoder rebuilds it."""
+        parts = []
+        refs = iter(self.object_members[index])
+        for ref in refs:
+            text = self.texts[ref & ~NESTED]
+            if ref & NESTED:
+                text += self.rebuild(next(refs))
+            parts.append(text)
+        return "{" + ",".join(parts) + "}"
+
+    def attribute(self, index: int, name: str) -> tuple:
+        """Offset in the pool and size of the string of a top level member, 0 if absent."""
+        for ref in self.object_members[index]:
+            if ref & NESTED:
+                continue
+            key, value = split_member(self.texts[ref])
+            if json.loads(key[:-1]) == name and value.startswith('"'):
+                begin = self.offsets[ref] + len(self.texts[ref].encode("utf-8")) - len(value.encode("utf-8")) + 1
+                return begin, len(value.encode("utf-8")) - 2
+        return 0, 0
+
+
+def main():
+    args = arguments("Generate the pooled device catalog.", "devices_pool.h")
+    pool = Pool()
+    source = catalog()
+    selected = selection(source, args.devices)
+    models = []
+    json_texts = {}
+    for (definition, props), chosen in zip(source, selected):
+        if not chosen:
+            models.append((ABSENT, ABSENT))
+            continue
+        models.append((pool.object(definition), pool.object(props)))
+        json_texts[definition] = json_texts[props] = None
+    # the text rebuilt parses to the definition, its key order included
+    for (definition, props), model, chosen in zip(source, models, selected):
+        if not chosen:
+            continue
+        for text, index in zip((definition, props), model):
+            rebuilt = pool.rebuild(index)
+            if json.loads(rebuilt, object_pairs_hook=list) != json.loads(text, object_pairs_hook=list):
+                raise ValueError(f"object {index} is not rebuilt as {text[:40]}")
+    text_max = max(len(pool.rebuild(i).encode("utf-8")) for i in range(len(pool.object_members))) + 1
+    member_count = sum(len(refs) for refs in pool.object_members)
+    if len(pool.offsets) >= NESTED or member_count > 0xFFFF or len(pool.object_members) >= ABSENT:
+        raise ValueError("the catalog exceeds the 16 bit member references")
+    pool_size = pool.size
+    json_size = sum(len(t.encode("utf-8")) + 1 for t in json_texts)
+
+    lines = [
+        "// Generated by scripts/catalog_pool.py from src/devices.h, do not edit",
+        f"// {sum(selected)} of {len(models)} models, {len(pool.offsets)} distinct members in {pool_size} bytes"
+        f" for {json_size} bytes of distinct JSON",
+        "",
+        "#ifndef _DEVICES_POOL_H_",
+        "#define _DEVICES_POOL_H_",
+        "",
+        "#include <stdint.h>",
+        "",
+        "/* The longest JSON text of an object of the catalog, its null included */",
+        f"#define CATALOG_TEXT_MAX {text_max}",
+        "",
+        "/* The objects of a model left out of the catalog */",
+        f"#define CATALOG_ABSENT 0x{ABSENT:04x}",
+        "",
+        "/* The distinct members of the objects of the catalog, one after the other */",
+        "const char _catalog_pool[] =",
+    ]
+    for text in pool.texts:
+        lines.append(f"    {c_literal(text)}")
+    lines[-1] += ";"
+    lines += [
+        "",
+        "/* The offset of every member in _catalog_pool, then the pool size */",
+        "const uint32_t _catalog_fragments[] = {",
+    ]
+    offsets = pool.offsets + [pool_size]
+    for row in range(0, len(offsets), 8):
+        lines.append("    " + " ".join(f"{o}," for o in offsets[row : row + 8]))
+    lines += [
+        "};",
+        "",
+        "/* The members of the objects, 0x8000 marking the key of a member whose value is the object that follows */",
+        "const uint16_t _catalog_members[] = {",
+    ]
+    first = [0]
+    for refs in pool.object_members:
+        lines.append("    " + " ".join(f"0x{r:04x}," for r in refs))
+        first.append(first[-1] + len(refs))
+    lines += [
+        "};",
+        "",
+        "/* The first member of every object in _catalog_members, then their count */",
+        "const uint16_t _catalog_objects[] = {",
+    ]
+    for row in range(0, len(first), 8):
+        lines.append("    " + " ".join(f"{o}," for o in first[row : row + 8]))
+    lines += [
+        "};",
+        "",
+        "/* The object of the definition and of the property metadata of every model, CATALOG_ABSENT if left out */",
+        "const uint16_t _catalog_models[][2] = {",
+    ]
+    for definition, props in models:
+        lines.append(f"    {{{definition}, {props}}}," if definition != ABSENT else f"    {{CATALOG_ABSENT, CATALOG_ABSENT}},")
+    lines += [
+        "};",
+        "",
+        "/* Offset in _catalog_pool and size of the brand, model, model_id and tag strings, 0 if absent */",
+        "const uint32_t _catalog_attributes[][8] = {",
+    ]
+    for definition, _ in models:
+        spans = [pool.attribute(definition, attr) if definition != ABSENT else (0, 0) for attr in ATTRIBUTES]
+        lines.append("    {" + ", ".join(f"{o}, {s}" for o, s in spans) + "},")
+    lines += ["};", "", "#endif", ""]
+    args.output.write_text("\n".join(lines), encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,55 @@
+"""Generate a device catalog holding only some of the models.
+
+Writes the device definitions and property metadata of the models listed, by
+their BLE_ID_NUM name or by the device type of their tag (THB, BBQ, TRACK...),
+as a C++ header that the decoder includes instead of src/devices.h when
+built with DECODER_DEVICE_SUBSET:
+
+    python scripts/catalog_subset.py --devices "LYWSD03MMC_ATC;RUUVITAG_RAWV2;BBQ" [output.h]
+
+The models left out keep their entry in _devices, null, so that every model
+keeps its BLE_ID_NUM index. The output defaults to src/devices_subset.h.
+"""
+import json
+
+from catalog_msgpack import arguments, c_literal, catalog, model_names, selection
+
+
+def main():
+    args = arguments("Generate a device catalog holding only some of the models.", "devices_subset.h")
+    models = catalog()
+    selected = selection(models, args.devices)
+    names = model_names()
+    json_size = sum(len(d.encode("utf-8")) + len(p.encode("utf-8")) + 2 for (d, p), s in zip(models, selected) if s)
+
+    lines = [
+        "// Generated by scripts/catalog_subset.py from src/devices.h, do not edit",
+        f"// {sum(selected)} of {len(models)} models, {json_size} bytes of JSON",
+        "",
+        "#ifndef _DEVICES_SUBSET_H_",
+        "#define _DEVICES_SUBSET_H_",
+        "",
+        "/* The definition and property metadata of every model, null for the models left out */",
+        "const char* _devices[][2] = {",
+    ]
+    for i, ((definition, props), chosen) in enumerate(zip(models, selected)):
+        if chosen:
+            lines.append(f"    // {i} {names[i]}, {json.loads(definition).get('model_id', '')}")
+            lines.append(f"    {{{c_literal(definition)},")
+            lines.append(f"     {c_literal(props)}}},")
+        else:
+            lines.append(f"    {{nullptr, nullptr}}, // {i} {names[i]}")
+    lines += [
+        "#ifdef DECODER_EXTRA_DEVICES",
+        "#  include DECODER_EXTRA_DEVICES",
+        "#endif",
+        "};",
+        "",
+        "#endif",
+        "",
+    ]
+    args.output.write_text("\n".join(lines), encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -21,10 +21,173 @@
 
 #include "decoder.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <climits>
+#include <deque>
+#include <math.h>
+#include <new>
+#include <stdint.h>
+#include <string.h>
 #include <string>
+#include <type_traits>
+#include <vector>
 
-#include "devices.h"
+#if defined(DECODER_MSGPACK_CATALOG) && defined(DECODER_POOLED_CATALOG)
+#  error "DECODER_MSGPACK_CATALOG and DECODER_POOLED_CATALOG are two ways of storing the catalog, define one"
+#endif
+
+#ifdef DECODER_MSGPACK_CATALOG
+#  ifdef DECODER_EXTRA_DEVICES
+#    error "DECODER_EXTRA_DEVICES are appended to the JSON catalog, not DECODER_MSGPACK_CATALOG"
+#  endif
+// generated by scripts/catalog_msgpack.py
+#  include "devices_msgpack.h"
+#elif defined(DECODER_POOLED_CATALOG)
+#  ifdef DECODER_EXTRA_DEVICES
+#    error "DECODER_EXTRA_DEVICES are appended to the JSON catalog, not DECODER_POOLED_CATALOG"
+#  endif
+// generated by scripts/catalog_pool.py
+#  include "devices_pool.h"
+#elif defined(DECODER_DEVICE_SUBSET)
+// generated by scripts/catalog_subset.py
+#  include "devices_subset.h"
+#else
+#  include "devices.h"
+#endif
+#if defined(DECODER_NO_HEAP) && defined(DECODER_CATALOG_DOC_SIZES)
+// generated by scripts/catalog_doc_size.py
+#  include "devices_doc_size.h"
+#endif
+#include "json_scanner.h"
+
+namespace {
+#ifdef DECODER_MSGPACK_CATALOG
+const size_t CATALOG_MODELS = sizeof(_devices_msgpack_offsets) / sizeof(_devices_msgpack_offsets[0]) - 1;
+
+/* The definition of a model, in MessagePack */
+const char* catalogDefinition(size_t index) {
+  return reinterpret_cast<const char*>(_devices_msgpack) + _devices_msgpack_offsets[index];
+}
+
+const char* catalogProperties(size_t index) {
+  return _devices_props[index];
+}
+
+/* The base of the attribute spans of a model */
+const char* catalogAttributes(size_t index) {
+  return catalogDefinition(index);
+}
+#elif defined(DECODER_POOLED_CATALOG)
+const size_t CATALOG_MODELS = sizeof(_catalog_models) / sizeof(_catalog_models[0]);
+
+/*
+ * Writes the JSON text of an object of the pooled catalog to out, of
+ * CATALOG_TEXT_MAX characters, and returns its length without the null.
+ */
+size_t catalogText(size_t object, char* out) {
+  size_t len = 0;
+  out[len++] = '{';
+  for (size_t m = _catalog_objects[object]; m < _catalog_objects[object + 1]; ++m) {
+    if (m > _catalog_objects[object]) {
+      out[len++] = ',';
+    }
+    uint16_t member = _catalog_members[m] & 0x7fff;
+    size_t size = _catalog_fragments[member + 1] - _catalog_fragments[member];
+    memcpy(out + len, _catalog_pool + _catalog_fragments[member], size);
+    len += size;
+    if (_catalog_members[m] & 0x8000) { // the key of a member, its value being the object that follows
+      len += catalogText(_catalog_members[++m], out + len);
+    }
+  }
+  out[len++] = '}';
+  out[len] = '\0';
+  return len;
+}
+
+/* The property metadata of a model, in JSON */
+std::string catalogProperties(size_t index) {
+  char text[CATALOG_TEXT_MAX];
+  return std::string(text, catalogText(_catalog_models[index][1], text));
+}
+
+const char* catalogAttributes(size_t) {
+  return _catalog_pool;
+}
+#else
+const size_t CATALOG_MODELS = sizeof(_devices) / sizeof(_devices[0]);
+
+/* The definition of a model, in JSON */
+const char* catalogDefinition(size_t index) {
+  return _devices[index][0];
+}
+
+const char* catalogProperties(size_t index) {
+  return _devices[index][1];
+}
+
+const char* catalogAttributes(size_t index) {
+  return catalogDefinition(index);
+}
+#endif
+
+#ifdef DECODER_DEVICE_SUBSET
+/* Whether the model is compiled in, the models left out of the subset keeping their index */
+bool catalogSelected(size_t index) {
+#  ifdef DECODER_MSGPACK_CATALOG
+  return _devices_msgpack_offsets[index + 1] != _devices_msgpack_offsets[index];
+#  elif defined(DECODER_POOLED_CATALOG)
+  return _catalog_models[index][0] != CATALOG_ABSENT;
+#  else
+  return _devices[index][0] != nullptr;
+#  endif
+}
+#else
+bool catalogSelected(size_t) {
+  return true;
+}
+#endif
+
+/* FNV-1a hash of len bytes of data, continuing hash */
+uint32_t fnv1a(const char* data, size_t len, uint32_t hash = 2166136261u) {
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+  }
+  return hash;
+}
+
+#ifdef DECODER_NO_HEAP
+#  ifdef DECODER_CATALOG_DOC_SIZES
+/* The bytes ArduinoJson stores a parsed definition in, the root included */
+constexpr size_t deviceDocSize(const DeviceDocSize& size) {
+#    ifdef JSON_OBJECT_SIZE
+  return JSON_OBJECT_SIZE(size.values + 1) + size.strings;
+#    else
+  return (size.values + 1) * 16 + size.strings; // the slot of a value on 32 bit targets
+#    endif
+}
+
+constexpr size_t largerDocSize(size_t a, size_t b) {
+  return a > b ? a : b;
+}
+
+const size_t DOC_SIZE_MODELS = sizeof(_devices_doc_size) / sizeof(_devices_doc_size[0]);
+
+/* The size of the largest definition parsed, from index on */
+constexpr size_t catalogDocSize(size_t index = 0) {
+  return index == DOC_SIZE_MODELS ? 0 : largerDocSize(deviceDocSize(_devices_doc_size[index]), catalogDocSize(index + 1));
+}
+
+#    ifndef DECODER_DOC_SIZE
+#      define DECODER_DOC_SIZE catalogDocSize()
+#    endif
+#  endif
+#  ifndef DECODER_DOC_SIZE
+#    define DECODER_DOC_SIZE 12000
+#  endif
+#endif
+} // namespace
 
 #ifdef DEBUG_DECODER
 #  include <stdio.h>
@@ -39,7 +202,142 @@
 #  define TEST_MAX_DOC 16384UL
 #  include <assert.h>
 static size_t peakDocSize = 0;
+
+void (*TheengsDecoder::testPropertiesHook)(bool decoding) = nullptr;
+
+// Reports the scope of a property decode to testPropertiesHook
+struct TestPropertiesScope {
+  TestPropertiesScope() {
+    if (TheengsDecoder::testPropertiesHook != nullptr) {
+      TheengsDecoder::testPropertiesHook(true);
+    }
+  }
+  ~TestPropertiesScope() {
+    if (TheengsDecoder::testPropertiesHook != nullptr) {
+      TheengsDecoder::testPropertiesHook(false);
+    }
+  }
+};
+#endif
+
+/*
+ * USDT probes of the provider theengs_decoder, for bpftrace, perf or
+ * SystemTap on a running program; without DECODER_USDT they compile to nothing.
+ */
+#ifdef DECODER_USDT
+#  include <sys/sdt.h>
+#  define PROBE1(name, a)       DTRACE_PROBE1(theengs_decoder, name, a)
+#  define PROBE2(name, a, b)    DTRACE_PROBE2(theengs_decoder, name, a, b)
+#  define PROBE3(name, a, b, c) DTRACE_PROBE3(theengs_decoder, name, a, b, c)
+#else
+#  define PROBE1(name, a) \
+    {}
+#  define PROBE2(name, a, b) \
+    {}
+#  define PROBE3(name, a, b, c) \
+    {}
+#endif
+
+#ifdef DECODER_PROFILE
+#  ifdef DECODER_EXTRA_DEVICES
+#    error "DECODER_PROFILE only profiles the BLE_ID_NUM models, not DECODER_EXTRA_DEVICES"
+#  endif
+#  define PROFILE_COMPARISON()         \
+    {                                  \
+      if (m_profiled != nullptr)       \
+        m_profiled->comparisons++;     \
+    }
+#else
+#  define PROFILE_COMPARISON() \
+    {}
+#endif
+
+/* Records of the decode trace kept per thread, a power of two */
+#ifndef TRACE_RING_SIZE
+#  define TRACE_RING_SIZE 1024
+#endif
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+#define TRACE(...)            \
+  {                           \
+    if (m_trace)              \
+      traceRecord(__VA_ARGS__); \
+  }
+
+namespace {
+/* The trace records of a thread, only accessed by that thread so that no lock or atomic is needed */
+struct TraceRing {
+  TheengsDecoder::TraceRecord records[TRACE_RING_SIZE];
+  uint32_t written;
+};
+
+// allocated on the first record of the thread, so that threads not tracing reserve nothing
+thread_local TraceRing* trace_ring = nullptr;
+
+void traceRecord(int event, int result, int device, int condition, int aux, int32_t value) {
+  if (trace_ring == nullptr) {
+#ifdef DECODER_NO_HEAP
+    return; // the ring would be allocated
+#else
+    trace_ring = new (std::nothrow) TraceRing();
+    if (trace_ring == nullptr) {
+      return;
+    }
 #endif
+  }
+  TheengsDecoder::TraceRecord& record = trace_ring->records[trace_ring->written++ & (TRACE_RING_SIZE - 1)];
+  record.time = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+  record.event = static_cast<uint8_t>(event);
+  record.result = static_cast<uint8_t>(result);
+  record.device = static_cast<int16_t>(device);
+  record.condition = static_cast<int16_t>(condition);
+  record.aux = static_cast<int16_t>(aux);
+  record.value = value;
+}
+
+int32_t floatBits(double value) {
+  float f = static_cast<float>(value);
+  int32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+int32_t traceLength(const char* str) {
+  return str != nullptr ? static_cast<int32_t>(strlen(str)) : -1;
+}
+} // namespace
+
+/*
+ * @brief Moves the trace records of the calling thread into records, oldest
+ * first, and returns their number; when more than cap were kept, the most
+ * recent ones are returned and the older dropped. The ring holds the last
+ * TRACE_RING_SIZE records of the decoders the thread traced.
+ */
+size_t TheengsDecoder::readTrace(TraceRecord* records, size_t cap) {
+  if (trace_ring == nullptr) {
+    return 0;
+  }
+  uint32_t written = trace_ring->written;
+  size_t count = written < TRACE_RING_SIZE ? written : TRACE_RING_SIZE;
+  if (count > cap) {
+    count = cap;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    records[i] = trace_ring->records[(written - count + i) & (TRACE_RING_SIZE - 1)];
+  }
+  trace_ring->written = 0;
+  return count;
+}
+
+/*
+ * @brief Frees the trace ring of the calling thread, for threads that stop tracing.
+ */
+void TheengsDecoder::releaseTrace() {
+  delete trace_ring;
+  trace_ring = nullptr;
+}
 
 #define SVC_DATA "servicedata"
 #define MFG_DATA "manufacturerdata"
@@ -83,6 +381,48 @@ double TheengsDecoder::bf_value_from_hex_string(const char* data_str,
   return d_value;
 }
 
+/*
+ * @brief Copies the data_length hexadecimal digits at offset to data, of 17
+ * characters, byte reversed if reverse is true. Beyond 16 digits the value is
+ * truncated to the 64 bits it can hold.
+ */
+void TheengsDecoder::hex_from_data(const char* data_str, int offset, int data_length, bool reverse, char* data) {
+  // data_length being checked against the data only
+  if (data_length > 16) {
+    DEBUG_PRINT("value of %d characters truncated to 16\n", data_length);
+    data_length = 16;
+  }
+
+  if (reverse) {
+    reverse_hex_data(&data_str[offset], data, data_length);
+  } else {
+    memcpy(data, &data_str[offset], data_length);
+    data[data_length] = '\0';
+  }
+}
+
+/*
+ * @brief Extracts the integer value from the data string
+ */
+long long TheengsDecoder::int_from_hex_string(const char* data_str,
+                                              int offset, int data_length,
+                                              bool reverse, bool canBeNegative) {
+  char data[17];
+  hex_from_data(data_str, offset, data_length, reverse, data);
+
+  long long value = strtoll(data, NULL, 16);
+  DEBUG_PRINT("extracted value from %s = %lld\n", data, value);
+
+  if (canBeNegative) {
+    if (data_length <= 2 && value > SCHAR_MAX) {
+      value -= (UCHAR_MAX + 1);
+    } else if (data_length == 4 && value > SHRT_MAX) {
+      value -= (USHRT_MAX + 1);
+    }
+  }
+  return value;
+}
+
 /*
  * @brief Extracts the data value from the data string
  */
@@ -91,54 +431,58 @@ double TheengsDecoder::value_from_hex_string(const char* data_str,
                                              bool reverse, bool canBeNegative, bool isFloat) {
   DEBUG_PRINT("offset: %d, len %d, rev %u, neg, %u, flo, %u\n",
               offset, data_length, reverse, canBeNegative, isFloat);
-  std::string data(&data_str[offset], data_length);
-
-  if (reverse) {
-    reverse_hex_data(&data_str[offset], &data[0], data_length);
-  }
 
   double value = 0;
   if (!isFloat) {
-    value = strtoll(data.c_str(), NULL, 16);
-    DEBUG_PRINT("extracted value from %s = %lld\n", data.c_str(), (long long)value);
+    value = int_from_hex_string(data_str, offset, data_length, reverse, canBeNegative);
   } else {
+    char data[17];
+    hex_from_data(data_str, offset, data_length, reverse, data);
     union {
       long longV;
       float floatV;
     };
-    longV = strtol(data.c_str(), NULL, 16);
-    DEBUG_PRINT("extracted float value from %s = %f\n", data.c_str(), floatV);
+    longV = strtol(data, NULL, 16);
+    DEBUG_PRINT("extracted float value from %s = %f\n", data, floatV);
     value = floatV;
-  }
 
-  if (canBeNegative) {
-    if (data_length <= 2 && value > SCHAR_MAX) {
-      value -= (UCHAR_MAX + 1);
-    } else if (data_length == 4 && value > SHRT_MAX) {
-      value -= (USHRT_MAX + 1);
+    if (canBeNegative) {
+      if (data_length <= 2 && value > SCHAR_MAX) {
+        value -= (UCHAR_MAX + 1);
+      } else if (data_length == 4 && value > SHRT_MAX) {
+        value -= (USHRT_MAX + 1);
+      }
     }
   }
 
+  TRACE(TRACE_VALUE, 0, m_traceDevice, offset, data_length, floatBits(value));
   return value;
 }
 
 /*
- * @brief Removes the underscores at the beginning of key strings
- * when duplicate properties exist in a device.
+ * @brief Copies the key to key_out, of DECODER_KEY_MAX + 1 characters, without
+ * the underscores at its beginning when duplicate properties exist in a device.
+ * Returns false if it is too long.
  */
-std::string TheengsDecoder::sanitizeJsonKey(const char* key_in) {
-  unsigned int key_index = 0;
-  while (key_in[key_index] == '_') {
-    key_index++;
+bool TheengsDecoder::sanitizeJsonKey(const char* key_in, char* key_out) {
+  while (*key_in == '_') {
+    key_in++;
   }
-  return std::string(key_in + key_index);
+  size_t len = strlen(key_in);
+  if (len > DECODER_KEY_MAX) {
+    DEBUG_PRINT("ERROR - property key %s longer than DECODER_KEY_MAX\n", key_in);
+    return false;
+  }
+  memcpy(key_out, key_in, len + 1);
+  return true;
 }
 
 /*
  * @brief Checks to ensure accessing data at the index + length of the string is valid.
  */
 bool TheengsDecoder::data_index_is_valid(const char* str, size_t index, size_t len) {
-  if (strlen(str) < (index + len)) {
+  if (str == nullptr || strlen(str) < (index + len)) {
+    m_indexRejected = true;
     return false;
   }
   return true;
@@ -146,8 +490,9 @@ bool TheengsDecoder::data_index_is_valid(const char* str, size_t index, size_t l
 
 bool TheengsDecoder::data_length_is_valid(size_t data_len, size_t default_min,
                                           const JsonArray& condition, int* idx) {
-  std::string op = condition[*idx + 1].as<std::string>();
-  if (!op.empty() && op.length() > 2) {
+  const char* op = condition[*idx + 1].as<const char*>();
+  if (op != nullptr && strlen(op) > 2) {
+    TRACE(TRACE_DATA_LENGTH, data_len >= default_min, m_traceDevice, *idx, data_len, default_min);
     return (data_len >= default_min);
   }
 
@@ -157,9 +502,11 @@ bool TheengsDecoder::data_length_is_valid(size_t data_len, size_t default_min,
   }
 
   size_t req_len = condition[*idx + 2].as<size_t>();
+  bool valid = evaluateDatalength(op, data_len, req_len);
+  TRACE(TRACE_DATA_LENGTH, valid, m_traceDevice, *idx, data_len, req_len);
 
   *idx += 2;
-  return evaluateDatalength(op, data_len, req_len);
+  return valid;
 }
 
 uint8_t TheengsDecoder::getBinaryData(char ch) {
@@ -172,12 +519,13 @@ uint8_t TheengsDecoder::getBinaryData(char ch) {
   return data;
 }
 
-bool TheengsDecoder::evaluateDatalength(std::string op, size_t data_len, size_t req_len) {
-  if (op == "=" && data_len == req_len) return true;
-  if (op == ">=" && data_len >= req_len) return true;
-  if (op == ">" && data_len > req_len) return true;
-  if (op == "<=" && data_len <= req_len) return true;
-  if (op == "<" && data_len < req_len) return true;
+bool TheengsDecoder::evaluateDatalength(const char* op, size_t data_len, size_t req_len) {
+  if (op == nullptr) return false;
+  if (!strcmp(op, "=") && data_len == req_len) return true;
+  if (!strcmp(op, ">=") && data_len >= req_len) return true;
+  if (!strcmp(op, ">") && data_len > req_len) return true;
+  if (!strcmp(op, "<=") && data_len <= req_len) return true;
+  if (!strcmp(op, "<") && data_len < req_len) return true;
 
   return false;
 }
@@ -212,6 +560,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
     const char* cmp_str = nullptr;
     const char* cond_str = condition[i].as<const char*>();
     if (svc_data != nullptr && strstr(cond_str, SVC_DATA) != nullptr) {
+      PROFILE_COMPARISON();
       if (data_length_is_valid(strlen(svc_data), m_minSvcDataLen, condition, &i)) {
         cmp_str = svc_data;
         match = true;
@@ -222,6 +571,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
         }
       }
     } else if (mfg_data != nullptr && strstr(cond_str, MFG_DATA) != nullptr) {
+      PROFILE_COMPARISON();
       if (data_length_is_valid(strlen(mfg_data), m_minMfgDataLen, condition, &i)) {
         cmp_str = mfg_data;
         match = true;
@@ -262,37 +612,43 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
       }
 
       if (strstr(cond_str, "contain") != nullptr) {
+        PROFILE_COMPARISON();
         if (strstr(cmp_str, condition[++i].as<const char*>()) != nullptr) {
           match = true; // (strstr(cond_str, "not_") != nullptr) ? false : true;
         } else {
           match = false; // (strstr(cond_str, "not_") != nullptr) ? true : false;
         }
+        TRACE(TRACE_COMPARE, match, m_traceDevice, i - 1, -1, traceLength(condition[i].as<const char*>()));
         i++;
       } else if (strstr(cond_str, "mac@index") != nullptr) {
         size_t cond_index = condition[++i].as<size_t>();
         size_t cond_len = 12;
         const char* string_to_compare = nullptr;
-        std::string mac_string = mac_id;
-
-        // remove colons and make lower case
-        for (int x = 0; x < mac_string.length(); x++) {
-          if (mac_string[x] == ':') {
-            mac_string.erase(x, 1);
+        // the first 12 digits, without colons and in lower case
+        char mac_string[13];
+        size_t mac_len = 0;
+        for (const char* c = mac_id; c != nullptr && *c != '\0' && mac_len < 12; ++c) {
+          if (*c != ':') {
+            mac_string[mac_len++] = static_cast<char>(tolower(*c));
           }
-          mac_string[x] = tolower(mac_string[x]);
         }
+        mac_string[mac_len] = '\0';
 
-        string_to_compare = mac_string.c_str();
+        string_to_compare = mac_string;
 
+        char reverse_mac_string[13];
         if (strstr(cond_str, "revmac@index") != nullptr) {
-          char* reverse_mac_string = (char*)malloc(strlen(string_to_compare) + 1);
-
+          if (mac_len < 12) {
+            match = false;
+            break;
+          }
           reverse_hex_data(string_to_compare, reverse_mac_string, 12);
           string_to_compare = reverse_mac_string;
         }
 
         if (!data_index_is_valid(cmp_str, cond_index, cond_len)) {
           DEBUG_PRINT("Invalid data %s; skipping\n", cmp_str);
+          TRACE(TRACE_INVALID_INDEX, 0, m_traceDevice, i - 1, cond_index, traceLength(cmp_str));
           match = false;
           break;
         }
@@ -302,6 +658,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
                     string_to_compare,
                     cond_index);
 
+        PROFILE_COMPARISON();
         if (strncmp(&cmp_str[cond_index],
                     string_to_compare,
                     12) == 0) {
@@ -309,6 +666,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
         } else {
           match = false;
         }
+        TRACE(TRACE_COMPARE, match, m_traceDevice, i - 1, cond_index, 12);
 
         i++;
       } else if (strstr(cond_str, "index") != nullptr) {
@@ -317,6 +675,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
 
         if (!data_index_is_valid(cmp_str, cond_index, cond_len)) {
           DEBUG_PRINT("Invalid data %s; skipping\n", cmp_str);
+          TRACE(TRACE_INVALID_INDEX, 0, m_traceDevice, i - 2, cond_index, traceLength(cmp_str));
           match = false;
           break;
         }
@@ -332,6 +691,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
                     condition[i].as<const char*>(),
                     cond_index);
 
+        PROFILE_COMPARISON();
         if (strncmp(&cmp_str[cond_index],
                     condition[i].as<const char*>(),
                     cond_len) == 0) {
@@ -339,6 +699,7 @@ bool TheengsDecoder::checkDeviceMatch(const JsonArray& condition,
         } else {
           match = inverse ? true : false;
         }
+        TRACE(TRACE_COMPARE, match, m_traceDevice, i - 2 - inverse, cond_index, cond_len);
 
         i++;
       }
@@ -410,19 +771,24 @@ bool TheengsDecoder::checkPropCondition(const JsonArray& prop_condition,
       }
 
       if (data_src) {
+        PROFILE_COMPARISON();
         if (prop_condition[i + 1].is<int>()) {
           inverse = *(const char*)prop_condition[i + 2] == '!';
           size_t cond_len = strlen(prop_condition[i + 2 + inverse].as<const char*>());
           if (strstr((const char*)prop_condition[i + 2], "bit") != nullptr) {
-            char ch = *(data_src + prop_condition[i + 1].as<int>());
-            uint8_t data = getBinaryData(ch);
+            if (data_index_is_valid(data_src, prop_condition[i + 1].as<int>(), 1)) {
+              char ch = *(data_src + prop_condition[i + 1].as<int>());
+              uint8_t data = getBinaryData(ch);
 
-            uint8_t shift = prop_condition[i + 3].as<uint8_t>();
-            uint8_t val = prop_condition[i + 4].as<uint8_t>();
-            if (((data >> shift) & 0x01) == val) {
-              cond_met = true;
+              uint8_t shift = prop_condition[i + 3].as<uint8_t>();
+              uint8_t val = prop_condition[i + 4].as<uint8_t>();
+              if (((data >> shift) & 0x01) == val) {
+                cond_met = true;
+              }
             }
             i += 2;
+          } else if (!data_index_is_valid(data_src, prop_condition[i + 1].as<int>(), 0)) {
+            cond_met = inverse; // beyond the data, which cannot hold the value
           } else if (!strncmp(&data_src[prop_condition[i + 1].as<int>()],
                               prop_condition[i + 2 + inverse].as<const char*>(), cond_len)) {
             cond_met = inverse ? false : true;
@@ -431,7 +797,7 @@ bool TheengsDecoder::checkPropCondition(const JsonArray& prop_condition,
             cond_met = inverse ? true : false;
           }
         } else {
-          std::string op = prop_condition[i + 1].as<std::string>();
+          const char* op = prop_condition[i + 1].as<const char*>();
           size_t data_len = strlen(data_src);
           size_t req_len = prop_condition[i + 2].as<size_t>();
 
@@ -460,555 +826,2279 @@ bool TheengsDecoder::checkPropCondition(const JsonArray& prop_condition,
   return cond_met;
 }
 
+#ifdef DECODER_PROFILE
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+#endif
+
 /*
- * @brief Compares the input json values to the known devices and
- * decodes the data if a match is found.
+ * @brief Checks the conditions of the device i_main, accounting their cost
+ * to it when profiling.
  */
-int TheengsDecoder::decodeBLEJson(JsonObject& jsondata) {
-#ifdef UNIT_TESTING
-  DynamicJsonDocument doc(TEST_MAX_DOC);
+bool TheengsDecoder::matchDevice(int i_main, const JsonArray& condition,
+                                 const char* svc_data,
+                                 const char* mfg_data,
+                                 const char* dev_name,
+                                 const char* svc_uuid,
+                                 const char* mac_id) {
+  m_traceDevice = i_main;
+#ifdef DECODER_PROFILE
+  m_profiled = &m_profile[i_main];
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool match = checkDeviceMatch(condition, svc_data, mfg_data, dev_name, svc_uuid, mac_id);
+  m_profiled->match_ns += elapsedNs(start);
+  m_profiled->evaluations++;
+  m_profiled->matches += match;
+  m_profiled = nullptr;
 #else
-  DynamicJsonDocument doc(m_docMax);
+  bool match = checkDeviceMatch(condition, svc_data, mfg_data, dev_name, svc_uuid, mac_id);
 #endif
-  const char* svc_data = jsondata[SVC_DATA].as<const char*>();
-  const char* mfg_data = jsondata[MFG_DATA].as<const char*>();
-  const char* dev_name = jsondata["name"].as<const char*>();
-  const char* svc_uuid = jsondata["servicedatauuid"].as<const char*>();
-  const char* mac_id = jsondata["id"].as<const char*>();
-  int success = -1;
+  PROBE2(device_condition, i_main, match);
+  TRACE(TRACE_DEVICE, match, i_main, -1, -1, 0);
+  return match;
+}
 
-  // if there is no data to decode just return
-  if (svc_data == nullptr && mfg_data == nullptr && dev_name == nullptr) {
-    DEBUG_PRINT("Invalid data\n");
-    return success;
-  }
+/*
+ * @brief Same as above for the condition of a property of the device i_main.
+ */
+bool TheengsDecoder::matchProperty(int i_main, const JsonArray& prop_condition,
+                                   const char* svc_data,
+                                   const char* mfg_data) {
+#ifdef DECODER_PROFILE
+  m_profiled = &m_profile[i_main];
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  bool cond_met = checkPropCondition(prop_condition, svc_data, mfg_data);
+  m_profiled->prop_ns += elapsedNs(start);
+  m_profiled->prop_evaluations++;
+  m_profiled = nullptr;
+  return cond_met;
+#else
+  return checkPropCondition(prop_condition, svc_data, mfg_data);
+#endif
+}
 
-  /* loop through the devices and attempt to match the input data to a device parameter set */
-  for (auto i_main = 0; i_main < sizeof(_devices) / sizeof(_devices[0]); ++i_main) {
-    DeserializationError error = deserializeJson(doc, _devices[i_main][0]);
-    if (error) {
-      DEBUG_PRINT("deserializeJson() failed: %s\n", error.c_str());
-#ifdef UNIT_TESTING
-      assert(0);
+#ifdef DECODER_PROFILE
+/*
+ * @brief Returns the match profile of every model, indexed by BLE_ID_NUM, and their count in *count.
+ */
+const TheengsDecoder::MatchProfile* TheengsDecoder::getMatchProfile(size_t* count) const {
+  *count = BLE_ID_MAX;
+  return m_profile;
+}
+
+void TheengsDecoder::resetMatchProfile() {
+  memset(m_profile, 0, sizeof(m_profile));
+}
 #endif
-      return success;
+
+/*
+ * @brief The members of a definition kept when only its conditions are loaded.
+ */
+static const JsonDocument& conditionFilter() {
+  struct Filter {
+    StaticJsonDocument<64> doc;
+    Filter() {
+      doc["condition"] = true;
+      doc["conditionnomac"] = true;
     }
+  };
+  static Filter filter;
+  return filter.doc;
+}
+
+/*
+ * @brief Loads the definition of the device at index into doc, only its
+ * conditions if condition_only is true.
+ */
+bool TheengsDecoder::loadDevice(JsonDocument& doc, int index, bool condition_only) {
+#ifdef DECODER_MSGPACK_CATALOG
+  size_t size = _devices_msgpack_offsets[index + 1] - _devices_msgpack_offsets[index];
+  DeserializationError error = condition_only
+                                   ? deserializeMsgPack(doc, catalogDefinition(index), size,
+                                                        DeserializationOption::Filter(conditionFilter()))
+                                   : deserializeMsgPack(doc, catalogDefinition(index), size);
+#else
+#  ifdef DECODER_POOLED_CATALOG
+  // on the stack, CATALOG_TEXT_MAX being the longest text of the catalog generated
+  char text[CATALOG_TEXT_MAX];
+  catalogText(_catalog_models[index][0], text);
+  const char* definition = text; // const, for the strings to be copied out of the buffer
+#  else
+  const char* definition = catalogDefinition(index);
+#  endif
+  DeserializationError error = condition_only
+                                   ? deserializeJson(doc, definition, DeserializationOption::Filter(conditionFilter()))
+                                   : deserializeJson(doc, definition);
+#endif
+  if (error) {
+    DEBUG_PRINT("deserializing the device %d failed: %s\n", index, error.c_str());
+#ifdef UNIT_TESTING
+    assert(0);
+#endif
+    return false;
+  }
 #ifdef UNIT_TESTING
-    if (doc.memoryUsage() > peakDocSize)
-      peakDocSize = doc.memoryUsage();
+  if (doc.memoryUsage() > peakDocSize)
+    peakDocSize = doc.memoryUsage();
 #endif
+  return true;
+}
 
-    /* found a match, extract the data */
-    JsonArray selectedCondition;
+/*
+ * @brief Returns the match condition of the device definition loaded in doc.
+ */
+JsonArray TheengsDecoder::deviceCondition(JsonDocument& doc) {
 #ifdef NO_MAC_ADDR
-    if (doc.containsKey("conditionnomac")) {
-      selectedCondition = doc["conditionnomac"];
-    } else {
-      selectedCondition = doc["condition"];
-    }
-#else
-    selectedCondition = doc["condition"];
+  if (doc.containsKey("conditionnomac")) {
+    return doc["conditionnomac"];
+  }
 #endif
-    if (checkDeviceMatch(selectedCondition, svc_data, mfg_data, dev_name, svc_uuid, mac_id)) {
-      jsondata["brand"] = doc["brand"];
-      jsondata["model"] = doc["model"];
-      jsondata["model_id"] = doc["model_id"];
-      if (doc.containsKey("tag")) {
-        doc.add("type");
-        doc["type"] = NULL;
-
-        std::string tagstring = doc["tag"];
-        int type = strtol(tagstring.substr(0, 2).c_str(), NULL, 16);
-
-        switch (type) {
-          case 1:
-            doc["type"] = "THB"; // Termperature, Humidity, Battery
-            break;
-          case 2:
-            doc["type"] = "THBX"; // Termperature, Humidity, Battery, Extra
-            break;
-          case 3:
-            doc["type"] = "BBQ"; // Multip probe temperatures only
-            break;
-          case 4:
-            doc["type"] = "CTMO"; // Contact and/or Motion sensor
-            break;
-          case 5:
-            doc["type"] = "SCALE"; // weight scale
-            break;
-          case 6:
-            doc["type"] = "BCON"; // iBeacon protocol
-            break;
-          case 7:
-            doc["type"] = "ACEL"; // acceleration
-            break;
-          case 8:
-            doc["type"] = "BATT"; // battery
-            break;
-          case 9:
-            doc["type"] = "PLANT"; // plant sensors
-            break;
-          case 10:
-            doc["type"] = "TIRE"; // tire pressure monitoring system
-            break;
-          case 11:
-            doc["type"] = "BODY"; // health monitoring devices
-            break;
-          case 12:
-            doc["type"] = "ENRG"; // energy monitoring devices
-            break;
-          case 13:
-            doc["type"] = "WCVR"; // window covering
-            break;
-          case 14:
-            doc["type"] = "ACTR"; // ON/OFF actuators
-            break;
-          case 15:
-            doc["type"] = "AIR"; // air environmental monitoring devices
-            break;
-          case 16:
-            doc["type"] = "TRACK"; // Bluetooth tracker
-            break;
-          case 17:
-            doc["type"] = "BTN"; // Button
-            break;
-          case 254:
-            doc["type"] = "RMAC"; // random MAC address devices
-            break;
-          case 255:
-            doc["type"] = "UNIQ"; // unique devices
-            break;
-        }
-
-        if (!doc["type"].isNull()) {
-          jsondata["type"] = doc["type"];
-        } else {
-          DEBUG_PRINT("ERROR - no valid device type present in model tag property\n");
-        }
-
-        // Octet Byte[1] bits[7-0] - True/False tags
-        if (tagstring.length() >= 4) {
-          // bits[3-0]
-          uint8_t data = getBinaryData(tagstring[3]);
+  return doc["condition"];
+}
 
-          if (((data >> 0) & 0x01) == 1) { // CIDC - NOT Company ID Compliant
-            doc.add("cidc");
-            doc["cidc"] = false;
-            jsondata["cidc"] = doc["cidc"];
-          }
+namespace {
+/* Model index in the candidate index, on 16 bits unless extra devices make the catalog larger */
+typedef std::conditional<CATALOG_MODELS < UINT16_MAX, uint16_t, uint32_t>::type CandidateModel;
 
-          if (((data >> 1) & 0x01) == 1) { // Active Scanning required
-            doc.add("acts");
-            doc["acts"] = true;
-            jsondata["acts"] = doc["acts"];
-          }
+/* A model with the hash of its key condition, 0 for the models without one, always tried */
+struct KeyedModel {
+  uint32_t key;
+  CandidateModel model;
+};
 
-          if (((data >> 2) & 0x01) == 1) { // Continuous Scanning required
-            doc.add("cont");
-            doc["cont"] = true;
-            jsondata["cont"] = doc["cont"];
-          }
+bool keyBefore(const KeyedModel& a, const KeyedModel& b) {
+  return a.key < b.key;
+}
 
-          if (((data >> 3) & 0x01) == 1) { // Discoverable as Device Tracker
-            doc.add("track");
-            doc["track"] = true;
-            jsondata["track"] = doc["track"];
-          }
+bool keyedBefore(const KeyedModel& a, const KeyedModel& b) {
+  return a.key != b.key ? a.key < b.key : a.model < b.model;
+}
 
-          // bits[7-4]
-          data = getBinaryData(tagstring[2]);
+enum KeyField {
+  KEY_MFG_DATA,
+  KEY_SVC_DATA,
+  KEY_UUID,
+  KEY_NAME,
+  KEY_FIELD_COUNT
+};
+
+const char* const keyFieldNames[KEY_FIELD_COUNT] = {MFG_DATA, SVC_DATA, "uuid", "name"};
+
+/* Where a key condition compares its literal: the field, the index in it and the length compared */
+struct KeyProbe {
+  uint8_t field;
+  uint8_t index;
+  uint8_t len;
+};
+
+// Distinct probes, 26 for the catalog: a model whose key would need one more is always tried
+const size_t MAX_KEY_PROBES = 64;
+
+/* Hash of the literal compared by the probe, never 0 */
+uint32_t keyHash(const KeyProbe& probe, const char* literal) {
+  const char where[] = {static_cast<char>(probe.field), static_cast<char>(probe.index), static_cast<char>(probe.len)};
+  uint32_t hash = fnv1a(literal, probe.len, fnv1a(where, sizeof(where)));
+  return hash != 0 ? hash : 1;
+}
 
-          if (((data >> 0) & 0x01) == 1) { // PRMAC - Potential RMAC device - if not defined with Identity MAC and IRK in Theengs Gateway
-            doc.add("prmac");
-            doc["prmac"] = true;
-            jsondata["prmac"] = doc["prmac"];
-          }
+/*
+ * The models an advertisement is tried against, in catalog order: all of
+ * them, or the merge of the runs of the candidate index its keys select.
+ */
+struct ModelWalk {
+  struct Run {
+    const KeyedModel* begin;
+    const KeyedModel* end;
+  };
+
+  bool all = true;
+  int model = -1; // the last one returned
+  Run runs[MAX_KEY_PROBES + 1];
+  size_t run_count = 0;
+
+  /* The next model to try, -1 at the end */
+  int next() {
+    if (all) {
+      return ++model < static_cast<int>(CATALOG_MODELS) ? model : -1;
+    }
+    for (;;) {
+      Run* first = nullptr;
+      for (size_t r = 0; r < run_count; ++r) {
+        if (runs[r].begin != runs[r].end && (first == nullptr || runs[r].begin->model < first->begin->model)) {
+          first = &runs[r];
         }
+      }
+      if (first == nullptr) {
+        return -1;
+      }
+      // two probes whose hashes collide select the same run, its models are tried once
+      int candidate = first->begin++->model;
+      if (candidate != model) {
+        model = candidate;
+        return model;
+      }
+    }
+  }
+};
+} // namespace
 
-        // Octet Byte[2] - Encryption Model
-        if (tagstring.length() >= 6) {
-          int encrmode = strtol(tagstring.substr(4, 2).c_str(), NULL, 16);
-          DEBUG_PRINT("encrmode: %d\n", encrmode);
-          if (encrmode > 0) {
-            doc.add("encr");
-            doc["encr"] = encrmode;
-            jsondata["encr"] = doc["encr"];
-          }
-        }
+/*
+ * Every model of the catalog with the hash of its key, the longest literal
+ * its condition compares at an index of a field when all the clauses of the
+ * condition must hold. An advertisement that does not hold this literal
+ * cannot match the model, which ENGINE_INDEXED then skips, so that the models
+ * tried barely grow with the catalog. Built once on first use, in static
+ * storage as the catalog is.
+ */
+struct TheengsDecoder::CandidateIndex {
+  KeyedModel models[CATALOG_MODELS]; // the models compiled in, by key then model
+  size_t model_count = 0;
+  KeyProbe probes[MAX_KEY_PROBES];
+  size_t probe_count = 0;
+
+  CandidateIndex(TheengsDecoder& decoder, JsonDocument& doc) {
+    for (size_t i = 0; i < CATALOG_MODELS; ++i) {
+      if (!catalogSelected(i)) {
+        continue;
       }
+      KeyedModel& keyed = models[model_count++];
+      keyed.model = static_cast<CandidateModel>(i);
+      keyed.key = 0;
+      KeyProbe probe;
+      const char* literal;
+      // a definition that cannot be parsed is always tried, for the walk to report it
+      if (decoder.loadDevice(doc, static_cast<int>(i), true) &&
+          conditionKey(decoder.deviceCondition(doc), probe, literal) && addProbe(probe)) {
+        keyed.key = keyHash(probe, literal);
+      }
+    }
+    std::sort(models, models + model_count, keyedBefore);
+    doc.clear();
+    PROBE1(catalog_build, "candidates");
+  }
 
-      JsonObject properties = doc["properties"];
+  /*
+   * @brief Finds the key of a condition, the longest literal of its clauses
+   * comparing a field at an index, if "&" joins all the clauses: without "|"
+   * or nested conditions. Returns false if it has none.
+   */
+  static bool conditionKey(const JsonArray& condition, KeyProbe& key, const char*& key_literal) {
+    size_t size = condition.size();
+    for (size_t i = 0; i < size; ++i) {
+      const char* token = condition[i].as<const char*>();
+      if (condition[i].is<JsonArray>() || (token != nullptr && *token == '|')) {
+        return false;
+      }
+    }
+    bool found = false;
+    for (size_t begin = 0; begin < size;) {
+      size_t end = begin;
+      while (end < size && !isAnd(condition[end].as<const char*>())) {
+        ++end;
+      }
+      KeyProbe probe;
+      const char* literal;
+      if (clauseKey(condition, begin, end, probe, literal) && (!found || probe.len > key.len)) {
+        key = probe;
+        key_literal = literal;
+        found = true;
+      }
+      begin = end + 1;
+    }
+    return found;
+  }
 
-      /* Loop through all the devices properties and extract the values */
-      for (JsonPair kv : properties) {
-        JsonObject prop = kv.value().as<JsonObject>();
+  static bool isAnd(const char* token) {
+    return token != nullptr && *token == '&';
+  }
 
-        if (checkPropCondition(prop["condition"], svc_data, mfg_data)) {
-          JsonArray decoder = prop["decoder"];
-          if (strstr((const char*)decoder[0], "value_from_hex_data") != nullptr) {
-            const char* src = svc_data;
-            if (strstr((const char*)decoder[1], MFG_DATA)) {
-              src = mfg_data;
-            }
+  /*
+   * @brief Reads the clause from begin to end as checkDeviceMatch does if it
+   * is a field, with an optional data length condition, compared to a
+   * literal at an index. Returns false for any other clause.
+   */
+  static bool clauseKey(const JsonArray& condition, size_t begin, size_t end, KeyProbe& probe, const char*& literal) {
+    const char* field = condition[begin].as<const char*>();
+    int f = 0;
+    while (field != nullptr && f < KEY_FIELD_COUNT && strcmp(field, keyFieldNames[f]) != 0) {
+      ++f;
+    }
+    if (field == nullptr || f == KEY_FIELD_COUNT) {
+      return false;
+    }
+    size_t i = begin + 1;
+    const char* op = i < end ? condition[i].as<const char*>() : nullptr;
+    if ((f == KEY_MFG_DATA || f == KEY_SVC_DATA) && i + 1 < end && op != nullptr && strlen(op) <= 2 &&
+        condition[i + 1].is<size_t>()) {
+      i += 2;
+    }
+    const char* index = condition[i].as<const char*>();
+    if (end - i != 3 || index == nullptr || strcmp(index, "index") != 0 || !condition[i + 1].is<size_t>()) {
+      return false;
+    }
+    size_t at = condition[i + 1].as<size_t>();
+    literal = condition[i + 2].as<const char*>();
+    if (literal == nullptr || *literal == '!' || *literal == '\0' || strlen(literal) > UINT8_MAX || at > UINT8_MAX) {
+      return false;
+    }
+    probe.field = static_cast<uint8_t>(f);
+    probe.index = static_cast<uint8_t>(at);
+    probe.len = static_cast<uint8_t>(strlen(literal));
+    return true;
+  }
 
-            /* use a double for all values and cast later if required */
-            double temp_val;
-            static double cal_val = 0;
-            std::string proc_str = "";
+  bool addProbe(const KeyProbe& probe) {
+    for (size_t p = 0; p < probe_count; ++p) {
+      if (probes[p].field == probe.field && probes[p].index == probe.index && probes[p].len == probe.len) {
+        return true;
+      }
+    }
+    if (probe_count == MAX_KEY_PROBES) {
+      return false;
+    }
+    probes[probe_count++] = probe;
+    return true;
+  }
 
-            if (data_index_is_valid(src, decoder[2].as<int>(), decoder[3].as<int>())) {
-              decoder_function dec_fun = &TheengsDecoder::value_from_hex_string;
+  /*
+   * @brief Sets walk to the models without a key and those whose key the
+   * fields hold, the values being compared as checkDeviceMatch does.
+   */
+  void select(const AdvertFields& fields, ModelWalk& walk) const {
+    walk.all = false;
+    addRun(0, walk);
+    const char* values[KEY_FIELD_COUNT] = {fields.mfg_data, fields.svc_data, fields.svc_uuid, fields.dev_name};
+    if (values[KEY_UUID] != nullptr && !strncmp(values[KEY_UUID], "0x", 2)) {
+      values[KEY_UUID] += 2;
+    }
+    size_t lengths[KEY_FIELD_COUNT];
+    for (int f = 0; f < KEY_FIELD_COUNT; ++f) {
+      lengths[f] = values[f] != nullptr ? strlen(values[f]) : 0;
+    }
+    for (size_t p = 0; p < probe_count; ++p) {
+      const KeyProbe& probe = probes[p];
+      if (values[probe.field] != nullptr && lengths[probe.field] >= static_cast<size_t>(probe.index) + probe.len) {
+        addRun(keyHash(probe, values[probe.field] + probe.index), walk);
+      }
+    }
+  }
+
+  void addRun(uint32_t key, ModelWalk& walk) const {
+    KeyedModel bound = {key, 0};
+    std::pair<const KeyedModel*, const KeyedModel*> run = std::equal_range(models, models + model_count, bound, keyBefore);
+    if (run.first != run.second) {
+      walk.runs[walk.run_count++] = {run.first, run.second};
+    }
+  }
+};
+
+/*
+ * @brief Returns the candidate index, built on the first call with doc to
+ * parse the conditions of the catalog into.
+ */
+const TheengsDecoder::CandidateIndex& TheengsDecoder::candidateIndex(JsonDocument& doc) {
+  static CandidateIndex index(*this, doc);
+  return index;
+}
+
+namespace {
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t StatValue;
+#else
+typedef uint32_t StatValue; // lock free on the 32 bit targets
+#endif
+typedef std::atomic<StatValue> StatCounter;
+
+/* The counters behind TheengsDecoder::Stats, zero initialized as static storage */
+struct StatCounters {
+  StatCounter adverts;
+  StatCounter matches;
+  StatCounter rejects;
+  StatCounter reject_reasons[TheengsDecoder::REJECT_REASON_COUNT];
+  StatCounter truncated;
+  StatCounter model_matches[TheengsDecoder::BLE_ID_MAX];
+  StatCounter latency[TheengsDecoder::STATS_LATENCY_BUCKETS];
+  StatCounter latency_sum_us; // in microseconds, a 32 bit counter wrapping after 71 minutes of decoding
+};
+
+StatCounters stat_counters;
+
+typedef std::chrono::steady_clock StatsClock;
+
+// Relaxed: the counters order nothing, decoders on several threads only share their cache lines
+void countStat(StatCounter& counter) {
+  counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t readStat(StatCounter& counter, bool reset) {
+  return reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+}
+
+void countDecode(StatsClock::time_point start, int model, int reason, bool trace) {
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count();
+  PROBE3(decode_end, model, ns, reason);
+  if (trace) {
+    traceRecord(TheengsDecoder::TRACE_DECODE_END, reason < 0 ? 0xff : reason, model, -1, -1,
+                ns > INT32_MAX ? INT32_MAX : static_cast<int32_t>(ns));
+  }
+  int bucket = 0;
+  while (bucket < TheengsDecoder::STATS_LATENCY_BUCKETS - 1 && ns >= (512ULL << bucket)) {
+    bucket++;
+  }
+  countStat(stat_counters.adverts);
+  countStat(stat_counters.latency[bucket]);
+  stat_counters.latency_sum_us.fetch_add(static_cast<StatValue>((ns + 500) / 1000), std::memory_order_relaxed);
+}
+
+void countMatch(int model, StatsClock::time_point start, bool trace) {
+  countDecode(start, model, -1, trace);
+  countStat(stat_counters.matches);
+  if (model < TheengsDecoder::BLE_ID_MAX) {
+    countStat(stat_counters.model_matches[model]);
+  }
+}
+
+void countReject(TheengsDecoder::RejectReason reason, StatsClock::time_point start, bool trace) {
+  countDecode(start, -1, reason, trace);
+  countStat(stat_counters.rejects);
+  countStat(stat_counters.reject_reasons[reason]);
+}
+} // namespace
+
+/*
+ * @brief Copies the counters of all the decoders into stats, resetting each
+ * one as it is read if reset is true so that no decode is lost between the
+ * snapshot and the reset. The counters are read one by one: decodes running
+ * meanwhile may be counted in some of them only.
+ */
+void TheengsDecoder::getStats(Stats& stats, bool reset) {
+  stats.adverts = readStat(stat_counters.adverts, reset);
+  stats.matches = readStat(stat_counters.matches, reset);
+  stats.rejects = readStat(stat_counters.rejects, reset);
+  for (int i = 0; i < REJECT_REASON_COUNT; ++i) {
+    stats.reject_reasons[i] = readStat(stat_counters.reject_reasons[i], reset);
+  }
+  stats.truncated = readStat(stat_counters.truncated, reset);
+  for (int i = 0; i < BLE_ID_MAX; ++i) {
+    stats.model_matches[i] = readStat(stat_counters.model_matches[i], reset);
+  }
+  for (int i = 0; i < STATS_LATENCY_BUCKETS; ++i) {
+    stats.latency[i] = readStat(stat_counters.latency[i], reset);
+  }
+  stats.latency_sum_us = readStat(stat_counters.latency_sum_us, reset);
+}
+
+void TheengsDecoder::resetStats() {
+  Stats stats;
+  getStats(stats, true);
+}
+
+/*
+ * @brief Returns the snake case name of a RejectReason, nullptr if out of range.
+ */
+const char* TheengsDecoder::getRejectReasonName(int reason) {
+  static const char* const names[REJECT_REASON_COUNT] =
+      {"no_data", "too_short", "invalid_index", "catalog_error", "no_properties", "no_match", "too_many_entries"};
+  return reason >= 0 && reason < REJECT_REASON_COUNT ? names[reason] : nullptr;
+}
+
+/*
+ * @brief Returns why the advertisement whose walk of the catalog just ended
+ * without a match was not decoded.
+ */
+TheengsDecoder::RejectReason TheengsDecoder::rejectReason(const char* svc_data, const char* mfg_data) {
+  if (m_indexRejected) {
+    return REJECT_INVALID_INDEX;
+  }
+  bool svc_short = svc_data == nullptr || strlen(svc_data) < m_minSvcDataLen;
+  bool mfg_short = mfg_data == nullptr || strlen(mfg_data) < m_minMfgDataLen;
+  if ((svc_data != nullptr || mfg_data != nullptr) && svc_short && mfg_short) {
+    return REJECT_TOO_SHORT;
+  }
+  return REJECT_NO_MATCH;
+}
+
+#ifndef DECODER_NO_HEAP
+/*
+ * @brief Compares the input json values to the known devices and
+ * decodes the data if a match is found.
+ */
+int TheengsDecoder::decodeBLEJson(JsonObject& jsondata) {
+  // several service data entries, each one is matched on its own
+  if (jsondata[SVC_DATA].is<JsonArray>()) {
+#  ifdef UNIT_TESTING
+    DynamicJsonDocument doc(TEST_MAX_DOC);
+#  else
+    DynamicJsonDocument doc(m_docMax);
+#  endif
+    return decodeBLEJson(doc, jsondata);
+  }
+
+  return decodeBLE(jsondata,
+                   jsondata[SVC_DATA].as<const char*>(),
+                   jsondata[MFG_DATA].as<const char*>(),
+                   jsondata["name"].as<const char*>(),
+                   jsondata["servicedatauuid"].as<const char*>(),
+                   jsondata["id"].as<const char*>());
+}
+#endif
+
+/*
+ * @brief Same as above, doc holding the device definitions while matching,
+ * as for decodeBLE(doc, ...).
+ */
+int TheengsDecoder::decodeBLEJson(JsonDocument& doc, JsonObject& jsondata) {
+  if (jsondata[SVC_DATA].is<JsonArray>()) {
+    AdvertFields fields = {nullptr, jsondata[MFG_DATA].as<const char*>(), jsondata["name"].as<const char*>(),
+                           nullptr, jsondata["id"].as<const char*>(), true};
+    return decodeAdvert(doc, jsondata, fields);
+  }
+
+  return decodeBLE(doc, jsondata,
+                   jsondata[SVC_DATA].as<const char*>(),
+                   jsondata[MFG_DATA].as<const char*>(),
+                   jsondata["name"].as<const char*>(),
+                   jsondata["servicedatauuid"].as<const char*>(),
+                   jsondata["id"].as<const char*>());
+}
+
+#ifndef DECODER_NO_HEAP
+/*
+ * @brief Compares the advertisement fields to the known devices and
+ * adds the decoded data to jsondata if a match is found.
+ * The fields are not read from jsondata, which can be an empty object.
+ */
+int TheengsDecoder::decodeBLE(JsonObject& jsondata,
+                              const char* svc_data,
+                              const char* mfg_data,
+                              const char* dev_name,
+                              const char* svc_uuid,
+                              const char* mac_id) {
+#  ifdef UNIT_TESTING
+  DynamicJsonDocument doc(TEST_MAX_DOC);
+#  else
+  DynamicJsonDocument doc(m_docMax);
+#  endif
+  return decodeBLE(doc, jsondata, svc_data, mfg_data, dev_name, svc_uuid, mac_id);
+}
+#endif
+
+/*
+ * @brief Same as above, doc holding the device definitions while matching;
+ * reusing it across calls avoids allocating one per advertisement.
+ * Its capacity should be at least getDocMax().
+ */
+int TheengsDecoder::decodeBLE(JsonDocument& doc,
+                              JsonObject& jsondata,
+                              const char* svc_data,
+                              const char* mfg_data,
+                              const char* dev_name,
+                              const char* svc_uuid,
+                              const char* mac_id) {
+  AdvertFields fields = {svc_data, mfg_data, dev_name, svc_uuid, mac_id, false};
+  return decodeAdvert(doc, jsondata, fields);
+}
+
+/*
+ * The outcome of the shadow engine on an advertisement, compared once the
+ * engine decoded it, and the buffers reused from one shadow decode to the next
+ */
+struct TheengsDecoder::ShadowRun {
+  explicit ShadowRun(size_t capacity) : copy(capacity), fields(256) {
+    advert.reserve(256);
+    decoded.reserve(1024);
+    engine_decoded.reserve(1024);
+  }
+
+  DynamicJsonDocument copy; // jsondata, decoded by the shadow engine
+  DynamicJsonDocument fields; // the fields matched, when jsondata need not hold them
+  StatsClock::time_point start;
+  int model;
+  uint64_t ns;
+  std::string advert;
+  std::string decoded;
+  std::string engine_decoded; // jsondata once decoded by the engine
+};
+
+TheengsDecoder::TheengsDecoder() {
+#ifdef DECODER_NO_HEAP
+  m_docMax = DECODER_DOC_SIZE;
+#endif
+#ifdef DECODER_FIXED_POINT
+  m_fixedPoint = true;
+#endif
+}
+
+TheengsDecoder::~TheengsDecoder() {}
+
+/*
+ * @brief Decodes the advertisement with the engine, counting it in the stats,
+ * and with the shadow engine too when it is sampled and the budget allows it.
+ */
+int TheengsDecoder::decodeAdvert(JsonDocument& doc, JsonObject& jsondata, const AdvertFields& fields) {
+  bool shadowed = false;
+  if (m_shadowBudget > 0) {
+    m_shadowSample += m_shadowRate;
+    if (m_shadowSample < 1) {
+      m_shadowStats.unsampled++;
+    } else if (m_shadowCostNs <= m_shadowBudget * m_shadowDecodeNs) {
+      m_shadowSample -= 1;
+      shadowed = runShadow(doc, jsondata, fields, *m_shadowRun);
+    } else {
+      m_shadowSample -= 1;
+      m_shadowStats.skipped++;
+    }
+  }
+
+  StatsClock::time_point start = StatsClock::now();
+  PROBE3(decode_start, fields.svc_data, fields.mfg_data, fields.dev_name);
+  TRACE(TRACE_DECODE_START, 0, -1, -1, traceLength(fields.svc_data), traceLength(fields.mfg_data));
+  RejectReason reason = REJECT_NO_MATCH;
+  int success = matchAdvert(m_engine, doc, jsondata, fields, &reason);
+  if (success >= 0) {
+    countMatch(success, start, m_trace);
+  } else {
+    countReject(reason, start, m_trace);
+  }
+  if (fields.entries && jsondata[SVC_DATA].size() > MAX_SVC_DATA_ENTRIES) {
+    countStat(stat_counters.truncated);
+  }
+
+  if (m_shadowBudget > 0) {
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count();
+    m_shadowDecodeNs += ns;
+    if (shadowed) {
+      compareShadow(jsondata, success, ns, *m_shadowRun);
+    }
+  }
+  return success;
+}
+
+/*
+ * @brief Walks the catalog with the engine and adds the decoded data of the
+ * model matched to jsondata, returning its index or -1 with the reason in *reason.
+ */
+int TheengsDecoder::matchAdvert(MatchEngine engine, JsonDocument& doc, JsonObject& jsondata,
+                                const AdvertFields& fields, RejectReason* reason) {
+  m_indexRejected = false;
+  if (fields.entries) {
+    return matchServiceDataEntries(engine, doc, jsondata, fields, reason);
+  }
+
+  // if there is no data to decode just return
+  if (fields.svc_data == nullptr && fields.mfg_data == nullptr && fields.dev_name == nullptr) {
+    DEBUG_PRINT("Invalid data\n");
+    *reason = REJECT_NO_DATA;
+    return -1;
+  }
+
+  bool condition_only = engine != ENGINE_REFERENCE;
+  ModelWalk walk;
+  if (engine == ENGINE_INDEXED) {
+    candidateIndex(doc).select(fields, walk);
+  }
+  /* loop through the devices and attempt to match the input data to a device parameter set */
+  for (int i_main = walk.next(); i_main >= 0; i_main = walk.next()) {
+    if (!catalogSelected(i_main) || !modelEnabled(i_main)) {
+      continue;
+    }
+    if (!loadDevice(doc, i_main, condition_only)) {
+      *reason = REJECT_CATALOG_ERROR;
+      return -1;
+    }
+
+    /* found a match, extract the data */
+    if (matchDevice(i_main, deviceCondition(doc), fields.svc_data, fields.mfg_data, fields.dev_name,
+                    fields.svc_uuid, fields.mac_id)) {
+      if (condition_only && !loadDevice(doc, i_main)) {
+        *reason = REJECT_CATALOG_ERROR;
+        return -1;
+      }
+      int success = decodeDeviceProperties(doc, i_main, jsondata, fields.svc_data, fields.mfg_data);
+      *reason = REJECT_NO_PROPERTIES;
+      return success;
+    }
+  }
+  *reason = rejectReason(fields.svc_data, fields.mfg_data);
+  return -1;
+}
+
+namespace {
+/* Whether a property of the device definition loaded in doc decodes the service data */
+bool decodesServiceData(JsonDocument& doc) {
+  for (JsonPair kv : doc["properties"].as<JsonObject>()) {
+    const char* source = kv.value()["decoder"][1].as<const char*>();
+    if (source != nullptr && strstr(source, SVC_DATA) != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+/*
+ * @brief Decodes an advertisement whose "servicedata" is an array of
+ * {"servicedatauuid", "servicedata"} entries. The devices are walked once,
+ * the manufacturer data and name are shared by all the entries and each entry
+ * is matched on its own; the decoded values of an entry are added to it.
+ * Devices matching without any service data are decoded into jsondata itself,
+ * unless they decode service data too and an entry is left for them.
+ * Only the first MAX_SVC_DATA_ENTRIES entries are matched, the advertisement
+ * being rejected with REJECT_TOO_MANY_ENTRIES if none of them nor jsondata decodes.
+ * Returns the model index of the first match, jsondata first then the entries in order.
+ */
+int TheengsDecoder::matchServiceDataEntries(MatchEngine engine, JsonDocument& doc, JsonObject& jsondata,
+                                            const AdvertFields& fields, RejectReason* reason) {
+  JsonArray entries = jsondata[SVC_DATA];
+  const char* mfg_data = fields.mfg_data;
+  const char* dev_name = fields.dev_name;
+  const char* mac_id = fields.mac_id;
+  int results[MAX_SVC_DATA_ENTRIES + 1];
+  int pending = 0;
+  bool truncated = entries.size() > MAX_SVC_DATA_ENTRIES;
+  int entry_count = truncated ? MAX_SVC_DATA_ENTRIES : entries.size();
+  if (truncated) {
+    DEBUG_PRINT("%d service data entries, the last %d left out\n", static_cast<int>(entries.size()),
+                static_cast<int>(entries.size()) - MAX_SVC_DATA_ENTRIES);
+  }
+
+  // candidate 0 is the advertisement without service data, 1..n are the entries
+  bool bare_data = mfg_data != nullptr || dev_name != nullptr;
+  for (int c = 0; c <= entry_count; ++c) {
+    results[c] = -1;
+    if (c == 0 ? bare_data : entries[c - 1][SVC_DATA].is<const char*>()) {
+      pending++;
+    } else {
+      results[c] = -2; // nothing to match
+    }
+  }
+
+  int candidates = pending;
+  bool catalog_error = false;
+  bool no_properties = false;
+  bool condition_only = engine != ENGINE_REFERENCE; // ENGINE_INDEXED walking every model here
+  for (auto i_main = 0; pending > 0 && i_main < CATALOG_MODELS; ++i_main) {
+    if (!catalogSelected(i_main) || !modelEnabled(i_main)) {
+      continue;
+    }
+    if (!loadDevice(doc, i_main, condition_only)) {
+      catalog_error = true;
+      break;
+    }
+
+    JsonArray condition = deviceCondition(doc);
+    bool loaded = !condition_only;
+
+    /* a device matching without service data takes an entry only if it decodes service data */
+    bool bare_match = bare_data && matchDevice(i_main, condition, nullptr, mfg_data, dev_name, nullptr, mac_id);
+    if (bare_match) {
+      if (!loaded && !loadDevice(doc, i_main)) {
+        catalog_error = true;
+        break;
+      }
+      loaded = true;
+      condition = deviceCondition(doc);
+    }
+
+    int claimed = 0;
+    if (!bare_match || decodesServiceData(doc)) {
+      for (int c = 1; c <= entry_count; ++c) {
+        if (results[c] != -1) {
+          continue;
+        }
+        JsonObject entry = entries[c - 1];
+        const char* svc_data = entry[SVC_DATA].as<const char*>();
+        const char* svc_uuid = entry["servicedatauuid"].as<const char*>();
+
+        if (matchDevice(i_main, condition, svc_data, mfg_data, dev_name, svc_uuid, mac_id)) {
+          if (!loaded && !loadDevice(doc, i_main)) {
+            catalog_error = true;
+            pending = 0;
+            break;
+          }
+          results[c] = decodeDeviceProperties(doc, i_main, entry, svc_data, mfg_data);
+          no_properties |= results[c] < 0;
+          pending--;
+          claimed = c;
+          break;
+        }
+      }
+    }
+
+    if (bare_match && claimed == 0 && results[0] == -1) {
+      results[0] = decodeDeviceProperties(doc, i_main, jsondata, nullptr, mfg_data);
+      no_properties |= results[0] < 0;
+      pending--;
+    }
+  }
+
+  for (int c = 0; c <= entry_count; ++c) {
+    if (results[c] >= 0) {
+      return results[c];
+    }
+  }
+  if (candidates == 0 && !truncated) {
+    *reason = REJECT_NO_DATA;
+  } else if (catalog_error) {
+    *reason = REJECT_CATALOG_ERROR;
+  } else if (truncated) {
+    *reason = REJECT_TOO_MANY_ENTRIES;
+  } else if (no_properties) {
+    *reason = REJECT_NO_PROPERTIES;
+  } else {
+    *reason = rejectReason(nullptr, mfg_data);
+  }
+  return -1;
+}
+
+/*
+ * @brief Compares the share rate of the advertisements decoded by the engine
+ * to their decoding by the shadow engine, which may take budget times the
+ * time spent decoding, the copying and comparing of the results included.
+ * The shadow decodes are not counted in the stats nor traced, and reuse the
+ * buffers allocated here until the shadow is turned off. Without a heap,
+ * with DECODER_NO_HEAP, the shadow engine stays off.
+ */
+void TheengsDecoder::setShadow(MatchEngine shadow, float budget, ShadowReport report, float rate) {
+  m_shadow = shadow;
+#ifdef DECODER_NO_HEAP
+  m_shadowBudget = 0;
+  (void)budget;
+#else
+  m_shadowBudget = budget > 0 && rate > 0 ? budget : 0;
+#endif
+  m_shadowReport = report;
+  m_shadowRate = rate < 1 ? rate : 1;
+  m_shadowSample = 0;
+  m_shadowDecodeNs = 0;
+  m_shadowCostNs = 0;
+  if (m_shadowBudget == 0) {
+    m_shadowRun.reset();
+  } else if (!m_shadowRun) {
+    m_shadowRun.reset(new ShadowRun(m_docMax));
+  }
+}
+
+void TheengsDecoder::getShadowStats(ShadowStats& stats, bool reset) {
+  stats = m_shadowStats;
+  if (reset) {
+    m_shadowStats = ShadowStats();
+  }
+}
+
+/*
+ * @brief Decodes a copy of jsondata with the shadow engine into run, before
+ * the engine decodes jsondata itself. Returns false if the copy does not fit.
+ */
+bool TheengsDecoder::runShadow(JsonDocument& doc, JsonObject& jsondata, const AdvertFields& fields, ShadowRun& run) {
+  run.start = StatsClock::now();
+  run.copy.clear();
+  run.copy.set(jsondata);
+  run.advert.clear();
+  if (fields.entries) {
+    serializeJson(run.copy, run.advert);
+  } else {
+    // jsondata need not hold the fields matched
+    run.fields.clear();
+    const char* const keys[] = {"id", "name", "servicedatauuid", SVC_DATA, MFG_DATA};
+    const char* const values[] = {fields.mac_id, fields.dev_name, fields.svc_uuid, fields.svc_data, fields.mfg_data};
+    for (int i = 0; i < 5; ++i) {
+      if (values[i] != nullptr) {
+        run.fields[keys[i]] = values[i];
+      }
+    }
+    serializeJson(run.fields, run.advert);
+  }
+  JsonObject shadow_data = run.copy.as<JsonObject>();
+  bool trace = m_trace;
+  m_trace = false;
+  StatsClock::time_point start = StatsClock::now();
+  RejectReason reason;
+  run.model = matchAdvert(m_shadow, doc, shadow_data, fields, &reason);
+  run.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count();
+  m_trace = trace;
+  bool fits = !run.copy.overflowed();
+  run.decoded.clear();
+  if (fits) {
+    serializeJson(run.copy, run.decoded);
+  } else {
+    m_shadowStats.skipped++;
+  }
+  m_shadowCostNs += std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - run.start).count();
+  return fits;
+}
+
+/*
+ * @brief Counts and reports the differences between jsondata decoded by the
+ * engine and the shadow run.
+ */
+void TheengsDecoder::compareShadow(JsonObject& jsondata, int model, uint64_t ns, ShadowRun& run) {
+  StatsClock::time_point start = StatsClock::now();
+  std::string& decoded = run.engine_decoded;
+  decoded.clear();
+  serializeJson(jsondata, decoded);
+  m_shadowStats.compared++;
+  m_shadowStats.ns += ns;
+  m_shadowStats.shadow_ns += run.ns;
+  bool model_mismatch = model != run.model;
+  if (model_mismatch || decoded != run.decoded) {
+    if (model_mismatch) {
+      m_shadowStats.model_mismatches++;
+    } else {
+      m_shadowStats.json_mismatches++;
+    }
+    DEBUG_PRINT("shadow mismatch on %s: engine %d model %d %s, engine %d model %d %s\n", run.advert.c_str(),
+                m_engine, model, decoded.c_str(), m_shadow, run.model, run.decoded.c_str());
+    if (m_shadowReport != nullptr) {
+      ShadowMismatch mismatch = {m_engine, m_shadow, model, run.model, run.advert.c_str(), decoded.c_str(),
+                                 run.decoded.c_str(), ns, run.ns};
+      m_shadowReport(mismatch);
+    }
+  }
+  m_shadowCostNs += std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count();
+}
+
+/*
+ * @brief Returns the device type of the first octet of a model tag, nullptr if unknown.
+ */
+static const char* tagType(int type) {
+  switch (type) {
+    case 1: return "THB"; // Termperature, Humidity, Battery
+    case 2: return "THBX"; // Termperature, Humidity, Battery, Extra
+    case 3: return "BBQ"; // Multip probe temperatures only
+    case 4: return "CTMO"; // Contact and/or Motion sensor
+    case 5: return "SCALE"; // weight scale
+    case 6: return "BCON"; // iBeacon protocol
+    case 7: return "ACEL"; // acceleration
+    case 8: return "BATT"; // battery
+    case 9: return "PLANT"; // plant sensors
+    case 10: return "TIRE"; // tire pressure monitoring system
+    case 11: return "BODY"; // health monitoring devices
+    case 12: return "ENRG"; // energy monitoring devices
+    case 13: return "WCVR"; // window covering
+    case 14: return "ACTR"; // ON/OFF actuators
+    case 15: return "AIR"; // air environmental monitoring devices
+    case 16: return "TRACK"; // Bluetooth tracker
+    case 17: return "BTN"; // Button
+    case 254: return "RMAC"; // random MAC address devices
+    case 255: return "UNIQ"; // unique devices
+  }
+  return nullptr;
+}
+
+static uint8_t tagNibble(char ch) {
+  if (ch >= '0' && ch <= '9')
+    return ch - '0';
+  if (ch >= 'a' && ch <= 'f')
+    return 10 + (ch - 'a');
+  return 0;
+}
+
+/*
+ * @brief Returns the TagFlag bits of the second octet of a model tag.
+ */
+static uint8_t tagFlags(const char* tag) {
+  uint8_t flags = 0;
+  if (strlen(tag) >= 4) {
+    flags = tagNibble(tag[3]) & 0x0f; // bits[3-0], in the TagFlag order
+    if (tagNibble(tag[2]) & 0x01) { // bits[7-4]
+      flags |= TheengsDecoder::TAG_PRMAC;
+    }
+  }
+  return flags;
+}
+
+/*
+ * @brief Returns the encryption mode of the third octet of a model tag, 0 if none.
+ */
+static int tagEncr(const char* tag) {
+  if (strlen(tag) < 6) {
+    return 0;
+  }
+  return tagNibble(tag[4]) << 4 | tagNibble(tag[5]);
+}
+
+/*
+ * A value of the fixed-point mode, m * 10^-e with e from 0 to
+ * FIXED_DECIMALS: the integers extracted from the data, scaled by the
+ * decimal constants of the post_proc operations. The operations return false
+ * when the result does not fit, the property being then decoded in double.
+ */
+struct TheengsDecoder::FixedValue {
+  int64_t m;
+  int e;
+};
+
+namespace {
+typedef TheengsDecoder::FixedValue Fixed;
+
+/* Decimals the values keep, the more being rounded */
+const int FIXED_DECIMALS = 15;
+/* The values ArduinoJson prints a double of with an exponent, from 1e7 up and 1e-5 down */
+const int64_t FIXED_INTEGER_LIMIT = 10000000LL;
+const Fixed FIXED_EXPONENT_BELOW = {1, 5};
+/* The decimals ArduinoJson prints of a double below 10, one less for each further integral digit */
+const int FIXED_PRINTED_DECIMALS = 9;
+
+const int64_t fixedPow10[19] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+    10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL, 100000000000000LL,
+    1000000000000000LL, 10000000000000000LL, 100000000000000000LL, 1000000000000000000LL};
+
+/* The largest magnitude that can be multiplied by 10^k */
+const int64_t fixedLimit[19] = {
+    INT64_MAX, INT64_MAX / 10, INT64_MAX / 100, INT64_MAX / 1000, INT64_MAX / 10000, INT64_MAX / 100000,
+    INT64_MAX / 1000000, INT64_MAX / 10000000, INT64_MAX / 100000000, INT64_MAX / 1000000000,
+    INT64_MAX / 10000000000LL, INT64_MAX / 100000000000LL, INT64_MAX / 1000000000000LL,
+    INT64_MAX / 10000000000000LL, INT64_MAX / 100000000000000LL, INT64_MAX / 1000000000000000LL,
+    INT64_MAX / 10000000000000000LL, INT64_MAX / 100000000000000000LL, INT64_MAX / 1000000000000000000LL};
+
+int64_t fixedAbs(int64_t m) {
+  return m < 0 ? -m : m;
+}
+
+/* m / d rounded half away from zero, as ArduinoJson rounds the decimals it prints, d > 0 */
+int64_t fixedRoundDiv(int64_t m, int64_t d) {
+  int64_t q = m / d;
+  if (fixedAbs(m % d) >= d - fixedAbs(m % d)) {
+    q += m < 0 ? -1 : 1;
+  }
+  return q;
+}
+
+/* Rounds v to at most decimals, dropping its trailing decimal zeros */
+void fixedRound(Fixed& v, int decimals = FIXED_DECIMALS) {
+  if (v.e > decimals) {
+    v.m = fixedRoundDiv(v.m, fixedPow10[v.e - decimals]);
+    v.e = decimals;
+  }
+  while (v.e > 0 && v.m % 10 == 0) {
+    v.m /= 10;
+    v.e--;
+  }
+}
+
+bool fixedScale(Fixed& v, int e) {
+  if (e - v.e > 18 || fixedAbs(v.m) > fixedLimit[e - v.e]) {
+    return false;
+  }
+  v.m *= fixedPow10[e - v.e];
+  v.e = e;
+  return true;
+}
+
+bool fixedAdd(Fixed& a, Fixed b) {
+  // the exact sum, or the operand having the most decimals rounded first while it overflows
+  for (;;) {
+    Fixed x = a;
+    Fixed y = b;
+    int e = a.e > b.e ? a.e : b.e;
+    if (fixedScale(x, e) && fixedScale(y, e) && (y.m > 0 ? x.m <= INT64_MAX - y.m : x.m >= -INT64_MAX - y.m)) {
+      a.m = x.m + y.m;
+      a.e = e;
+      fixedRound(a);
+      return true;
+    }
+    Fixed& v = a.e >= b.e ? a : b;
+    if (v.e == 0) {
+      return false;
+    }
+    fixedRound(v, v.e - 1);
+  }
+}
+
+bool fixedMul(Fixed& a, Fixed b) {
+  // the exact product rounded, or the operand having the most decimals rounded first while it overflows
+  while ((fixedAbs(a.m) >> 31 || fixedAbs(b.m) >> 31) && b.m != 0 && fixedAbs(a.m) > INT64_MAX / fixedAbs(b.m)) {
+    Fixed& v = a.e >= b.e ? a : b;
+    if (v.e == 0) {
+      return false;
+    }
+    fixedRound(v, v.e - 1);
+  }
+  a.m *= b.m;
+  a.e += b.e;
+  fixedRound(a);
+  return true;
+}
+
+bool fixedDiv(Fixed& a, Fixed b) {
+  if (b.m == 0) {
+    return false; // infinite, as the double path gives it
+  }
+  // the quotient with FIXED_DECIMALS, or as many as the dividend can be scaled by
+  int e = a.e;
+  int scale = FIXED_DECIMALS + b.e;
+  while (e < scale) {
+    int k = scale - e > 18 ? 18 : scale - e;
+    while (k > 0 && fixedAbs(a.m) > fixedLimit[k]) {
+      k--;
+    }
+    if (k == 0) {
+      break;
+    }
+    a.m *= fixedPow10[k];
+    e += k;
+  }
+  if (e < b.e) {
+    return false;
+  }
+  a.m = fixedRoundDiv(b.m < 0 ? -a.m : a.m, fixedAbs(b.m));
+  a.e = e - b.e;
+  fixedRound(a);
+  return true;
+}
+
+int fixedSign(const Fixed& v) {
+  return v.m < 0 ? -1 : v.m > 0;
+}
+
+/* The sign of a - b, false if it cannot be computed */
+bool fixedCompare(Fixed a, Fixed b, int* sign) {
+  b.m = -b.m;
+  if (!fixedAdd(a, b)) {
+    return false;
+  }
+  *sign = fixedSign(a);
+  return true;
+}
+
+/* Parses a decimal number without exponent, as numbers written as strings in the definitions are */
+bool fixedParse(const char* text, Fixed& v) {
+  v.m = 0;
+  v.e = 0;
+  bool negative = *text == '-';
+  text += negative || *text == '+';
+  bool digits = false;
+  bool decimals = false;
+  for (; *text; ++text) {
+    if (*text == '.' && !decimals) {
+      decimals = true;
+    } else if (*text >= '0' && *text <= '9' && v.m <= fixedLimit[1] - 9 && v.e < FIXED_DECIMALS) {
+      v.m = v.m * 10 + (*text - '0');
+      v.e += decimals;
+      digits = true;
+    } else {
+      return false;
+    }
+  }
+  v.m = negative ? -v.m : v.m;
+  fixedRound(v);
+  return digits;
+}
+
+/* The decimal value of a double constant of a definition, if it has at most FIXED_DECIMALS */
+bool fixedFromDouble(double c, Fixed& v) {
+  double scaled = c;
+  for (v.e = 0; v.e <= FIXED_DECIMALS && fabs(scaled) < 9e18; ++v.e, scaled *= 10) {
+    double integral = scaled < 0 ? ceil(scaled - 0.5) : floor(scaled + 0.5);
+    // the constant parsed from its decimal text, a few ulps away at most
+    if (fabs(scaled - integral) <= fabs(scaled) * 1e-12) {
+      v.m = static_cast<int64_t>(integral);
+      fixedRound(v);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* The constant of a post_proc operation */
+bool fixedConstant(JsonVariant c, Fixed& v) {
+  if (c.is<long long>()) {
+    v.m = c.as<long long>();
+    v.e = 0;
+    return true;
+  }
+  if (c.is<const char*>()) {
+    return fixedParse(c.as<const char*>(), v);
+  }
+  return c.is<double>() && fixedFromDouble(c.as<double>(), v);
+}
+
+/* The integral part of v, as the double path casts it */
+int64_t fixedTruncate(const Fixed& v) {
+  return v.m / fixedPow10[v.e];
+}
+
+double fixedToDouble(const Fixed& v) {
+  return static_cast<double>(v.m) / fixedPow10[v.e];
+}
+
+/*
+ * Writes v to the key of jsondata with the text ArduinoJson prints of the
+ * double, in integer arithmetic: integral values as integers, the others as
+ * a raw JSON number rounded to the decimals printed. The values printed
+ * with an exponent are written as a double. key is copied, as a char*.
+ */
+void fixedWrite(JsonObject& jsondata, char* key, Fixed v) {
+  int decimals = FIXED_PRINTED_DECIMALS;
+  for (int64_t integral = fixedAbs(fixedTruncate(v)); integral >= 10 && decimals > 0; integral /= 10) {
+    decimals--;
+  }
+  fixedRound(v, decimals);
+  Fixed magnitude = {fixedAbs(v.m), v.e};
+  int below;
+  if (fixedTruncate(magnitude) >= FIXED_INTEGER_LIMIT ||
+      (v.m != 0 && (!fixedCompare(magnitude, FIXED_EXPONENT_BELOW, &below) || below <= 0))) {
+    jsondata[key] = fixedToDouble(v);
+    return;
+  }
+  if (v.e == 0) {
+    jsondata[key] = static_cast<long long>(v.m);
+    return;
+  }
+  // written from the last digit, without the 64 bit integers printf lacks on some targets
+  char text[24];
+  char* digits = text + sizeof(text);
+  *--digits = '\0';
+  int64_t rest = magnitude.m;
+  for (int i = 0; i < v.e; ++i, rest /= 10) {
+    *--digits = static_cast<char>('0' + rest % 10);
+  }
+  *--digits = '.';
+  do {
+    *--digits = static_cast<char>('0' + rest % 10);
+    rest /= 10;
+  } while (rest > 0);
+  if (v.m < 0) {
+    *--digits = '-';
+  }
+  jsondata[key] = serialized(digits);
+}
+} // namespace
+
+/*
+ * @brief Reads a number of a decoded document, the raw JSON numbers of the
+ * fixed-point mode from their text.
+ */
+bool TheengsDecoder::readNumber(JsonVariant value, double* number) {
+  if (value.is<double>()) {
+    *number = value.as<double>();
+    return true;
+  }
+  if (value.isNull() || value.is<bool>() || value.is<const char*>() || value.is<JsonArray>() || value.is<JsonObject>()) {
+    return false;
+  }
+  char text[32];
+  char* end = text;
+  if (serializeJson(value, text, sizeof(text)) < sizeof(text)) {
+    *number = strtod(text, &end);
+  }
+  return end != text;
+}
+
+/*
+ * @brief Decodes the value_from_hex_data property prop from src in fixed
+ * point, applying its post_proc operations, cal being the calibration value
+ * extracted in fixed point or nullptr. proc_str receives the string of the
+ * value, if one replaces it. Returns false if the value is out of the
+ * fixed-point range or the operations need the double path.
+ */
+bool TheengsDecoder::fixedValue(JsonObject prop, JsonArray decoder, const char* src, const FixedValue* cal,
+                                FixedValue& value, const char*& proc_str) {
+  int offset = decoder[2].as<int>();
+  int data_length = decoder[3].as<int>();
+  bool reverse = decoder[4].as<bool>();
+  bool can_be_negative = decoder[5].isNull() ? true : decoder[5].as<bool>();
+  long long raw = int_from_hex_string(src, offset, data_length, reverse,
+                                      strstr(decoder[0].as<const char*>(), "bf") != nullptr ? false : can_be_negative);
+  TRACE(TRACE_VALUE, 0, m_traceDevice, offset, data_length, floatBits(static_cast<double>(raw)));
+  if (raw == LLONG_MIN || raw == LLONG_MAX) {
+    return false; // beyond 63 bits
+  }
+
+  if (strstr(decoder[0].as<const char*>(), "bf") != nullptr) {
+    // the integer before the decimals in the high byte, the hundredths in the low one
+    long val = static_cast<long>(raw);
+    value.m = (val >> 8) * 100 + static_cast<uint8_t>(val);
+    value.e = 2;
+    if (can_be_negative && data_length == 4 && val > SHRT_MAX) {
+      value.m = -value.m + (SCHAR_MAX + 1) * 100;
+    }
+  } else {
+    value.m = raw;
+    value.e = 0;
+  }
+  fixedRound(value);
+
+  JsonArray post_proc = prop["post_proc"];
+  for (unsigned int i = 0; i < post_proc.size(); i += 2) {
+    const char* op = post_proc[i].as<const char*>();
+    if (op == nullptr) {
+      return false;
+    }
+    Fixed c = {0, 0};
+    bool calibrated = post_proc[i + 1].is<const char*>() && strncmp(post_proc[i + 1].as<const char*>(), ".cal", 4) == 0;
+    if (calibrated && (strlen(op) != 1 || strchr("/*-+", *op) == nullptr)) {
+      return false;
+    } else if (calibrated && cal != nullptr) {
+      c = *cal; // 0 as the double path reads ".cal" without a calibration value
+    } else if (calibrated) {
+      return false; // the double path does it with the calibration extracted in double
+    } else if ((strlen(op) == 1 && strchr("/*-+", *op) != nullptr) || strncmp(op, "max", 3) == 0 ||
+               strncmp(op, "min", 3) == 0 || strncmp(op, "±", 1) == 0) {
+      if (!fixedConstant(post_proc[i + 1], c)) {
+        return false;
+      }
+    }
+
+    int sign;
+    if (strlen(op) == 1 || calibrated) {
+      switch (*op) {
+        case '/':
+          if (!fixedDiv(value, c)) {
+            return false;
+          }
+          break;
+        case '*':
+          if (!fixedMul(value, c)) {
+            return false;
+          }
+          break;
+        case '-':
+          c.m = -c.m;
+          // fall through
+        case '+':
+          if (!fixedAdd(value, c)) {
+            return false;
+          }
+          break;
+        case '%': {
+          long val = static_cast<long>(fixedTruncate(value));
+          value.m = val % post_proc[i + 1].as<long>();
+          value.e = 0;
+          break;
+        }
+        case '<': {
+          long val = static_cast<long>(fixedTruncate(value));
+          value.m = val << post_proc[i + 1].as<unsigned int>();
+          value.e = 0;
+          break;
+        }
+        case '>': {
+          long val = static_cast<long>(fixedTruncate(value));
+          value.m = val >> post_proc[i + 1].as<unsigned int>();
+          value.e = 0;
+          break;
+        }
+        case '!':
+          value.m = value.m == 0;
+          value.e = 0;
+          break;
+        case '&':
+          value.m = fixedTruncate(value) & post_proc[i + 1].as<unsigned int>();
+          value.e = 0;
+          break;
+        case '^':
+          value.m = fixedTruncate(value) ^ post_proc[i + 1].as<unsigned int>();
+          value.e = 0;
+          break;
+      }
+    } else if (strncmp(op, "max", 3) == 0) {
+      if (!fixedCompare(value, c, &sign)) {
+        return false;
+      }
+      if (sign > 0) {
+        value = c;
+      }
+    } else if (strncmp(op, "min", 3) == 0) {
+      if (!fixedCompare(value, c, &sign)) {
+        return false;
+      }
+      if (sign < 0) {
+        value = c;
+      }
+    } else if (strncmp(op, "±", 1) == 0) {
+      if (value.m >= 0) {
+        c.m = -c.m;
+      }
+      if (!fixedAdd(value, c)) {
+        return false;
+      }
+    } else if (strncmp(op, "abs", 3) == 0) {
+      value.m = fixedAbs(fixedTruncate(value));
+      value.e = 0;
+    } else if (strncmp(op, "SBBT-dir", 8) == 0) { // "SBBT" decoder specific post_proc
+      sign = fixedSign(value);
+      proc_str = sign < 0 ? "down" : sign > 0 ? "up" : "—";
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Writes the value decoded in fixed point to jsondata, with the
+ * temperature and length conversions the double path adds.
+ */
+void TheengsDecoder::writeFixedValue(JsonObject& jsondata, char* key, const FixedValue& value, bool is_bool,
+                                     const char* proc_str) {
+  if (proc_str != nullptr) {
+    jsondata[key] = proc_str;
+  } else if (is_bool) {
+    jsondata[key] = value.m != 0;
+  } else {
+    fixedWrite(jsondata, key, value);
+  }
+  DEBUG_PRINT("found value = %s : %lld / 10^%d\n", key, static_cast<long long>(value.m), value.e);
+
+  /* the conversions start from the value written, as the double path reads it back */
+  Fixed written = value;
+  if (proc_str != nullptr || is_bool) {
+    written.m = proc_str == nullptr && value.m != 0;
+    written.e = 0;
+  }
+  size_t key_len = strlen(key);
+  Fixed converted;
+  Fixed c;
+
+  if (strstr(key, "tempc") != nullptr) {
+    converted = written;
+    c = {18, 1};
+    bool in_range = fixedMul(converted, c);
+    c = {32, 0};
+    in_range = in_range && fixedAdd(converted, c);
+    key[4] = 'f';
+    if (in_range) {
+      fixedWrite(jsondata, key, converted);
+    } else {
+      jsondata[key] = fixedToDouble(written) * 1.8 + 32;
+    }
+    key[4] = 'c';
+  }
+
+  if (strstr(key, "tempf") != nullptr) {
+    converted = written;
+    c = {-32, 0};
+    bool in_range = fixedAdd(converted, c);
+    c = {5, 0};
+    in_range = in_range && fixedMul(converted, c);
+    c = {9, 0};
+    in_range = in_range && fixedDiv(converted, c);
+    key[4] = 'c';
+    if (in_range) {
+      fixedWrite(jsondata, key, converted);
+    } else {
+      jsondata[key] = (fixedToDouble(written) - 32) * 5 / 9;
+    }
+    key[4] = 'f';
+  }
+
+  if (key_len >= 3 && !strcmp(key + key_len - 3, "_cm")) {
+    converted = written;
+    c = {254, 2};
+    memcpy(key + key_len - 3, "_in", 3);
+    if (fixedDiv(converted, c)) {
+      fixedWrite(jsondata, key, converted);
+    } else {
+      jsondata[key] = fixedToDouble(written) / 2.54;
+    }
+    memcpy(key + key_len - 3, "_cm", 3);
+  }
+}
 
-              if (strstr((const char*)decoder[0], "bf") != nullptr) {
-                dec_fun = &TheengsDecoder::bf_value_from_hex_string;
-              }
+/*
+ * @brief Adds the model attributes and the decoded properties of the
+ * device loaded in doc to jsondata.
+ */
+int TheengsDecoder::decodeDeviceProperties(JsonDocument& doc, int i_main, JsonObject& jsondata,
+                                           const char* svc_data, const char* mfg_data) {
+#ifdef UNIT_TESTING
+  TestPropertiesScope properties_scope;
+#endif
+  int success = -1;
+  jsondata["brand"] = doc["brand"];
+  jsondata["model"] = doc["model"];
+  jsondata["model_id"] = doc["model_id"];
+  if (doc.containsKey("tag")) {
+    doc.add("type");
+    doc["type"] = NULL;
 
-              temp_val = (this->*dec_fun)(src, decoder[2].as<int>(),
-                                          decoder[3].as<int>(),
-                                          decoder[4].as<bool>(),
-                                          decoder[5].isNull() ? true : decoder[5].as<bool>(),
-                                          decoder[6].isNull() ? false : decoder[6].as<bool>());
+    const char* tagstring = doc["tag"].is<const char*>() ? doc["tag"].as<const char*>() : "";
+    char type_hex[3] = {tagstring[0], tagstring[0] ? tagstring[1] : '\0', '\0'};
+    int type = strtol(type_hex, NULL, 16);
 
-            } else {
-              break;
-            }
+    doc["type"] = tagType(type);
+
+    if (!doc["type"].isNull()) {
+      jsondata["type"] = doc["type"];
+    } else {
+      DEBUG_PRINT("ERROR - no valid device type present in model tag property\n");
+    }
+
+    // Octet Byte[1] bits[7-0] - True/False tags
+    uint8_t flags = tagFlags(tagstring);
+
+    if (flags & TAG_CIDC) { // CIDC - NOT Company ID Compliant
+      doc.add("cidc");
+      doc["cidc"] = false;
+      jsondata["cidc"] = doc["cidc"];
+    }
+
+    if (flags & TAG_ACTS) { // Active Scanning required
+      doc.add("acts");
+      doc["acts"] = true;
+      jsondata["acts"] = doc["acts"];
+    }
+
+    if (flags & TAG_CONT) { // Continuous Scanning required
+      doc.add("cont");
+      doc["cont"] = true;
+      jsondata["cont"] = doc["cont"];
+    }
+
+    if (flags & TAG_TRACK) { // Discoverable as Device Tracker
+      doc.add("track");
+      doc["track"] = true;
+      jsondata["track"] = doc["track"];
+    }
+
+    if (flags & TAG_PRMAC) { // PRMAC - Potential RMAC device - if not defined with Identity MAC and IRK in Theengs Gateway
+      doc.add("prmac");
+      doc["prmac"] = true;
+      jsondata["prmac"] = doc["prmac"];
+    }
+
+    // Octet Byte[2] - Encryption Model
+    int encrmode = tagEncr(tagstring);
+    DEBUG_PRINT("encrmode: %d\n", encrmode);
+    if (encrmode > 0) {
+      doc.add("encr");
+      doc["encr"] = encrmode;
+      jsondata["encr"] = doc["encr"];
+    }
+  }
+
+  JsonObject properties = doc["properties"];
+  /* calibration value extracted from the data for the following properties */
+  double cal_val = 0;
+  FixedValue fixed_cal = {0, 0};
+  bool cal_in_fixed = true; // fixed_cal holding the calibration value, 0 until one is extracted
+  bool cal_pending = false; // cal_val yet to be converted from fixed_cal, for a property decoded in double
+
+  /* Loop through all the devices properties and extract the values */
+  int rank = -1;
+  m_traceDevice = i_main;
+  /* the key of the property, without the underscores of duplicates */
+  char _key[DECODER_KEY_MAX + 1];
+  for (JsonPair kv : properties) {
+    JsonObject prop = kv.value().as<JsonObject>();
+    rank++;
+
+    if (matchProperty(i_main, prop["condition"], svc_data, mfg_data) && sanitizeJsonKey(kv.key().c_str(), _key)) {
+      PROBE2(property, i_main, kv.key().c_str());
+      TRACE(TRACE_PROPERTY, 0, i_main, rank, -1, 0);
+      JsonArray decoder = prop["decoder"];
+      if (strstr((const char*)decoder[0], "value_from_hex_data") != nullptr) {
+        const char* src = svc_data;
+        if (strstr((const char*)decoder[1], MFG_DATA)) {
+          src = mfg_data;
+        }
 
-            /* Do any required post processing of the value */
-            if (prop.containsKey("post_proc")) {
-              JsonArray post_proc = prop["post_proc"];
-              for (unsigned int i = 0; i < post_proc.size(); i += 2) {
-                if (cal_val && post_proc[i + 1].as<const char*>() != NULL &&
-                    strncmp(post_proc[i + 1].as<const char*>(), ".cal", 4) == 0) {
-                  switch (*post_proc[i].as<const char*>()) {
-                    case '/':
-                      temp_val /= cal_val;
-                      break;
-                    case '*':
-                      temp_val *= cal_val;
-                      break;
-                    case '-':
-                      temp_val -= cal_val;
-                      break;
-                    case '+':
-                      temp_val += cal_val;
-                      break;
+        /* use a double for all values and cast later if required */
+        double temp_val;
+        const char* proc_str = nullptr;
+
+        /* or fixed point, the values of float data and those out of its range aside */
+        FixedValue fixed_val;
+        if (m_fixedPoint && (decoder[6].isNull() || !decoder[6].as<bool>()) &&
+            data_index_is_valid(src, decoder[2].as<int>(), decoder[3].as<int>()) &&
+            fixedValue(prop, decoder, src, cal_in_fixed ? &fixed_cal : nullptr, fixed_val, proc_str)) {
+          if (!strcmp(_key, ".cal")) {
+            fixed_cal = fixed_val;
+            cal_in_fixed = true;
+            cal_pending = true;
+            continue;
+          }
+          writeFixedValue(jsondata, _key, fixed_val, prop.containsKey("is_bool"), proc_str);
+          success = i_main;
+          continue;
+        }
+        proc_str = nullptr;
+
+        if (data_index_is_valid(src, decoder[2].as<int>(), decoder[3].as<int>())) {
+          decoder_function dec_fun = &TheengsDecoder::value_from_hex_string;
+
+          if (strstr((const char*)decoder[0], "bf") != nullptr) {
+            dec_fun = &TheengsDecoder::bf_value_from_hex_string;
+          }
+
+          temp_val = (this->*dec_fun)(src, decoder[2].as<int>(),
+                                      decoder[3].as<int>(),
+                                      decoder[4].as<bool>(),
+                                      decoder[5].isNull() ? true : decoder[5].as<bool>(),
+                                      decoder[6].isNull() ? false : decoder[6].as<bool>());
+
+        } else {
+          break;
+        }
+
+        if (cal_pending) {
+          cal_val = fixedToDouble(fixed_cal);
+          cal_pending = false;
+        }
+
+        /* Do any required post processing of the value */
+        if (prop.containsKey("post_proc")) {
+          JsonArray post_proc = prop["post_proc"];
+          for (unsigned int i = 0; i < post_proc.size(); i += 2) {
+            if (cal_val && post_proc[i + 1].as<const char*>() != NULL &&
+                strncmp(post_proc[i + 1].as<const char*>(), ".cal", 4) == 0) {
+              switch (*post_proc[i].as<const char*>()) {
+                case '/':
+                  temp_val /= cal_val;
+                  break;
+                case '*':
+                  temp_val *= cal_val;
+                  break;
+                case '-':
+                  temp_val -= cal_val;
+                  break;
+                case '+':
+                  temp_val += cal_val;
+                  break;
+              }
+            } else {
+              if (strlen(post_proc[i].as<const char*>()) == 1) {
+                switch (*post_proc[i].as<const char*>()) {
+                  case '/':
+                    temp_val /= post_proc[i + 1].as<double>();
+                    break;
+                  case '*':
+                    temp_val *= post_proc[i + 1].as<double>();
+                    break;
+                  case '-':
+                    temp_val -= post_proc[i + 1].as<double>();
+                    break;
+                  case '+':
+                    temp_val += post_proc[i + 1].as<double>();
+                    break;
+                  case '%': {
+                    long val = (long)temp_val;
+                    temp_val = val % post_proc[i + 1].as<long>();
+                    break;
                   }
-                } else {
-                  if (strlen(post_proc[i].as<const char*>()) == 1) {
-                    switch (*post_proc[i].as<const char*>()) {
-                      case '/':
-                        temp_val /= post_proc[i + 1].as<double>();
-                        break;
-                      case '*':
-                        temp_val *= post_proc[i + 1].as<double>();
-                        break;
-                      case '-':
-                        temp_val -= post_proc[i + 1].as<double>();
-                        break;
-                      case '+':
-                        temp_val += post_proc[i + 1].as<double>();
-                        break;
-                      case '%': {
-                        long val = (long)temp_val;
-                        temp_val = val % post_proc[i + 1].as<long>();
-                        break;
-                      }
-                      case '<': {
-                        long val = (long)temp_val;
-                        temp_val = val << post_proc[i + 1].as<unsigned int>();
-                        break;
-                      }
-                      case '>': {
-                        long val = (long)temp_val;
-                        temp_val = val >> post_proc[i + 1].as<unsigned int>();
-                        break;
-                      }
-                      case '!': {
-                        bool val = (bool)temp_val;
-                        temp_val = !val;
-                        break;
-                      }
-                      case '&': {
-                        long long val = (long long)temp_val;
-                        temp_val = val & post_proc[i + 1].as<unsigned int>();
-                        break;
-                      }
-                      case '^': {
-                        long long val = (long long)temp_val;
-                        temp_val = val ^ post_proc[i + 1].as<unsigned int>();
-                        break;
-                      }
-                    }
-                  } else if (strncmp(post_proc[i].as<const char*>(), "max", 3) == 0) {
-                    if (temp_val > post_proc[i + 1].as<double>()) {
-                      temp_val = post_proc[i + 1].as<double>();
-                    }
-                  } else if (strncmp(post_proc[i].as<const char*>(), "min", 3) == 0) {
-                    if (temp_val < post_proc[i + 1].as<double>()) {
-                      temp_val = post_proc[i + 1].as<double>();
-                    }
-                  } else if (strncmp(post_proc[i].as<const char*>(), "±", 1) == 0) {
-                    if (temp_val < 0) {
-                      temp_val += post_proc[i + 1].as<double>();
-                    } else {
-                      temp_val -= post_proc[i + 1].as<double>();
-                    }
-                  } else if (strncmp(post_proc[i].as<const char*>(), "abs", 3) == 0) {
+                  case '<': {
+                    long val = (long)temp_val;
+                    temp_val = val << post_proc[i + 1].as<unsigned int>();
+                    break;
+                  }
+                  case '>': {
+                    long val = (long)temp_val;
+                    temp_val = val >> post_proc[i + 1].as<unsigned int>();
+                    break;
+                  }
+                  case '!': {
+                    bool val = (bool)temp_val;
+                    temp_val = !val;
+                    break;
+                  }
+                  case '&': {
+                    long long val = (long long)temp_val;
+                    temp_val = val & post_proc[i + 1].as<unsigned int>();
+                    break;
+                  }
+                  case '^': {
                     long long val = (long long)temp_val;
-                    temp_val = abs(val);
-                  } else if (strncmp(post_proc[i].as<const char*>(), "SBBT-dir", 8) == 0) { // "SBBT" decoder specific post_proc
-                    if (temp_val < 0) {
-                      proc_str = "down";
-                    } else if (temp_val > 0) {
-                      proc_str = "up";
-                    } else {
-                      proc_str = "—";
-                    }
+                    temp_val = val ^ post_proc[i + 1].as<unsigned int>();
+                    break;
                   }
                 }
+              } else if (strncmp(post_proc[i].as<const char*>(), "max", 3) == 0) {
+                if (temp_val > post_proc[i + 1].as<double>()) {
+                  temp_val = post_proc[i + 1].as<double>();
+                }
+              } else if (strncmp(post_proc[i].as<const char*>(), "min", 3) == 0) {
+                if (temp_val < post_proc[i + 1].as<double>()) {
+                  temp_val = post_proc[i + 1].as<double>();
+                }
+              } else if (strncmp(post_proc[i].as<const char*>(), "±", 1) == 0) {
+                if (temp_val < 0) {
+                  temp_val += post_proc[i + 1].as<double>();
+                } else {
+                  temp_val -= post_proc[i + 1].as<double>();
+                }
+              } else if (strncmp(post_proc[i].as<const char*>(), "abs", 3) == 0) {
+                long long val = (long long)temp_val;
+                temp_val = abs(val);
+              } else if (strncmp(post_proc[i].as<const char*>(), "SBBT-dir", 8) == 0) { // "SBBT" decoder specific post_proc
+                if (temp_val < 0) {
+                  proc_str = "down";
+                } else if (temp_val > 0) {
+                  proc_str = "up";
+                } else {
+                  proc_str = "—";
+                }
               }
             }
+          }
+        }
 
-            /* If there is any underscores at the beginning of the property name, there is multiple
-                * properties of this type, we need remove the underscores for creating the key.
-                */
-            std::string _key = sanitizeJsonKey(kv.key().c_str());
-
-            /* calculation values extracted from data are not added to the decoded output
-                * instead we store them temporarily to use with the next data properties.
-                */
-            if (_key == ".cal") {
-              cal_val = temp_val;
-              continue;
-            }
+        /* calculation values extracted from data are not added to the decoded output
+            * instead we store them temporarily to use with the next data properties.
+            */
+        if (!strcmp(_key, ".cal")) {
+          cal_val = temp_val;
+          fixed_cal = {0, 0};
+          cal_in_fixed = cal_val == 0;
+          cal_pending = false;
+          continue;
+        }
 
-            /* Cast to a different value type if specified */
-            if (prop.containsKey("is_bool")) {
-              jsondata[_key] = (bool)temp_val;
-            } else {
-              jsondata[_key] = temp_val;
-            }
+        /* Cast to a different value type if specified */
+        if (prop.containsKey("is_bool")) {
+          jsondata[_key] = (bool)temp_val;
+        } else {
+          jsondata[_key] = temp_val;
+        }
 
-            /* _key as string if proc_str != "" */
-            if (proc_str != "") {
-              jsondata[_key] = proc_str;
-            }
+        /* _key as string if proc_str is set */
+        if (proc_str != nullptr) {
+          jsondata[_key] = proc_str;
+        }
 
-            /* If the property is temp in C, make sure to convert and add temp in F */
-            if (_key.find("tempc", 0, 5) != std::string::npos) {
-              double tc = jsondata[_key];
-              _key[4] = 'f';
-              jsondata[_key] = tc * 1.8 + 32;
-              _key[4] = 'c';
-            }
+        size_t key_len = strlen(_key);
 
-            /* If the property is tempf in F, make sure to convert and add temp in C */
-            if (_key.find("tempf", 0, 5) != std::string::npos) {
-              double tc = jsondata[_key];
-              _key[4] = 'c';
-              jsondata[_key] = (tc - 32) * 5 / 9;
-              _key[4] = 'f';
-            }
+        /* If the property is temp in C, make sure to convert and add temp in F */
+        if (strstr(_key, "tempc") != nullptr) {
+          double tc = jsondata[_key];
+          _key[4] = 'f';
+          jsondata[_key] = tc * 1.8 + 32;
+          _key[4] = 'c';
+        }
 
-            /* If the property is with suffix _cm, make sure to convert and add length in inches */
-            if (_key.find("_cm", _key.length() - 3, 3) != std::string::npos) {
-              double tc = jsondata[_key];
-              _key.replace(_key.length() - 3, 3, "_in");
-              jsondata[_key] = tc / 2.54;
-              _key.replace(_key.length() - 3, 3, "_cm");
-            }
+        /* If the property is tempf in F, make sure to convert and add temp in C */
+        if (strstr(_key, "tempf") != nullptr) {
+          double tc = jsondata[_key];
+          _key[4] = 'c';
+          jsondata[_key] = (tc - 32) * 5 / 9;
+          _key[4] = 'f';
+        }
 
-            success = i_main;
-            DEBUG_PRINT("found value = %s : %.2f\n", _key.c_str(), jsondata[_key].as<double>());
-          } else if (strstr((const char*)decoder[0], "static_value") != nullptr) {
-            if (strstr((const char*)decoder[0], "bit") != nullptr) {
-              JsonArray staticbitdecoder = prop["decoder"];
-              const char* data_src = nullptr;
-
-              if (svc_data && strstr((const char*)staticbitdecoder[1], SVC_DATA) != nullptr) {
-                data_src = svc_data;
-              } else if (mfg_data && strstr((const char*)staticbitdecoder[1], MFG_DATA) != nullptr) {
-                data_src = mfg_data;
-              }
+        /* If the property is with suffix _cm, make sure to convert and add length in inches */
+        if (key_len >= 3 && !strcmp(_key + key_len - 3, "_cm")) {
+          double tc = jsondata[_key];
+          memcpy(_key + key_len - 3, "_in", 3);
+          jsondata[_key] = tc / 2.54;
+          memcpy(_key + key_len - 3, "_cm", 3);
+        }
 
-              char ch = *(data_src + staticbitdecoder[2].as<int>());
-              uint8_t data = getBinaryData(ch);
-              uint8_t shift = staticbitdecoder[3].as<uint8_t>();
-              int x = 4 + ((data >> shift) & 0x01);
+        success = i_main;
+        DEBUG_PRINT("found value = %s : %.2f\n", _key, jsondata[_key].as<double>());
+      } else if (strstr((const char*)decoder[0], "static_value") != nullptr) {
+        if (strstr((const char*)decoder[0], "bit") != nullptr) {
+          JsonArray staticbitdecoder = prop["decoder"];
+          const char* data_src = nullptr;
+
+          if (svc_data && strstr((const char*)staticbitdecoder[1], SVC_DATA) != nullptr) {
+            data_src = svc_data;
+          } else if (mfg_data && strstr((const char*)staticbitdecoder[1], MFG_DATA) != nullptr) {
+            data_src = mfg_data;
+          }
 
-              jsondata[sanitizeJsonKey(kv.key().c_str())] = staticbitdecoder[x];
-              success = i_main;
-            } else {
-              jsondata[sanitizeJsonKey(kv.key().c_str())] = decoder[1];
-              success = i_main;
-            }
-          } else if (strstr((const char*)decoder[0], "string_from_hex_data") != nullptr) {
-            const char* src = svc_data;
-            if (strstr((const char*)decoder[1], MFG_DATA)) {
-              src = mfg_data;
-            }
+          if (!data_index_is_valid(data_src, staticbitdecoder[2].as<int>(), 1)) {
+            break;
+          }
 
-            std::string value(src + decoder[2].as<int>(), decoder[3].as<int>());
-
-            /* Lookup table */
-            if (prop.containsKey("lookup")) {
-              JsonArray lookup = prop["lookup"];
-              for (unsigned int i = 0; i < lookup.size(); i += 2) {
-                if (lookup[i].as<std::string>() == value) {
-                  if (lookup[i + 1].as<std::string>() != lookup[i + 1]) {
-                    int valueint = lookup[i + 1].as<int>();
-                    jsondata[sanitizeJsonKey(kv.key().c_str())] = valueint;
-                  } else {
-                    value = lookup[i + 1].as<std::string>();
-                    jsondata[sanitizeJsonKey(kv.key().c_str())] = value;
-                  }
+          char ch = *(data_src + staticbitdecoder[2].as<int>());
+          uint8_t data = getBinaryData(ch);
+          uint8_t shift = staticbitdecoder[3].as<uint8_t>();
+          int x = 4 + ((data >> shift) & 0x01);
 
-                  success = i_main;
-                  break;
-                }
-              }
-            } else {
-              jsondata[sanitizeJsonKey(kv.key().c_str())] = value;
-              success = i_main;
-            }
-          } else if (strstr((const char*)decoder[0], "mac_from_hex_data") != nullptr) {
-            const char* src = svc_data;
-            if (strstr((const char*)decoder[1], MFG_DATA)) {
-              src = mfg_data;
-            }
+          jsondata[_key] = staticbitdecoder[x];
+          success = i_main;
+        } else {
+          jsondata[_key] = decoder[1];
+          success = i_main;
+        }
+      } else if (strstr((const char*)decoder[0], "string_from_hex_data") != nullptr) {
+        const char* src = svc_data;
+        if (strstr((const char*)decoder[1], MFG_DATA)) {
+          src = mfg_data;
+        }
 
-            std::string value(src + decoder[2].as<int>(), 12);
+        if (!data_index_is_valid(src, decoder[2].as<int>(), decoder[3].as<int>())) {
+          break;
+        }
 
-            // reverse MAC
-            if (strstr((const char*)decoder[0], "revmac_from_hex_data") != nullptr) {
-              const char* mac_string = nullptr;
-              mac_string = value.c_str();
-              char* reverse_mac_string = (char*)malloc(strlen(mac_string) + 1);
-              reverse_hex_data(mac_string, reverse_mac_string, 12);
-              value = reverse_mac_string;
-              free(reverse_mac_string);
-            }
+        char value[DECODER_STRING_MAX + 1];
+        if (decoder[3].as<size_t>() > DECODER_STRING_MAX) {
+          DEBUG_PRINT("ERROR - string of %s longer than DECODER_STRING_MAX\n", _key);
+          continue;
+        }
+        memcpy(value, src + decoder[2].as<int>(), decoder[3].as<size_t>());
+        value[decoder[3].as<size_t>()] = '\0';
+
+        /* Lookup table */
+        if (prop.containsKey("lookup")) {
+          JsonArray lookup = prop["lookup"];
+          for (unsigned int i = 0; i < lookup.size(); i += 2) {
+            const char* lookup_key = lookup[i].as<const char*>();
+            if (lookup_key != nullptr && !strcmp(lookup_key, value)) {
+              if (!lookup[i + 1].is<const char*>()) {
+                int valueint = lookup[i + 1].as<int>();
+                jsondata[_key] = valueint;
+              } else {
+                jsondata[_key] = lookup[i + 1];
+              }
 
-            // upper case MAC
-            for (int x = 0; x <= 12; x++) {
-              value[x] = toupper(value[x]);
+              success = i_main;
+              break;
             }
+          }
+        } else {
+          jsondata[_key] = value;
+          success = i_main;
+        }
+      } else if (strstr((const char*)decoder[0], "mac_from_hex_data") != nullptr) {
+        const char* src = svc_data;
+        if (strstr((const char*)decoder[1], MFG_DATA)) {
+          src = mfg_data;
+        }
 
-            // add colons
-            for (int x = 2; x <= 14; x += 3) {
-              value.insert(x, 1, ':');
-            }
+        if (!data_index_is_valid(src, decoder[2].as<int>(), 12)) {
+          break;
+        }
 
-            jsondata[sanitizeJsonKey(kv.key().c_str())] = value;
-            success = i_main;
-          } else if (strstr((const char*)decoder[0], "ascii_from_hex_data") != nullptr) {
-            const char* src = svc_data;
-            if (strstr((const char*)decoder[1], MFG_DATA)) {
-              src = mfg_data;
-            }
+        const char* mac = src + decoder[2].as<int>();
 
-            std::string value(src + decoder[2].as<int>(), decoder[3].as<int>());
-            std::string ascii = "";
+        // reverse MAC
+        char reverse_mac_string[13];
+        if (strstr((const char*)decoder[0], "revmac_from_hex_data") != nullptr) {
+          reverse_hex_data(mac, reverse_mac_string, 12);
+          mac = reverse_mac_string;
+        }
 
-            for (size_t i = 0; i < value.length(); i += 2) {
-              std::string part = value.substr(i, 2);
-              char ch = stoul(part, nullptr, 16);
+        // upper case MAC, with colons
+        char value[18];
+        for (int x = 0; x < 12; x++) {
+          value[x + x / 2] = static_cast<char>(toupper(mac[x]));
+          if (x % 2 == 1) {
+            value[x + x / 2 + 1] = ':';
+          }
+        }
+        value[17] = '\0';
+
+        jsondata[_key] = value;
+        success = i_main;
+      } else if (strstr((const char*)decoder[0], "ascii_from_hex_data") != nullptr) {
+        const char* src = svc_data;
+        if (strstr((const char*)decoder[1], MFG_DATA)) {
+          src = mfg_data;
+        }
 
-              ascii += ch;
-            }
+        if (!data_index_is_valid(src, decoder[2].as<int>(), decoder[3].as<int>())) {
+          break;
+        }
 
-            if (ascii != "") {
-              jsondata[sanitizeJsonKey(kv.key().c_str())] = ascii;
-            }
+        const char* value = src + decoder[2].as<int>();
+        size_t value_len = decoder[3].as<size_t>();
+        char ascii[DECODER_STRING_MAX / 2 + 1];
+        if (value_len > DECODER_STRING_MAX) {
+          DEBUG_PRINT("ERROR - string of %s longer than DECODER_STRING_MAX\n", _key);
+          continue;
+        }
 
-            success = i_main;
-          }
+        size_t ascii_len = 0;
+        for (size_t i = 0; i < value_len; i += 2) {
+          char part[3] = {value[i], i + 1 < value_len ? value[i + 1] : '\0', '\0'};
+          ascii[ascii_len++] = static_cast<char>(strtoul(part, nullptr, 16));
+        }
+        ascii[ascii_len] = '\0';
+
+        if (ascii_len > 0) {
+          jsondata[_key] = ascii;
         }
+
+        success = i_main;
       }
-      return success;
     }
   }
   return success;
 }
 
-int TheengsDecoder::getTheengModel(JsonDocument& doc, const char* model_id) {
-  int mid_len = strlen(model_id);
+namespace {
+/* Number of slots of the model_id hash table, a power of two at least twice the number of models */
+constexpr size_t catalogSlots(size_t n, size_t slots = 1) {
+  return slots >= 2 * n ? slots : catalogSlots(n, slots * 2);
+}
 
-  for (auto i = 0; i < sizeof(_devices) / sizeof(_devices[0]); ++i) {
-    DeserializationError error = deserializeJson(doc, _devices[i][0]);
-    if (error) {
-      DEBUG_PRINT("deserializeJson() failed: %s\n", error.c_str());
-#ifdef UNIT_TESTING
-      assert(0);
+const size_t CATALOG_SLOTS = catalogSlots(CATALOG_MODELS);
+/* Model index + 1 in the hash table, on 16 bits unless extra devices make the catalog larger */
+typedef std::conditional<CATALOG_MODELS < UINT16_MAX, uint16_t, uint32_t>::type CatalogSlot;
+
+/* Span of an attribute in the device definition, or the pool of the pooled catalog, size 0 if it could not be extracted */
+struct AttributeSpan {
+#ifdef DECODER_POOLED_CATALOG
+  uint32_t offset;
+#else
+  uint16_t offset;
 #endif
-      break;
-    }
-#ifdef UNIT_TESTING
-    if (doc.memoryUsage() > peakDocSize)
-      peakDocSize = doc.memoryUsage();
+  uint8_t size;
+};
+
+enum ModelAttribute {
+  ATTR_BRAND,
+  ATTR_MODEL,
+  ATTR_MODEL_ID,
+  ATTR_TAG,
+  ATTR_COUNT
+};
+
+const char* const attributeNames[ATTR_COUNT] = {"brand", "model", "model_id", "tag"};
+
+/*
+ * The attributes of every model located in the catalog strings and a
+ * model_id hash table, built once on first use instead of parsing the
+ * device definitions for each lookup.
+ */
+struct CatalogIndex {
+  AttributeSpan attributes[CATALOG_MODELS][ATTR_COUNT];
+  CatalogSlot slots[CATALOG_SLOTS]; // model index + 1, 0 when empty
+
+  CatalogIndex() {
+    memset(attributes, 0, sizeof(attributes));
+    memset(slots, 0, sizeof(slots));
+    for (size_t i = 0; i < CATALOG_MODELS; ++i) {
+      if (!catalogSelected(i)) {
+        continue;
+      }
+      const char* definition = catalogAttributes(i);
+#if defined(DECODER_MSGPACK_CATALOG) || defined(DECODER_POOLED_CATALOG)
+      // located by the generator
+#  ifdef DECODER_MSGPACK_CATALOG
+      const uint16_t* spans = _devices_msgpack_attributes[i];
+#  else
+      const uint32_t* spans = _catalog_attributes[i];
+#  endif
+      for (int attr = 0; attr < ATTR_COUNT; ++attr) {
+        if (spans[2 * attr + 1] <= UINT8_MAX) {
+          attributes[i][attr].offset = spans[2 * attr];
+          attributes[i][attr].size = spans[2 * attr + 1];
+        }
+      }
+#else
+      size_t len = strlen(definition);
+      for (int attr = 0; attr < ATTR_COUNT; ++attr) {
+        size_t begin, end;
+        if (findJsonString(definition, len, attributeNames[attr], &begin, &end) && begin <= UINT16_MAX && end - begin <= UINT8_MAX) {
+          attributes[i][attr].offset = begin;
+          attributes[i][attr].size = end - begin;
+        }
+      }
 #endif
 
-    if (doc.containsKey("model_id")) {
-      if (strlen(doc["model_id"].as<const char*>()) != mid_len) {
+      const AttributeSpan& id = attributes[i][ATTR_MODEL_ID];
+      if (id.size == 0) {
         continue;
       }
-      if (!strncmp(model_id, doc["model_id"], mid_len)) {
-        return i;
+      // the first model of a model_id is kept, as the catalog order gives
+      size_t slot = fnv1a(definition + id.offset, id.size) & (CATALOG_SLOTS - 1);
+      while (slots[slot] != 0 && !matches(slots[slot] - 1, definition + id.offset, id.size)) {
+        slot = (slot + 1) & (CATALOG_SLOTS - 1);
+      }
+      if (slots[slot] == 0) {
+        slots[slot] = i + 1;
       }
     }
+    PROBE1(catalog_build, "index");
   }
 
-  return -1;
+  bool matches(size_t index, const char* model_id, size_t len) const {
+    const AttributeSpan& id = attributes[index][ATTR_MODEL_ID];
+    return id.size == len && memcmp(catalogAttributes(index) + id.offset, model_id, len) == 0;
+  }
+
+  int find(const char* model_id) const {
+    size_t len = strlen(model_id);
+    size_t slot = fnv1a(model_id, len) & (CATALOG_SLOTS - 1);
+    while (slots[slot] != 0) {
+      if (matches(slots[slot] - 1, model_id, len)) {
+        return slots[slot] - 1;
+      }
+      slot = (slot + 1) & (CATALOG_SLOTS - 1);
+    }
+    return -1;
+  }
+
+  bool attribute(size_t index, int attr, TheengsDecoder::CatalogString& str) const {
+    const AttributeSpan& span = attributes[index][attr];
+    str.data = span.size != 0 ? catalogAttributes(index) + span.offset : "";
+    str.size = span.size;
+    return span.size != 0;
+  }
+};
+
+const CatalogIndex& catalogIndex() {
+  static CatalogIndex index;
+  return index;
+}
+
+/*
+ * The catalog entries with their property metadata, the strings being copied
+ * null terminated once so that the entries stay valid until the program ends.
+ */
+struct CatalogCache {
+  TheengsDecoder::CatalogEntry entries[CATALOG_MODELS];
+  std::vector<TheengsDecoder::CatalogProperty> properties;
+  std::deque<std::string> strings;
+
+  CatalogCache() {
+    const CatalogIndex& index = catalogIndex();
+    std::vector<size_t> first_property(CATALOG_MODELS);
+    for (size_t i = 0; i < CATALOG_MODELS; ++i) {
+      TheengsDecoder::CatalogEntry& entry = entries[i];
+      entry.index = static_cast<int>(i);
+      entry.model_id = attribute(index, i, ATTR_MODEL_ID);
+      entry.brand = attribute(index, i, ATTR_BRAND);
+      entry.model = attribute(index, i, ATTR_MODEL);
+      entry.tag = attribute(index, i, ATTR_TAG);
+      entry.type = tagType(strtol(std::string(entry.tag).substr(0, 2).c_str(), NULL, 16));
+      entry.flags = tagFlags(entry.tag);
+      entry.encr = tagEncr(entry.tag);
+
+      first_property[i] = properties.size();
+      std::string props = catalogSelected(i) ? std::string(catalogProperties(i)) : std::string();
+      DynamicJsonDocument doc(props.size() * 4 + 256);
+      if (!deserializeJson(doc, props.c_str())) {
+        for (JsonPair prop : doc["properties"].as<JsonObject>()) {
+          TheengsDecoder::CatalogProperty property;
+          property.key = copy(prop.key().c_str());
+          property.unit = copy(prop.value()["unit"].as<const char*>());
+          property.name = copy(prop.value()["name"].as<const char*>());
+          properties.push_back(property);
+        }
+      }
+      entry.property_count = properties.size() - first_property[i];
+    }
+    // the property array is complete, its storage no longer moves
+    for (size_t i = 0; i < CATALOG_MODELS; ++i) {
+      entries[i].properties = properties.data() + first_property[i];
+    }
+    PROBE1(catalog_build, "catalog");
+  }
+
+  const char* copy(const char* str) {
+    strings.push_back(str != nullptr ? str : "");
+    return strings.back().c_str();
+  }
+
+  const char* attribute(const CatalogIndex& index, size_t mod_index, int attr) {
+    TheengsDecoder::CatalogString str;
+    index.attribute(mod_index, attr, str);
+    strings.push_back(std::string(str.data, str.size));
+    return strings.back().c_str();
+  }
+};
+} // namespace
+
+/*
+ * @brief Returns the index of the model model_id, -1 if unknown, without
+ * parsing the device definitions.
+ */
+int TheengsDecoder::getTheengModel(const char* model_id) {
+  int mod_index = catalogIndex().find(model_id);
+  PROBE2(catalog_lookup, model_id, mod_index);
+  return mod_index;
+}
+
+/*
+ * @brief Same as above, doc receiving the definition of the model found.
+ */
+int TheengsDecoder::getTheengModel(JsonDocument& doc, const char* model_id) {
+  int mod_index = getTheengModel(model_id);
+  if (mod_index < 0 || !loadDevice(doc, mod_index)) {
+    return -1;
+  }
+  return mod_index;
+}
+
+/*
+ * @brief Points info to the brand, model, model_id and tag of the model
+ * mod_index in the catalog. Returns false if mod_index is invalid or the
+ * model is not compiled in.
+ */
+bool TheengsDecoder::getModelInfo(int mod_index, ModelInfo& info) {
+  if (mod_index < 0 || mod_index >= BLE_ID_NUM::BLE_ID_MAX || !catalogSelected(mod_index)) {
+    return false;
+  }
+  const CatalogIndex& index = catalogIndex();
+  index.attribute(mod_index, ATTR_BRAND, info.brand);
+  index.attribute(mod_index, ATTR_MODEL, info.model);
+  index.attribute(mod_index, ATTR_MODEL_ID, info.model_id);
+  index.attribute(mod_index, ATTR_TAG, info.tag);
+  return true;
+}
+
+/*
+ * @brief Returns the models of the catalog with their attributes and property
+ * metadata, count receiving their number. The array is built on the first
+ * call and valid until the program ends. The models left out of a
+ * DECODER_DEVICE_SUBSET build keep their entry, with empty strings.
+ */
+const TheengsDecoder::CatalogEntry* TheengsDecoder::getCatalog(size_t* count) {
+  static CatalogCache cache;
+  *count = CATALOG_MODELS;
+  return cache.entries;
+}
+
+/*
+ * @brief Enables the count models listed, disabling all the others.
+ */
+void TheengsDecoder::setEnabledModels(const BLE_ID_NUM* models, size_t count) {
+  m_enabledModels.reset();
+  for (size_t i = 0; i < count; ++i) {
+    setModelEnabled(models[i], true);
+  }
+}
+
+void TheengsDecoder::setModelEnabled(BLE_ID_NUM model, bool enabled) {
+  if (model >= 0 && model < BLE_ID_MAX) {
+    m_enabledModels.set(model, enabled);
+  }
+}
+
+/*
+ * @brief Enables or disables the models of a device type, the type decoded
+ * from their tag ("THB", "BBQ", "TRACK"...). Returns false if no model of
+ * the catalog has that type.
+ */
+bool TheengsDecoder::setTypeEnabled(const char* type, bool enabled) {
+  const CatalogIndex& index = catalogIndex();
+  bool found = false;
+  for (int i = 0; i < BLE_ID_MAX; ++i) {
+    CatalogString tag;
+    if (!index.attribute(i, ATTR_TAG, tag) || tag.size < 2) {
+      continue;
+    }
+    const char* tag_type = tagType(tagNibble(tag.data[0]) << 4 | tagNibble(tag.data[1]));
+    if (tag_type != nullptr && strcmp(tag_type, type) == 0) {
+      m_enabledModels.set(i, enabled);
+      found = true;
+    }
+  }
+  return found;
 }
 
 std::string TheengsDecoder::getTheengProperties(int mod_index) {
-  return (mod_index < 0 || mod_index >= BLE_ID_NUM::BLE_ID_MAX) ? "" : _devices[mod_index][1];
+  return (mod_index < 0 || mod_index >= BLE_ID_NUM::BLE_ID_MAX || !catalogSelected(mod_index)) ? "" : catalogProperties(mod_index);
 }
 
 std::string TheengsDecoder::getTheengProperties(const char* model_id) {
-#ifdef UNIT_TESTING
-  DynamicJsonDocument doc(TEST_MAX_DOC);
-#else
-  DynamicJsonDocument doc(m_docMax);
-#endif
-  int mod_index = getTheengModel(doc, model_id);
-  return (mod_index < 0 || mod_index >= BLE_ID_NUM::BLE_ID_MAX) ? "" : _devices[mod_index][1];
+  return getTheengProperties(getTheengModel(model_id));
 }
 
 std::string TheengsDecoder::getTheengAttribute(int model_id, const char* attribute) {
+  std::string ret_attr = "";
+  if (model_id < 0 || model_id >= BLE_ID_NUM::BLE_ID_MAX || !catalogSelected(model_id)) {
+    return ret_attr;
+  }
+
+  // the attributes extracted by the index need no parsing
+  for (int attr = 0; attr < ATTR_COUNT; ++attr) {
+    CatalogString str;
+    if (strcmp(attribute, attributeNames[attr]) == 0 && catalogIndex().attribute(model_id, attr, str)) {
+      return std::string(str.data, str.size);
+    }
+  }
+
 #ifdef UNIT_TESTING
   DynamicJsonDocument doc(TEST_MAX_DOC);
 #else
   DynamicJsonDocument doc(m_docMax);
 #endif
-  std::string ret_attr = "";
-  if (model_id >= 0 && model_id < BLE_ID_NUM::BLE_ID_MAX) {
-    DeserializationError error = deserializeJson(doc, _devices[model_id][0]);
-    if (error) {
-      DEBUG_PRINT("deserializeJson() failed: %s\n", error.c_str());
-#ifdef UNIT_TESTING
-      assert(0);
-#endif
-    } else if (!doc[attribute].isNull()) {
-      ret_attr = doc[attribute].as<std::string>();
-    }
+  if (loadDevice(doc, model_id) && !doc[attribute].isNull()) {
+    ret_attr = doc[attribute].as<std::string>();
   }
 
   return ret_attr;
 }
 
 std::string TheengsDecoder::getTheengAttribute(const char* model_id, const char* attribute) {
-#ifdef UNIT_TESTING
-  DynamicJsonDocument doc(TEST_MAX_DOC);
+  return getTheengAttribute(getTheengModel(model_id), attribute);
+}
+
+/* Copies len characters of str to out, of size characters with the null, truncating them, and returns those copied */
+static size_t copyString(const char* str, size_t len, char* out, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+  if (len >= size) {
+    len = size - 1;
+  }
+  memcpy(out, str, len);
+  out[len] = '\0';
+  return len;
+}
+
+/*
+ * @brief Same as above, the properties being copied to out, of size
+ * characters with the null, and truncated to fit. Returns the length
+ * copied, 0 for an invalid model. Allocates nothing, unlike the std::string
+ * getters, for the DECODER_NO_HEAP builds.
+ */
+size_t TheengsDecoder::getTheengProperties(int mod_index, char* out, size_t size) {
+  if (mod_index < 0 || mod_index >= BLE_ID_NUM::BLE_ID_MAX || !catalogSelected(mod_index)) {
+    return copyString("", 0, out, size);
+  }
+#ifdef DECODER_POOLED_CATALOG
+  char text[CATALOG_TEXT_MAX];
+  return copyString(text, catalogText(_catalog_models[mod_index][1], text), out, size);
 #else
+  const char* props = catalogProperties(mod_index);
+  return copyString(props, strlen(props), out, size);
+#endif
+}
+
+#ifndef DECODER_NO_HEAP
+/*
+ * @brief Same as above, the attribute being copied to out, of size
+ * characters with the null, and truncated to fit, in JSON if it is not a
+ * string. Returns the length copied, 0 if the model has no such attribute.
+ */
+size_t TheengsDecoder::getTheengAttribute(int model_id, const char* attribute, char* out, size_t size) {
+#  ifdef UNIT_TESTING
+  DynamicJsonDocument doc(TEST_MAX_DOC);
+#  else
   DynamicJsonDocument doc(m_docMax);
+#  endif
+  return getTheengAttribute(doc, model_id, attribute, out, size);
+}
 #endif
-  int mod_index = getTheengModel(doc, model_id);
 
-  if (mod_index >= 0 && !doc[attribute].isNull()) {
-    return std::string(doc[attribute].as<std::string>());
+/*
+ * @brief Same as above, the definition being parsed into doc, of at least
+ * getDocMax() bytes. Allocates nothing, for the DECODER_NO_HEAP builds.
+ */
+size_t TheengsDecoder::getTheengAttribute(JsonDocument& doc, int model_id, const char* attribute, char* out, size_t size) {
+  if (model_id < 0 || model_id >= BLE_ID_NUM::BLE_ID_MAX || !catalogSelected(model_id)) {
+    return copyString("", 0, out, size);
+  }
+
+  for (int attr = 0; attr < ATTR_COUNT; ++attr) {
+    CatalogString str;
+    if (strcmp(attribute, attributeNames[attr]) == 0 && catalogIndex().attribute(model_id, attr, str)) {
+      return copyString(str.data, str.size, out, size);
+    }
+  }
+
+  if (!loadDevice(doc, model_id) || doc[attribute].isNull() || size == 0) {
+    return copyString("", 0, out, size);
   }
-  return "";
+  JsonVariant value = doc[attribute];
+  if (value.is<const char*>()) {
+    return copyString(value.as<const char*>(), strlen(value.as<const char*>()), out, size);
+  }
+  size_t len = serializeJson(value, out, size);
+  if (len >= size) {
+    len = size - 1;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+size_t TheengsDecoder::getDocMax() {
+  return m_docMax;
 }
 
 void TheengsDecoder::setMinServiceDataLen(size_t len) {
@@ -25,23 +25,122 @@
 #define ARDUINOJSON_USE_LONG_LONG 1
 #include "ArduinoJson.h"
 
+#include <bitset>
+#include <memory>
+
 //#define DEBUG_DECODER
 
+/* Maximum number of service data entries decoded from one advertisement */
+#ifndef MAX_SVC_DATA_ENTRIES
+#  define MAX_SVC_DATA_ENTRIES 8
+#endif
+
+/* Longest property key and string value, in characters, the properties exceeding them being skipped */
+#ifndef DECODER_KEY_MAX
+#  define DECODER_KEY_MAX 31
+#endif
+#ifndef DECODER_STRING_MAX
+#  define DECODER_STRING_MAX 63
+#endif
+
 class TheengsDecoder {
 public:
-  TheengsDecoder() {}
-  ~TheengsDecoder() {}
+  TheengsDecoder();
+  ~TheengsDecoder();
 
+  /* A string of the device catalog, not null terminated */
+  struct CatalogString {
+    const char* data;
+    size_t size;
+  };
+
+  /* The attributes of a model, pointing into the device catalog */
+  struct ModelInfo {
+    CatalogString brand;
+    CatalogString model;
+    CatalogString model_id;
+    CatalogString tag;
+  };
+
+  /* The boolean tags of a model, from the second octet of its tag */
+  enum TagFlag {
+    TAG_CIDC = 1 << 0, // not Company ID compliant
+    TAG_ACTS = 1 << 1, // active scanning required
+    TAG_CONT = 1 << 2, // continuous scanning required
+    TAG_TRACK = 1 << 3, // discoverable as device tracker
+    TAG_PRMAC = 1 << 4, // potential random MAC address device
+  };
+
+  /* A decoded property of a model, its unit and name */
+  struct CatalogProperty {
+    const char* key;
+    const char* unit;
+    const char* name;
+  };
+
+  /* A model of the device catalog with its property metadata, built once and valid until the program ends */
+  struct CatalogEntry {
+    int index; // BLE_ID_NUM of the model
+    const char* model_id;
+    const char* brand;
+    const char* model;
+    const char* tag;
+    const char* type; // nullptr if the tag has no known type
+    uint8_t flags; // TagFlag bits
+    int encr; // encryption mode, 0 if none
+    const CatalogProperty* properties;
+    size_t property_count;
+  };
+
+  /*
+   * The overloads without a document allocate one of getDocMax() bytes to
+   * parse the device definitions into. Without a heap (DECODER_NO_HEAP) they
+   * do not exist: the caller passes its own document, one per task decoding.
+   */
+#ifndef DECODER_NO_HEAP
   int decodeBLEJson(JsonObject& jsondata);
+#endif
+  int decodeBLEJson(JsonDocument& doc, JsonObject& jsondata);
+#ifndef DECODER_NO_HEAP
+  int decodeBLE(JsonObject& jsondata, const char* svc_data, const char* mfg_data,
+                const char* dev_name, const char* svc_uuid, const char* mac_id);
+#endif
+  int decodeBLE(JsonDocument& doc, JsonObject& jsondata, const char* svc_data, const char* mfg_data,
+                const char* dev_name, const char* svc_uuid, const char* mac_id);
+  size_t getDocMax();
   void setMinServiceDataLen(size_t len);
   void setMinManufacturerDataLen(size_t len);
   std::string getTheengProperties(const char* model_id);
   std::string getTheengProperties(int mod_index);
   std::string getTheengAttribute(const char* model_id, const char* attribute);
   std::string getTheengAttribute(int model_id, const char* attribute);
+  size_t getTheengProperties(int mod_index, char* out, size_t size);
+#ifndef DECODER_NO_HEAP
+  size_t getTheengAttribute(int model_id, const char* attribute, char* out, size_t size);
+#endif
+  size_t getTheengAttribute(JsonDocument& doc, int model_id, const char* attribute, char* out, size_t size);
   int getTheengModel(JsonDocument& doc, const char* model_id);
+  int getTheengModel(const char* model_id);
+  bool getModelInfo(int mod_index, ModelInfo& info);
+  const CatalogEntry* getCatalog(size_t* count);
 #ifdef UNIT_TESTING
   int testDocMax();
+  // called with true when the properties of a matched device start being decoded, false when done
+  static void (*testPropertiesHook)(bool decoding);
+#endif
+#ifdef DECODER_PROFILE
+  /* The cost of matching and decoding a model, accumulated since the last reset */
+  struct MatchProfile {
+    uint64_t evaluations; // times its conditions were checked against an advertisement
+    uint64_t comparisons; // primitive comparisons of the advertisement data executed by them
+    uint64_t matches;
+    uint64_t match_ns; // time spent in checkDeviceMatch
+    uint64_t prop_evaluations; // property conditions checked once matched
+    uint64_t prop_ns; // time spent in checkPropCondition
+  };
+
+  const MatchProfile* getMatchProfile(size_t* count) const;
+  void resetMatchProfile();
 #endif
 
   enum BLE_ID_NUM {
@@ -165,22 +264,204 @@ public:
     BLE_ID_MAX
   };
 
+  /* Why an advertisement was not decoded */
+  enum RejectReason {
+    REJECT_NO_DATA, // no service data, manufacturer data or name
+    REJECT_TOO_SHORT, // its data is shorter than the minimum lengths
+    REJECT_INVALID_INDEX, // a model condition compared beyond the end of its data
+    REJECT_CATALOG_ERROR, // a catalog entry could not be parsed
+    REJECT_NO_PROPERTIES, // a model matched but none of its properties decoded
+    REJECT_NO_MATCH, // no model matched
+    REJECT_TOO_MANY_ENTRIES, // none of the first MAX_SVC_DATA_ENTRIES service data entries decoded, the others left out
+    REJECT_REASON_COUNT
+  };
+
+  static const int STATS_LATENCY_BUCKETS = 20;
+
+  /* A snapshot of the counters shared by all the decoders of the process */
+  struct Stats {
+    uint64_t adverts;
+    uint64_t matches;
+    uint64_t rejects;
+    uint64_t reject_reasons[REJECT_REASON_COUNT];
+    uint64_t truncated; // advertisements with service data entries beyond MAX_SVC_DATA_ENTRIES, left out
+    uint64_t model_matches[BLE_ID_MAX]; // indexed by BLE_ID_NUM
+    uint64_t latency[STATS_LATENCY_BUCKETS]; // decodes taking less than 512 << i ns, the last bucket any longer
+    uint64_t latency_sum_us; // time spent in all the decodes, in microseconds
+  };
+
+  static void getStats(Stats& stats, bool reset = false);
+  static void resetStats();
+  static const char* getRejectReasonName(int reason);
+
+  /* Events of the decode trace, with the meaning of their TraceRecord fields */
+  enum TraceEvent {
+    TRACE_DECODE_START, // aux: service data length, value: manufacturer data length, -1 if absent
+    TRACE_DEVICE, // conditions of a device checked, result: matched
+    TRACE_DATA_LENGTH, // condition: its index, result: valid, aux: data length
+    TRACE_COMPARE, // condition: its index, result: equal, aux: data index or -1 for contain, value: length compared
+    TRACE_INVALID_INDEX, // condition: its index, aux: data index, value: data length
+    TRACE_PROPERTY, // condition of a property met, condition: rank of the property in the definition
+    TRACE_VALUE, // value extracted, condition: data offset, aux: length, value: the value as float bits
+    TRACE_DECODE_END, // device: model or -1, result: RejectReason or 0xff, value: latency in ns
+    TRACE_EVENT_COUNT
+  };
+
+  /* A decode trace record, laid out in the byte order of the target */
+  struct TraceRecord {
+    uint32_t time; // low 32 bits of a steady clock in ns
+    uint8_t event; // TraceEvent
+    uint8_t result;
+    int16_t device; // model index, -1 if none
+    int16_t condition;
+    int16_t aux;
+    int32_t value;
+  };
+
+  void setTrace(bool enabled) { m_trace = enabled; }
+  bool getTrace() const { return m_trace; }
+  static size_t readTrace(TraceRecord* records, size_t cap);
+  static void releaseTrace();
+
+  /* How the catalog is walked to find the model of an advertisement */
+  enum MatchEngine {
+    ENGINE_REFERENCE, // parses every definition in full, the results others are checked against
+    ENGINE_CONDITIONS, // parses the conditions only, and the full definition of the model matched
+    ENGINE_INDEXED, // as ENGINE_CONDITIONS, trying only the models whose key condition the advertisement meets
+    ENGINE_COUNT
+  };
+
+  /* The adverts decoded by the shadow engine too since the last reset */
+  struct ShadowStats {
+    uint64_t compared;
+    uint64_t skipped; // not compared, to keep the overhead within the budget
+    uint64_t unsampled; // left out of the sampled share
+    uint64_t model_mismatches; // decoded as another model, or by one engine only
+    uint64_t json_mismatches; // decoded as the same model into a different JSON
+    uint64_t ns; // decode time of the compared adverts
+    uint64_t shadow_ns; // decode time of the compared adverts with the shadow engine
+  };
+
+  /* An advertisement the engines decoded differently, its strings valid during the report only */
+  struct ShadowMismatch {
+    MatchEngine engine;
+    MatchEngine shadow;
+    int model;
+    int shadow_model;
+    const char* advert; // JSON of the advertisement before decoding
+    const char* decoded; // JSON once decoded by the engine
+    const char* shadow_decoded; // JSON once decoded by the shadow engine
+    uint64_t ns;
+    uint64_t shadow_ns;
+  };
+
+  typedef void (*ShadowReport)(const ShadowMismatch& mismatch);
+
+  void setEngine(MatchEngine engine) { m_engine = engine; }
+  MatchEngine getEngine() const { return m_engine; }
+  void setShadow(MatchEngine shadow, float budget, ShadowReport report = nullptr, float rate = 1);
+  void getShadowStats(ShadowStats& stats, bool reset = false);
+
+  /*
+   * The models the decoder tries, by BLE_ID_NUM, all by default. The models
+   * disabled are skipped before their conditions are parsed. Those appended
+   * with DECODER_EXTRA_DEVICES are always tried.
+   */
+  typedef std::bitset<BLE_ID_MAX> ModelMask;
+
+  void setEnabledModels(const ModelMask& models) { m_enabledModels = models; }
+  void setEnabledModels(const BLE_ID_NUM* models, size_t count);
+  const ModelMask& getEnabledModels() const { return m_enabledModels; }
+  void setModelEnabled(BLE_ID_NUM model, bool enabled);
+  bool setTypeEnabled(const char* type, bool enabled);
+
+  /*
+   * Decodes the values in fixed point rather than double, for the targets
+   * without an FPU, on by default with DECODER_FIXED_POINT. The values with
+   * decimals are added to the document as raw JSON numbers, formatted
+   * without floating point, which as<double>() reads as 0: readNumber reads
+   * them. Those out of the fixed-point range are decoded in double.
+   */
+  void setFixedPoint(bool enabled) { m_fixedPoint = enabled; }
+  bool getFixedPoint() const { return m_fixedPoint; }
+
+  /* Reads a decoded number into *number, raw JSON numbers included, returns false if value is not one */
+  static bool readNumber(JsonVariant value, double* number);
+
+  /* A value decoded in fixed point, defined with its arithmetic in decoder.cpp */
+  struct FixedValue;
+
 private:
+  /* The fields of an advertisement, entries meaning that its service data is an array of jsondata */
+  struct AdvertFields {
+    const char* svc_data;
+    const char* mfg_data;
+    const char* dev_name;
+    const char* svc_uuid;
+    const char* mac_id;
+    bool entries;
+  };
+
+  struct ShadowRun;
+  /* The models keyed by a condition every advertisement they decode meets, for ENGINE_INDEXED */
+  struct CandidateIndex;
+
   void        reverse_hex_data(const char* in, char* out, int l);
+  void        hex_from_data(const char* data_str, int offset, int data_length, bool reverse, char* data);
+  long long   int_from_hex_string(const char* data_str, int offset, int data_length, bool reverse, bool canBeNegative);
   double      value_from_hex_string(const char* data_str, int offset, int data_length, bool reverse, bool canBeNegative = true, bool isFloat = false);
   double      bf_value_from_hex_string(const char* data_str, int offset, int data_length, bool reverse, bool canBeNegative = true, bool isFloat = false);
   bool        data_index_is_valid(const char* str, size_t index, size_t len);
   bool        data_length_is_valid(size_t data_len, size_t default_min, const JsonArray& condition, int *idx);
   uint8_t     getBinaryData(char ch);
-  bool        evaluateDatalength(std::string op, size_t data_len, size_t req_len);
+  bool        evaluateDatalength(const char* op, size_t data_len, size_t req_len);
   bool        checkPropCondition(const JsonArray& prop, const char* svc_data, const char* mfg_data);
   bool        checkDeviceMatch(const JsonArray& condition, const char* svc_data, const char* mfg_data,
                                const char* dev_name, const char* svc_uuid, const char* mac_id);
-  std::string sanitizeJsonKey(const char* key_in);
+  bool        sanitizeJsonKey(const char* key_in, char* key_out);
+  bool        loadDevice(JsonDocument& doc, int index, bool condition_only = false);
+  JsonArray   deviceCondition(JsonDocument& doc);
+  const CandidateIndex& candidateIndex(JsonDocument& doc);
+  int         decodeAdvert(JsonDocument& doc, JsonObject& jsondata, const AdvertFields& fields);
+  int         matchAdvert(MatchEngine engine, JsonDocument& doc, JsonObject& jsondata, const AdvertFields& fields,
+                          RejectReason* reason);
+  int         matchServiceDataEntries(MatchEngine engine, JsonDocument& doc, JsonObject& jsondata,
+                                      const AdvertFields& fields, RejectReason* reason);
+  bool        runShadow(JsonDocument& doc, JsonObject& jsondata, const AdvertFields& fields, ShadowRun& run);
+  void        compareShadow(JsonObject& jsondata, int model, uint64_t ns, ShadowRun& run);
+  int         decodeDeviceProperties(JsonDocument& doc, int i_main, JsonObject& jsondata,
+                                     const char* svc_data, const char* mfg_data);
+  bool        matchDevice(int i_main, const JsonArray& condition, const char* svc_data, const char* mfg_data,
+                          const char* dev_name, const char* svc_uuid, const char* mac_id);
+  bool        matchProperty(int i_main, const JsonArray& prop_condition, const char* svc_data, const char* mfg_data);
+  bool        fixedValue(JsonObject prop, JsonArray decoder, const char* src, const FixedValue* cal,
+                         FixedValue& value, const char*& proc_str);
+  void        writeFixedValue(JsonObject& jsondata, char* key, const FixedValue& value, bool is_bool, const char* proc_str);
+  bool        modelEnabled(int i_main) const { return i_main >= BLE_ID_MAX || m_enabledModels.test(i_main); }
+  RejectReason rejectReason(const char* svc_data, const char* mfg_data);
 
-  size_t m_docMax = 12000;
+  size_t m_docMax = 12000; // DECODER_DOC_SIZE with DECODER_NO_HEAP
   size_t m_minSvcDataLen = 20;
   size_t m_minMfgDataLen = 16;
+  bool m_indexRejected = false; // a condition of the current decode compared beyond the end of the data
+  bool m_trace = false;
+  int m_traceDevice = -1; // the model traced records refer to
+  MatchEngine m_engine = ENGINE_REFERENCE;
+  MatchEngine m_shadow = ENGINE_REFERENCE;
+  ModelMask m_enabledModels = ModelMask().set();
+  bool m_fixedPoint = false; // true with DECODER_FIXED_POINT
+  float m_shadowBudget = 0; // shadow time allowed per unit of decode time, 0 when off
+  ShadowReport m_shadowReport = nullptr;
+  ShadowStats m_shadowStats = {};
+  uint64_t m_shadowDecodeNs = 0; // decode time of all the adverts since the shadow was set
+  uint64_t m_shadowCostNs = 0; // time spent running and comparing the shadow engine
+  float m_shadowRate = 1; // share of the adverts sampled for the shadow engine
+  float m_shadowSample = 0; // sampled when it reaches 1
+  std::unique_ptr<ShadowRun> m_shadowRun; // the buffers of the shadow decodes, kept while it is on
+#ifdef DECODER_PROFILE
+  MatchProfile m_profile[BLE_ID_MAX] = {};
+  MatchProfile* m_profiled = nullptr; // the model whose conditions are being checked
+#endif
 };
 
 #endif
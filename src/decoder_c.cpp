@@ -20,49 +20,332 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <memory>
+#include <vector>
+
 #include "decoder.h"
+#include "json_scanner.h"
 #ifdef SKBUILD
 #  include "shared/theengs.h"
 #else
 #  include "../include/shared/theengs.h"
 #endif
 
+/*
+ * What a decoder handle owns: the decoder and the buffers reused by every
+ * call, so that decoding into caller provided memory allocates nothing once
+ * they have grown to the size of the inputs.
+ */
+struct DecoderHandle {
+  TheengsDecoder decoder;
+  DynamicJsonDocument devices; // device definitions while matching
+  StaticJsonDocument<DECODED_DOC_SIZE> decoded;
+  std::unique_ptr<DynamicJsonDocument> entries; // inputs parsed completely, sized by the largest
+  std::string scratch; // copy of the input scanned in place, or hexadecimal data
+
+  DecoderHandle() : devices(decoder.getDocMax()) {}
+};
+
 // Utility function local to the bridge's implementation
-TheengsDecoder* AsDecoder(void* decoder) { return reinterpret_cast<TheengsDecoder*>(decoder); }
+static DecoderHandle* AsHandle(void* decoder) { return reinterpret_cast<DecoderHandle*>(decoder); }
 
 void* Theengs_NewDecoder() {
-  auto decoder = new TheengsDecoder();
-  return decoder;
+  auto handle = new DecoderHandle();
+  return handle;
 }
 
 void Theengs_DestroyDecoder(void* decoder) {
-  AsDecoder(decoder)->~TheengsDecoder();
+  delete AsHandle(decoder);
 }
 
-const char* Theengs_DecodeBLE(void* decoder, const char* json_data) {
-  StaticJsonDocument<1024> doc;
-  DeserializationError err = deserializeJson(doc, json_data);
-  if (!err) {
-    JsonObject bleObject;
-    bleObject = doc.as<JsonObject>();
-
-    if (AsDecoder(decoder)->decodeBLEJson(bleObject) >= 0) {
-      std::string buf;
-      serializeJson(bleObject, buf);
-      return strdup(buf.c_str());
+/*
+ * @brief The document kept by the handle for the inputs parsed completely,
+ * grown to hold an input of len characters.
+ */
+static DynamicJsonDocument& completeDocument(DecoderHandle* handle, size_t len) {
+  size_t capacity = len * 2 + DECODED_DOC_SIZE;
+  if (!handle->entries || handle->entries->capacity() < capacity) {
+    handle->entries.reset(new DynamicJsonDocument(capacity));
+  }
+  return *handle->entries;
+}
+
+static Theengs_Status decodeJson(DecoderHandle* handle, const char* json, size_t len,
+                                 char* out, size_t cap, size_t* out_len, int* model) {
+  *out_len = 0;
+  handle->scratch.assign(json, len);
+  JsonObject decoded = handle->decoded.to<JsonObject>();
+  AdvertJson advert;
+  size_t total;
+
+  if (scanAdvertJson(&handle->scratch[0], len, advert)) {
+    *model = handle->decoder.decodeBLE(handle->devices, decoded, advert.servicedata, advert.manufacturerdata,
+                                       advert.name, advert.servicedatauuid, advert.id);
+    if (*model < 0) {
+      return THEENGS_NO_MATCH;
+    }
+    if (!decodedKeyCollides(json, advert, decoded)) {
+      total = writeDecodedJson(json, advert, decoded, out, cap);
+    } else {
+      // the decoded members replace those of the input, in the complete document
+      DynamicJsonDocument& doc = completeDocument(handle, len);
+      if (!mergeDecodedJson(doc, json, len, decoded)) {
+        *model = -1;
+        return THEENGS_INVALID_INPUT;
+      }
+      total = measureJson(doc);
+      if (total < cap) {
+        serializeJson(doc, out, cap);
+      }
+    }
+  } else {
+    // several service data entries or not an object, the complete document is needed
+    DynamicJsonDocument& doc = completeDocument(handle, len);
+    DeserializationError err = deserializeJson(doc, json, len);
+    if (err || !doc.is<JsonObject>()) {
+      *model = -1;
+      return THEENGS_INVALID_INPUT;
+    }
+    JsonObject bleObject = doc.as<JsonObject>();
+    *model = handle->decoder.decodeBLEJson(handle->devices, bleObject);
+    if (*model < 0) {
+      return THEENGS_NO_MATCH;
+    }
+    total = measureJson(bleObject);
+    if (total < cap) {
+      serializeJson(bleObject, out, cap);
+    }
+  }
+
+  *out_len = total;
+  return total < cap ? THEENGS_OK : THEENGS_BUFFER_TOO_SMALL;
+}
+
+static void toHex(const uint8_t* data, size_t len, char* out) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < len; i++) {
+    *out++ = digits[data[i] >> 4];
+    *out++ = digits[data[i] & 0x0f];
+  }
+  *out = '\0';
+}
+
+static Theengs_Status decodeRaw(DecoderHandle* handle, const Theengs_Advert* advert,
+                                char* out, size_t cap, size_t* out_len, int* model) {
+  *out_len = 0;
+  const char* svc_data = nullptr;
+  const char* mfg_data = nullptr;
+  size_t svc_len = advert->servicedata != nullptr ? advert->servicedata_len : 0;
+  size_t mfg_len = advert->manufacturerdata != nullptr ? advert->manufacturerdata_len : 0;
+
+  handle->scratch.resize(svc_len * 2 + mfg_len * 2 + 2);
+  char* hex = &handle->scratch[0];
+  if (svc_len > 0) {
+    toHex(advert->servicedata, svc_len, hex);
+    svc_data = hex;
+    hex += svc_len * 2 + 1;
+  }
+  if (mfg_len > 0) {
+    toHex(advert->manufacturerdata, mfg_len, hex);
+    mfg_data = hex;
+  }
+
+  JsonObject decoded = handle->decoded.to<JsonObject>();
+  *model = handle->decoder.decodeBLE(handle->devices, decoded, svc_data, mfg_data,
+                                     advert->name, advert->servicedatauuid, advert->id);
+  if (*model < 0) {
+    return THEENGS_NO_MATCH;
+  }
+
+  size_t total = measureJson(decoded);
+  if (total < cap) {
+    serializeJson(decoded, out, cap);
+  }
+  *out_len = total;
+  return total < cap ? THEENGS_OK : THEENGS_BUFFER_TOO_SMALL;
+}
+
+/*
+ * @brief Fills results for a batch decoded by decodeOne(i, out, cap, out_len, model),
+ * placing the outputs one after the other in arena.
+ */
+template <typename Decode>
+static Theengs_Status decodeBatch(size_t count, char* arena, size_t arena_cap,
+                                  Theengs_Result* results, size_t* arena_used, Decode decodeOne) {
+  Theengs_Status batch_status = THEENGS_OK;
+  size_t used = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    Theengs_Result& result = results[i];
+    size_t len = 0;
+    int model = -1;
+    Theengs_Status status = decodeOne(i, arena + used, arena_cap - used, &len, &model);
+
+    result.status = status;
+    result.model = model;
+    result.offset = used;
+    result.length = 0;
+    if (status == THEENGS_OK) {
+      result.length = len;
+      used += len + 1;
+    } else if (status == THEENGS_BUFFER_TOO_SMALL) {
+      result.length = len;
+      batch_status = THEENGS_BUFFER_TOO_SMALL;
     }
   }
-  return "";
+
+  if (arena_used != nullptr) {
+    *arena_used = used;
+  }
+  return batch_status;
+}
+
+const char* Theengs_DecodeBLE(void* decoder, const char* json_data) {
+  std::string buf;
+  DecoderHandle* handle = AsHandle(decoder);
+  if (decodeBLEJsonText(handle->decoder, handle->devices, json_data, buf) >= 0) {
+    return strdup(buf.c_str());
+  }
+  return nullptr;
 }
 
 const char* Theengs_GetProperties(void* decoder, const char* model_id) {
-  std::string props = AsDecoder(decoder)->getTheengProperties(model_id);
+  std::string props = AsHandle(decoder)->decoder.getTheengProperties(model_id);
   return strdup(props.c_str());
 }
 
 const char* Theengs_GetAttribute(void* decoder, const char* model_id, const char* attribute) {
-  std::string attrs = AsDecoder(decoder)->getTheengAttribute(model_id, attribute);
+  std::string attrs = AsHandle(decoder)->decoder.getTheengAttribute(model_id, attribute);
   return strdup(attrs.c_str());
-}
\ No newline at end of file
+}
+
+void Theengs_FreeString(const char* str) {
+  free(const_cast<char*>(str));
+}
+
+Theengs_Status Theengs_DecodeBLEInto(void* decoder, const char* json_data,
+                                     char* out_buf, size_t out_cap, size_t* out_len) {
+  if (out_len != nullptr) {
+    *out_len = 0;
+  }
+  if (decoder == nullptr || json_data == nullptr || out_len == nullptr || (out_buf == nullptr && out_cap > 0)) {
+    return THEENGS_INVALID_ARGUMENT;
+  }
+  int model;
+  return decodeJson(AsHandle(decoder), json_data, strlen(json_data), out_buf, out_cap, out_len, &model);
+}
+
+Theengs_Status Theengs_DecodeBLEBatch(void* decoder, const char* inputs, const size_t* input_lens,
+                                      size_t count, char* arena, size_t arena_cap,
+                                      Theengs_Result* results, size_t* arena_used) {
+  if (decoder == nullptr || (count > 0 && (inputs == nullptr || input_lens == nullptr || results == nullptr)) ||
+      (arena == nullptr && arena_cap > 0)) {
+    return THEENGS_INVALID_ARGUMENT;
+  }
+  DecoderHandle* handle = AsHandle(decoder);
+  const char* input = inputs;
+  return decodeBatch(count, arena, arena_cap, results, arena_used,
+                     [&](size_t i, char* out, size_t cap, size_t* out_len, int* model) {
+                       Theengs_Status status = decodeJson(handle, input, input_lens[i], out, cap, out_len, model);
+                       input += input_lens[i];
+                       return status;
+                     });
+}
+
+Theengs_Status Theengs_DecodeBLERawInto(void* decoder, const Theengs_Advert* advert,
+                                        char* out_buf, size_t out_cap, size_t* out_len) {
+  if (out_len != nullptr) {
+    *out_len = 0;
+  }
+  if (decoder == nullptr || advert == nullptr || out_len == nullptr || (out_buf == nullptr && out_cap > 0)) {
+    return THEENGS_INVALID_ARGUMENT;
+  }
+  int model;
+  return decodeRaw(AsHandle(decoder), advert, out_buf, out_cap, out_len, &model);
+}
+
+Theengs_Status Theengs_DecodeBLERawBatch(void* decoder, const Theengs_Advert* adverts, size_t count,
+                                         char* arena, size_t arena_cap,
+                                         Theengs_Result* results, size_t* arena_used) {
+  if (decoder == nullptr || (count > 0 && (adverts == nullptr || results == nullptr)) ||
+      (arena == nullptr && arena_cap > 0)) {
+    return THEENGS_INVALID_ARGUMENT;
+  }
+  DecoderHandle* handle = AsHandle(decoder);
+  return decodeBatch(count, arena, arena_cap, results, arena_used,
+                     [&](size_t i, char* out, size_t cap, size_t* out_len, int* model) {
+                       return decodeRaw(handle, &adverts[i], out, cap, out_len, model);
+                     });
+}
+
+/*
+ * The catalog converted once to the C structures, pointing to the strings
+ * held by the decoder catalog.
+ */
+struct ModelCatalog {
+  std::vector<Theengs_Model> models;
+  std::vector<Theengs_Property> properties;
+
+  explicit ModelCatalog(TheengsDecoder& decoder) {
+    size_t count;
+    const TheengsDecoder::CatalogEntry* entries = decoder.getCatalog(&count);
+    size_t property_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+      property_count += entries[i].property_count;
+    }
+    // reserved so that the models can point into it while it is filled
+    properties.reserve(property_count);
+    models.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      const TheengsDecoder::CatalogEntry& entry = entries[i];
+      Theengs_Model& model = models[i];
+      model.index = entry.index;
+      model.model_id = entry.model_id;
+      model.brand = entry.brand;
+      model.model = entry.model;
+      model.tag = entry.tag;
+      model.type = entry.type;
+      model.flags = entry.flags;
+      model.encr = entry.encr;
+      model.properties = properties.data() + properties.size();
+      model.property_count = entry.property_count;
+      for (size_t p = 0; p < entry.property_count; ++p) {
+        Theengs_Property property = {entry.properties[p].key, entry.properties[p].unit, entry.properties[p].name};
+        properties.push_back(property);
+      }
+    }
+  }
+};
+
+const Theengs_Model* Theengs_GetCatalog(void* decoder, size_t* count) {
+  if (decoder == nullptr || count == nullptr) {
+    return nullptr;
+  }
+  static ModelCatalog catalog(AsHandle(decoder)->decoder);
+  *count = catalog.models.size();
+  return catalog.models.data();
+}
+
+static_assert(static_cast<int>(THEENGS_REJECT_REASON_COUNT) == TheengsDecoder::REJECT_REASON_COUNT, "reject reasons differ");
+static_assert(THEENGS_LATENCY_BUCKETS == TheengsDecoder::STATS_LATENCY_BUCKETS, "latency buckets differ");
+
+size_t Theengs_GetStats(Theengs_Stats* stats, uint64_t* model_matches, size_t model_cap, int reset) {
+  TheengsDecoder::Stats snapshot;
+  TheengsDecoder::getStats(snapshot, reset != 0);
+  if (stats != nullptr) {
+    stats->adverts = snapshot.adverts;
+    stats->matches = snapshot.matches;
+    stats->rejects = snapshot.rejects;
+    memcpy(stats->reject_reasons, snapshot.reject_reasons, sizeof(stats->reject_reasons));
+    stats->truncated = snapshot.truncated;
+    memcpy(stats->latency, snapshot.latency, sizeof(stats->latency));
+    stats->latency_sum_us = snapshot.latency_sum_us;
+  }
+  for (size_t i = 0; model_matches != nullptr && i < model_cap && i < TheengsDecoder::BLE_ID_MAX; ++i) {
+    model_matches[i] = snapshot.model_matches[i];
+  }
+  return TheengsDecoder::BLE_ID_MAX;
+}
@@ -235,4 +235,8 @@ const char* _devices[][2] = {
     {_SBDW_002C_ENCR_json, _SBDW_002C_ENCR_json_props},
     {_SBMO_003Z_json, _SBMO_003Z_json_props},
     {_SBMO_003Z_ENCR_json, _SBMO_003Z_ENCR_json_props},
+#ifdef DECODER_EXTRA_DEVICES
+// definitions appended after the catalog, e.g. the synthetic ones of bench/catalog_gen.cpp
+#  include DECODER_EXTRA_DEVICES
+#endif
 };
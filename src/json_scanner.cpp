@@ -0,0 +1,431 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "json_scanner.h"
+
+#include <string.h>
+
+static size_t skipWhitespace(const char* json, size_t pos, size_t len) {
+  while (pos < len && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) {
+    pos++;
+  }
+  return pos;
+}
+
+/*
+ * @brief Returns the index following the string starting at pos (on its opening quote), 0 if unterminated.
+ */
+static size_t skipString(const char* json, size_t pos, size_t len) {
+  for (pos++; pos < len; pos++) {
+    if (json[pos] == '\\') {
+      pos++;
+    } else if (json[pos] == '"') {
+      return pos + 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * @brief Returns the index following the value starting at pos, 0 if invalid.
+ */
+static size_t skipValue(const char* json, size_t pos, size_t len) {
+  int depth = 0;
+  while (pos < len) {
+    char ch = json[pos];
+    if (ch == '"') {
+      pos = skipString(json, pos, len);
+      if (pos == 0) {
+        return 0;
+      }
+      if (depth == 0) {
+        return pos;
+      }
+      continue;
+    }
+    if (ch == '{' || ch == '[') {
+      depth++;
+    } else if (ch == '}' || ch == ']') {
+      if (depth == 0) {
+        return pos;
+      }
+      if (--depth == 0) {
+        return pos + 1;
+      }
+    } else if (depth == 0 && (ch == ',' || ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')) {
+      return pos;
+    }
+    pos++;
+  }
+  return depth == 0 ? pos : 0;
+}
+
+static int hexDigit(char ch) {
+  if (ch >= '0' && ch <= '9') return ch - '0';
+  if (ch >= 'a' && ch <= 'f') return 10 + (ch - 'a');
+  if (ch >= 'A' && ch <= 'F') return 10 + (ch - 'A');
+  return -1;
+}
+
+static bool readCodeUnit(const char* in, unsigned int* unit) {
+  *unit = 0;
+  for (int i = 0; i < 4; i++) {
+    int digit = hexDigit(in[i]);
+    if (digit < 0) {
+      return false;
+    }
+    *unit = (*unit << 4) | static_cast<unsigned int>(digit);
+  }
+  return true;
+}
+
+/*
+ * @brief Unescapes in place the string whose content spans [begin, end) and
+ * null terminates it; the result is never longer than the escaped input.
+ */
+static bool unescapeString(char* json, size_t begin, size_t end) {
+  char* out = json + begin;
+  for (size_t pos = begin; pos < end; pos++) {
+    if (json[pos] != '\\') {
+      *out++ = json[pos];
+      continue;
+    }
+    if (++pos >= end) {
+      return false;
+    }
+    switch (json[pos]) {
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u': {
+        unsigned int cp;
+        if (pos + 4 >= end || !readCodeUnit(json + pos + 1, &cp)) {
+          return false;
+        }
+        pos += 4;
+        if (cp >= 0xd800 && cp < 0xdc00 && pos + 6 < end && json[pos + 1] == '\\' && json[pos + 2] == 'u') {
+          unsigned int low;
+          if (readCodeUnit(json + pos + 3, &low) && low >= 0xdc00 && low < 0xe000) {
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            pos += 6;
+          }
+        }
+        if (cp < 0x80) {
+          *out++ = static_cast<char>(cp);
+        } else if (cp < 0x800) {
+          *out++ = static_cast<char>(0xc0 | (cp >> 6));
+          *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+          *out++ = static_cast<char>(0xe0 | (cp >> 12));
+          *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+          *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+          *out++ = static_cast<char>(0xf0 | (cp >> 18));
+          *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+          *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+          *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+        }
+        break;
+      }
+      default: *out++ = json[pos]; break; // '"', '\\' and '/'
+    }
+  }
+  *out = '\0';
+  return true;
+}
+
+static bool keyEquals(const char* json, size_t begin, size_t end, const char* key) {
+  size_t key_len = strlen(key);
+  return end - begin == key_len && strncmp(json + begin, key, key_len) == 0;
+}
+
+/*
+ * @brief Scans the advertisement JSON object in a single pass and points the
+ * members read by the decoder into json, where they are unescaped and null
+ * terminated in place; the other members are skipped without being parsed.
+ * The spans of the keys are recorded, keys being left escaped. Returns false
+ * if json is not an object or if servicedata holds several entries, which
+ * require the complete document.
+ */
+bool scanAdvertJson(char* json, size_t len, AdvertJson& advert) {
+  memset(&advert, 0, sizeof(advert));
+
+  size_t pos = skipWhitespace(json, 0, len);
+  if (pos >= len || json[pos] != '{') {
+    return false;
+  }
+  pos = skipWhitespace(json, pos + 1, len);
+  if (pos < len && json[pos] == '}') {
+    advert.close = pos;
+    advert.empty = true;
+    return true;
+  }
+
+  while (pos < len && json[pos] == '"') {
+    size_t key_begin = pos + 1;
+    pos = skipString(json, pos, len);
+    if (pos == 0) {
+      return false;
+    }
+    size_t key_end = pos - 1;
+    if (advert.key_count < ADVERT_JSON_KEYS) {
+      advert.keys[advert.key_count][0] = key_begin;
+      advert.keys[advert.key_count][1] = key_end;
+    }
+    advert.key_count++;
+
+    pos = skipWhitespace(json, pos, len);
+    if (pos >= len || json[pos] != ':') {
+      return false;
+    }
+    pos = skipWhitespace(json, pos + 1, len);
+    if (pos >= len) {
+      return false;
+    }
+
+    const char** field = nullptr;
+    if (keyEquals(json, key_begin, key_end, "id")) {
+      field = &advert.id;
+    } else if (keyEquals(json, key_begin, key_end, "name")) {
+      field = &advert.name;
+    } else if (keyEquals(json, key_begin, key_end, "servicedata")) {
+      if (json[pos] == '[') {
+        return false;
+      }
+      field = &advert.servicedata;
+    } else if (keyEquals(json, key_begin, key_end, "servicedatauuid")) {
+      field = &advert.servicedatauuid;
+    } else if (keyEquals(json, key_begin, key_end, "manufacturerdata")) {
+      field = &advert.manufacturerdata;
+    }
+
+    size_t value_begin = pos;
+    pos = skipValue(json, pos, len);
+    if (pos == 0 || pos == value_begin) {
+      return false;
+    }
+
+    if (field != nullptr) {
+      if (json[value_begin] == '"') {
+        if (!unescapeString(json, value_begin + 1, pos - 1)) {
+          return false;
+        }
+        *field = json + value_begin + 1;
+      } else {
+        *field = nullptr;
+      }
+    }
+
+    pos = skipWhitespace(json, pos, len);
+    if (pos < len && json[pos] == ',') {
+      pos = skipWhitespace(json, pos + 1, len);
+    } else if (pos < len && json[pos] == '}') {
+      advert.close = pos;
+      return true;
+    } else {
+      return false;
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief Finds the string member key of the json object without parsing it,
+ * [*begin, *end) receiving the span of its content. Returns false if key is
+ * absent, not a string or holds escape sequences, json being left unchanged.
+ */
+bool findJsonString(const char* json, size_t len, const char* key, size_t* begin, size_t* end) {
+  size_t pos = skipWhitespace(json, 0, len);
+  if (pos >= len || json[pos] != '{') {
+    return false;
+  }
+  pos = skipWhitespace(json, pos + 1, len);
+
+  while (pos < len && json[pos] == '"') {
+    size_t key_begin = pos + 1;
+    pos = skipString(json, pos, len);
+    if (pos == 0) {
+      return false;
+    }
+    size_t key_end = pos - 1;
+
+    pos = skipWhitespace(json, pos, len);
+    if (pos >= len || json[pos] != ':') {
+      return false;
+    }
+    pos = skipWhitespace(json, pos + 1, len);
+
+    size_t value_begin = pos;
+    pos = skipValue(json, pos, len);
+    if (pos == 0 || pos == value_begin) {
+      return false;
+    }
+
+    if (keyEquals(json, key_begin, key_end, key)) {
+      if (json[value_begin] != '"' || memchr(json + value_begin, '\\', pos - value_begin) != nullptr) {
+        return false;
+      }
+      *begin = value_begin + 1;
+      *end = pos - 1;
+      return true;
+    }
+
+    pos = skipWhitespace(json, pos, len);
+    if (pos < len && json[pos] == ',') {
+      pos = skipWhitespace(json, pos + 1, len);
+    } else {
+      return false;
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief Writes the scanned input json followed by the decoded members into out,
+ * without parsing the input again. No decoded key may be one of the input, see
+ * decodedKeyCollides. Returns the length of the output; it is only written if
+ * out can hold it and its null terminator.
+ */
+size_t writeDecodedJson(const char* json, const AdvertJson& advert, JsonObject decoded, char* out, size_t cap) {
+  size_t head = advert.close;
+  while (head > 0 && (json[head - 1] == ' ' || json[head - 1] == '\t' || json[head - 1] == '\n' || json[head - 1] == '\r')) {
+    head--;
+  }
+
+  size_t total;
+  size_t start = head;
+  if (decoded.size() == 0) {
+    total = head + 1;
+  } else {
+    // the opening brace of the decoded members replaces the input one or becomes a comma
+    if (advert.empty) {
+      start = head - 1;
+    }
+    total = start + measureJson(decoded);
+  }
+
+  if (out == nullptr || total >= cap) {
+    return total;
+  }
+
+  memcpy(out, json, start);
+  if (decoded.size() == 0) {
+    out[head] = '}';
+    out[total] = '\0';
+  } else {
+    serializeJson(decoded, out + start, cap - start);
+    if (!advert.empty) {
+      out[start] = ',';
+    }
+  }
+  return total;
+}
+
+/*
+ * @brief Whether a decoded member has the key of a member of the scanned input
+ * json, which writeDecodedJson would write twice. The keys beyond the first
+ * ADVERT_JSON_KEYS, or holding escape sequences, are taken to collide.
+ */
+bool decodedKeyCollides(const char* json, const AdvertJson& advert, JsonObject decoded) {
+  if (advert.key_count > ADVERT_JSON_KEYS) {
+    return decoded.size() > 0;
+  }
+  for (size_t i = 0; i < advert.key_count; i++) {
+    size_t begin = advert.keys[i][0];
+    size_t end = advert.keys[i][1];
+    if (memchr(json + begin, '\\', end - begin) != nullptr) {
+      return decoded.size() > 0;
+    }
+    for (JsonPair kv : decoded) {
+      if (keyEquals(json, begin, end, kv.key().c_str())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*
+ * @brief Parses json into doc and sets the decoded members in it, replacing
+ * the input members of the same key as decodeBLEJson does. Returns false if
+ * json is not an object or doc cannot hold it.
+ */
+bool mergeDecodedJson(JsonDocument& doc, const char* json, size_t len, JsonObject decoded) {
+  DeserializationError err = deserializeJson(doc, json, len);
+  if (err || !doc.is<JsonObject>()) {
+    return false;
+  }
+  JsonObject merged = doc.as<JsonObject>();
+  for (JsonPair kv : decoded) {
+    if (!merged[kv.key()].set(kv.value())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * @brief Decodes the advertisement JSON text json into out, the input followed
+ * by the decoded members. The members read by the decoder are scanned from a
+ * copy of the input, the complete document is only parsed for several
+ * service data entries or a decoded key the input already has. devices holds the device definitions while matching,
+ * as for decodeBLE(doc, ...). Returns the decoded model index or -1, out is
+ * only written on success.
+ */
+int decodeBLEJsonText(TheengsDecoder& decoder, JsonDocument& devices, const char* json, std::string& out) {
+  size_t len = strlen(json);
+  std::string scratch(json, len);
+  AdvertJson advert;
+
+  if (scanAdvertJson(&scratch[0], len, advert)) {
+    StaticJsonDocument<DECODED_DOC_SIZE> doc;
+    JsonObject decoded = doc.to<JsonObject>();
+    int res = decoder.decodeBLE(devices, decoded, advert.servicedata, advert.manufacturerdata,
+                                advert.name, advert.servicedatauuid, advert.id);
+    if (res >= 0 && !decodedKeyCollides(json, advert, decoded)) {
+      out.resize(writeDecodedJson(json, advert, decoded, nullptr, 0));
+      writeDecodedJson(json, advert, decoded, &out[0], out.size() + 1);
+    } else if (res >= 0) {
+      DynamicJsonDocument merged(len * 2 + DECODED_DOC_SIZE);
+      if (!mergeDecodedJson(merged, json, len, decoded)) {
+        return -1;
+      }
+      out.clear();
+      serializeJson(merged, out);
+    }
+    return res;
+  }
+
+  DynamicJsonDocument doc(len * 2 + DECODED_DOC_SIZE);
+  DeserializationError err = deserializeJson(doc, json);
+  if (!err) {
+    JsonObject bleObject = doc.as<JsonObject>();
+    int res = decoder.decodeBLEJson(devices, bleObject);
+    if (res >= 0) {
+      out.clear();
+      serializeJson(bleObject, out);
+    }
+    return res;
+  }
+  return -1;
+}
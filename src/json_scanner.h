@@ -0,0 +1,64 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _JSON_SCANNER_H_
+#define _JSON_SCANNER_H_
+
+#include <stddef.h>
+
+#include <string>
+
+#include "decoder.h"
+
+/* Size of the document holding the decoded members of one advertisement */
+#ifndef DECODED_DOC_SIZE
+#  define DECODED_DOC_SIZE 1024
+#endif
+
+/* Member keys of an advertisement recorded by scanAdvertJson */
+#ifndef ADVERT_JSON_KEYS
+#  define ADVERT_JSON_KEYS 16
+#endif
+
+/*
+ * The members of an advertisement JSON object read by the decoder, pointing
+ * into the scanned buffer, nullptr when absent or not a string.
+ */
+struct AdvertJson {
+  const char* id;
+  const char* name;
+  const char* servicedata;
+  const char* servicedatauuid;
+  const char* manufacturerdata;
+  size_t close; // index of the closing brace of the object
+  bool empty; // the object has no member
+  size_t keys[ADVERT_JSON_KEYS][2]; // spans of the first member keys, as escaped in the input
+  size_t key_count; // members of the object
+};
+
+bool scanAdvertJson(char* json, size_t len, AdvertJson& advert);
+bool findJsonString(const char* json, size_t len, const char* key, size_t* begin, size_t* end);
+size_t writeDecodedJson(const char* json, const AdvertJson& advert, JsonObject decoded, char* out, size_t cap);
+bool decodedKeyCollides(const char* json, const AdvertJson& advert, JsonObject decoded);
+bool mergeDecodedJson(JsonDocument& doc, const char* json, size_t len, JsonObject decoded);
+int decodeBLEJsonText(TheengsDecoder& decoder, JsonDocument& devices, const char* json, std::string& out);
+
+#endif
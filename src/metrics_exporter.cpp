@@ -0,0 +1,266 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metrics_exporter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef METRICS_HTTP_LISTENER
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/time.h>
+#  include <unistd.h>
+
+#  ifdef MSG_NOSIGNAL
+#    define SEND_FLAGS MSG_NOSIGNAL // a scraper hanging up must not raise SIGPIPE
+#  else
+#    define SEND_FLAGS 0
+#  endif
+#endif
+
+static void writeFamily(std::string& out, const char* name, const char* type, const char* help) {
+  out += "# TYPE ";
+  out += name;
+  out += ' ';
+  out += type;
+  out += "\n# HELP ";
+  out += name;
+  out += ' ';
+  out += help;
+  out += '\n';
+}
+
+static void writeSample(std::string& out, const char* name, const std::string& labels, const char* number) {
+  out += name;
+  if (!labels.empty()) {
+    out += '{';
+    out += labels;
+    out += '}';
+  }
+  out += ' ';
+  out += number;
+  out += '\n';
+}
+
+static void writeSample(std::string& out, const char* name, const std::string& labels, uint64_t value) {
+  char number[24];
+  snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+  writeSample(out, name, labels, number);
+}
+
+static std::string labelValue(const char* value) {
+  std::string escaped = "\"";
+  for (const char* c = value; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      escaped += '\\';
+      escaped += *c;
+    } else if (*c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += *c;
+    }
+  }
+  return escaped + "\"";
+}
+
+/*
+ * @brief Appends stats to out in OpenMetrics text format: the advertisements
+ * handled, matched and rejected by reason, the matches of every model and
+ * the decode latency histogram, terminated by the "# EOF" line. Rates and
+ * ratios such as the throughput or the match ratio of a model are left to
+ * the queries of the scraper.
+ */
+void writeOpenMetrics(const TheengsDecoder::Stats& stats, std::string& out) {
+  writeFamily(out, "theengs_decoder_adverts", "counter", "Advertisements handled by the decoders.");
+  writeSample(out, "theengs_decoder_adverts_total", "", stats.adverts);
+
+  writeFamily(out, "theengs_decoder_matches", "counter", "Advertisements decoded.");
+  writeSample(out, "theengs_decoder_matches_total", "", stats.matches);
+
+  writeFamily(out, "theengs_decoder_rejects", "counter", "Advertisements not decoded, by reason.");
+  for (int i = 0; i < TheengsDecoder::REJECT_REASON_COUNT; ++i) {
+    writeSample(out, "theengs_decoder_rejects_total",
+                "reason=" + labelValue(TheengsDecoder::getRejectReasonName(i)), stats.reject_reasons[i]);
+  }
+
+  writeFamily(out, "theengs_decoder_truncated", "counter",
+              "Advertisements with service data entries left out, decoded or not.");
+  writeSample(out, "theengs_decoder_truncated_total", "", stats.truncated);
+
+  writeFamily(out, "theengs_decoder_model_matches", "counter", "Advertisements decoded, by model.");
+  TheengsDecoder decoder;
+  size_t count;
+  const TheengsDecoder::CatalogEntry* entries = decoder.getCatalog(&count);
+  for (size_t i = 0; i < count && i < TheengsDecoder::BLE_ID_MAX; ++i) {
+    writeSample(out, "theengs_decoder_model_matches_total",
+                "model_id=" + labelValue(entries[i].model_id) + ",index=\"" + std::to_string(i) + "\"",
+                stats.model_matches[i]);
+  }
+
+  writeFamily(out, "theengs_decoder_decode_latency_seconds", "histogram", "Time spent decoding an advertisement.");
+  uint64_t cumulative = 0;
+  for (int i = 0; i < TheengsDecoder::STATS_LATENCY_BUCKETS; ++i) {
+    cumulative += stats.latency[i];
+    char bound[24];
+    if (i < TheengsDecoder::STATS_LATENCY_BUCKETS - 1) {
+      snprintf(bound, sizeof(bound), "%g", (512ULL << i) * 1e-9);
+    } else {
+      strcpy(bound, "+Inf");
+    }
+    writeSample(out, "theengs_decoder_decode_latency_seconds_bucket", "le=\"" + std::string(bound) + "\"", cumulative);
+  }
+  writeSample(out, "theengs_decoder_decode_latency_seconds_count", "", cumulative);
+  char seconds[32]; // exact, the sum being counted in microseconds
+  snprintf(seconds, sizeof(seconds), "%llu.%06llu", static_cast<unsigned long long>(stats.latency_sum_us / 1000000),
+           static_cast<unsigned long long>(stats.latency_sum_us % 1000000));
+  writeSample(out, "theengs_decoder_decode_latency_seconds_sum", "", seconds);
+
+  out += "# EOF\n";
+}
+
+#ifdef METRICS_HTTP_LISTENER
+/*
+ * @brief Listens on 127.0.0.1:port, port 0 picking a free one reported by
+ * port(), and starts serving. Returns false if already started or if the
+ * socket cannot be bound.
+ */
+bool MetricsListener::start(uint16_t port) {
+  if (m_running) {
+    return false;
+  }
+  m_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (m_socket < 0) {
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  socklen_t addr_len = sizeof(addr);
+  if (bind(m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+      listen(m_socket, 4) < 0 ||
+      getsockname(m_socket, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) < 0) {
+    close(m_socket);
+    m_socket = -1;
+    return false;
+  }
+  m_port = ntohs(addr.sin_port);
+  m_running = true;
+  m_thread = std::thread(&MetricsListener::serve, this);
+  return true;
+}
+
+/*
+ * @brief Stops serving, waiting for the request in progress if any.
+ */
+void MetricsListener::stop() {
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  m_thread.join();
+  close(m_socket);
+  m_socket = -1;
+  m_port = 0;
+}
+
+void MetricsListener::serve() {
+  struct pollfd listening = {m_socket, POLLIN, 0};
+  while (m_running) {
+    // woken up regularly to notice stop()
+    if (poll(&listening, 1, 100) <= 0) {
+      continue;
+    }
+    int client = accept(m_socket, nullptr, nullptr);
+    if (client >= 0) {
+      respond(client);
+      close(client);
+    }
+  }
+}
+
+static void sendAll(int client, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(client, data.data() + sent, data.size() - sent, SEND_FLAGS);
+    if (n <= 0) {
+      return;
+    }
+    sent += n;
+  }
+}
+
+/*
+ * @brief Reads the request of client, up to the end of its headers, and
+ * answers GET /metrics with the counters, anything else with an error.
+ */
+void MetricsListener::respond(int client) {
+  struct timeval timeout = {1, 0};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  char buf[512];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < 4096) {
+    ssize_t n = recv(client, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      return;
+    }
+    request.append(buf, n);
+  }
+
+  std::string status = "200 OK";
+  std::string type = OPENMETRICS_CONTENT_TYPE;
+  std::string body;
+  bool head = request.compare(0, 5, "HEAD ") == 0;
+  if (!head && request.compare(0, 4, "GET ") != 0) {
+    status = "405 Method Not Allowed";
+  } else {
+    size_t path = request.find(' ') + 1;
+    size_t path_end = request.find_first_of(" ?\r", path);
+    if (request.compare(path, path_end - path, "/metrics") != 0) {
+      status = "404 Not Found";
+    }
+  }
+  if (status[0] == '2') {
+    TheengsDecoder::Stats stats;
+    TheengsDecoder::getStats(stats);
+    writeOpenMetrics(stats, body);
+  } else {
+    type = "text/plain; charset=utf-8";
+    body = status + "\n";
+  }
+
+  std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + type +
+                         "\r\nContent-Length: " + std::to_string(body.size()) +
+                         "\r\nConnection: close\r\n\r\n";
+  if (!head) {
+    response += body;
+  }
+  sendAll(client, response);
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+    TheengsDecoder - Decode things and devices
+
+    Copyright: (c)Florian ROBERT
+
+    This file is part of TheengsDecoder.
+
+    TheengsDecoder is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    TheengsDecoder is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _METRICS_EXPORTER_H_
+#define _METRICS_EXPORTER_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "decoder.h"
+
+#define OPENMETRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+void writeOpenMetrics(const TheengsDecoder::Stats& stats, std::string& out);
+
+/* The HTTP listener, built with DECODER_METRICS_HTTP, needs POSIX sockets and threads */
+#if defined(DECODER_METRICS_HTTP) && !defined(ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#  define METRICS_HTTP_LISTENER 1
+
+#  include <atomic>
+#  include <thread>
+
+/*
+ * Serves the decoder counters in OpenMetrics text format on
+ * http://127.0.0.1:<port>/metrics from a thread of its own, one request at
+ * a time, until stopped or destroyed.
+ */
+class MetricsListener {
+public:
+  MetricsListener() : m_running(false) {}
+  ~MetricsListener() { stop(); }
+
+  bool start(uint16_t port);
+  void stop();
+  uint16_t port() const { return m_port; }
+
+private:
+  MetricsListener(const MetricsListener&);
+  MetricsListener& operator=(const MetricsListener&);
+
+  void serve();
+  void respond(int client);
+
+  int m_socket = -1;
+  uint16_t m_port = 0;
+  std::atomic<bool> m_running;
+  std::thread m_thread;
+};
+#endif
+
+#endif
@@ -0,0 +1,400 @@
+// Heap accounting of the decoder: the global operator new/delete and the
+// malloc family are hooked to count the allocations and bytes of every
+// decode, the peak heap of each model and code path, and to detect leaks.
+//
+//   test_alloc [--budget bytes | --esp32]
+//
+// With a budget, allocations that would take the heap used by a decode over
+// it fail as they would on the device, and the test fails.
+
+#include <stdint.h>
+
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+
+#include "decoder.h"
+#include "shared/theengs.h"
+#include "test_ble_adverts.h"
+
+#ifdef __GLIBC__
+#  include <malloc.h>
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+
+// Heap available to the decoder on an ESP32 running a gateway with BLE enabled
+static const size_t ESP32_DECODE_BUDGET = 32 * 1024;
+
+enum Path {
+  PATH_MATCH, // walking the devices, up to a match
+  PATH_PROPERTIES, // decoding the properties of the matched device
+  PATH_GETTERS, // model attributes, properties and catalog
+  PATH_C_API, // C API calls, their decode included
+  PATH_COUNT
+};
+
+static const char* const path_names[PATH_COUNT] = {"match", "properties", "getters", "C API"};
+
+struct Usage {
+  size_t allocs;
+  size_t bytes;
+  size_t peak; // highest heap used above the start of the scope
+};
+
+// What the hooks account, only while a scope is open
+struct Tracker {
+  bool active;
+  int path;
+  long live; // bytes allocated minus bytes freed since the scope opened
+  size_t budget; // 0 for no budget
+  bool budgeted; // the budget applies to the scope
+  bool over_budget;
+  Usage total;
+  Usage paths[PATH_COUNT];
+};
+
+static Tracker tracker;
+
+// The size requested for each live block, the usable size malloc rounds it
+// up to varying with the heap layout: open addressing over a static table,
+// as the hooks cannot allocate
+static const unsigned SIZES_BITS = 20;
+static const size_t SIZES_MASK = (static_cast<size_t>(1) << SIZES_BITS) - 1;
+
+struct Block {
+  void* ptr;
+  size_t size;
+};
+
+static Block blocks[SIZES_MASK + 1];
+
+static size_t blockSlot(void* ptr) {
+  return static_cast<size_t>((reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ULL >> (64 - SIZES_BITS));
+}
+
+static void addBlock(void* ptr, size_t size) {
+  size_t i = blockSlot(ptr);
+  while (blocks[i].ptr != nullptr && blocks[i].ptr != ptr) {
+    i = (i + 1) & SIZES_MASK;
+  }
+  blocks[i].ptr = ptr;
+  blocks[i].size = size;
+}
+
+// Removes the block and returns its size, 0 if it was allocated before the
+// hooks, shifting back the blocks probed past its slot
+static size_t removeBlock(void* ptr) {
+  size_t i = blockSlot(ptr);
+  while (blocks[i].ptr != ptr) {
+    if (blocks[i].ptr == nullptr) {
+      return 0;
+    }
+    i = (i + 1) & SIZES_MASK;
+  }
+  size_t size = blocks[i].size;
+  for (size_t j = (i + 1) & SIZES_MASK; blocks[j].ptr != nullptr; j = (j + 1) & SIZES_MASK) {
+    size_t home = blockSlot(blocks[j].ptr);
+    if (((j - home) & SIZES_MASK) >= ((j - i) & SIZES_MASK)) {
+      blocks[i] = blocks[j];
+      i = j;
+    }
+  }
+  blocks[i].ptr = nullptr;
+  return size;
+}
+
+static void recordAlloc(void* ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  addBlock(ptr, size);
+  if (!tracker.active) {
+    return;
+  }
+  tracker.live += static_cast<long>(size);
+  size_t live = tracker.live > 0 ? static_cast<size_t>(tracker.live) : 0;
+  Usage* usages[] = {&tracker.total, &tracker.paths[tracker.path]};
+  for (Usage* usage : usages) {
+    usage->allocs++;
+    usage->bytes += size;
+    if (live > usage->peak) {
+      usage->peak = live;
+    }
+  }
+}
+
+static void recordFree(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  size_t size = removeBlock(ptr);
+  if (tracker.active) {
+    tracker.live -= static_cast<long>(size);
+  }
+}
+
+// Whether allocating size more bytes keeps the scope within its budget
+static bool withinBudget(size_t size) {
+  if (!tracker.active || !tracker.budgeted || tracker.budget == 0 || tracker.live + static_cast<long>(size) <= static_cast<long>(tracker.budget)) {
+    return true;
+  }
+  tracker.over_budget = true;
+  return false;
+}
+
+extern "C" void* malloc(size_t size) noexcept {
+  if (!withinBudget(size)) {
+    return nullptr;
+  }
+  void* ptr = __libc_malloc(size);
+  recordAlloc(ptr, size);
+  return ptr;
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+  if (!withinBudget(count * size)) {
+    return nullptr;
+  }
+  void* ptr = __libc_calloc(count, size);
+  recordAlloc(ptr, count * size);
+  return ptr;
+}
+
+extern "C" void* realloc(void* ptr, size_t size) noexcept {
+  if (!withinBudget(size)) {
+    return nullptr;
+  }
+  void* moved = __libc_realloc(ptr, size);
+  if (moved != nullptr || size == 0) {
+    recordFree(ptr);
+    recordAlloc(moved, size);
+  }
+  return moved;
+}
+
+extern "C" void free(void* ptr) noexcept {
+  recordFree(ptr);
+  __libc_free(ptr);
+}
+
+void* operator new(size_t size) {
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+// Accounts the property decodes of the decoder calls made in a match scope to their own path
+static void propertiesHook(bool decoding) {
+  if (tracker.path == PATH_MATCH || tracker.path == PATH_PROPERTIES) {
+    tracker.path = decoding ? PATH_PROPERTIES : PATH_MATCH;
+  }
+}
+
+// Opens a scope accounting the calls that follow to path, the budget only applying to decodes
+static void beginScope(int path) {
+  size_t budget = tracker.budget;
+  tracker = Tracker();
+  tracker.budget = budget;
+  tracker.budgeted = path != PATH_GETTERS;
+  tracker.path = path;
+  tracker.active = true;
+}
+
+/*
+ * @brief Closes the scope opened by beginScope, what being built beforehand
+ * so that it is not accounted, returns false and reports what if some of
+ * its allocations are still live (unless allowed for buffers kept between
+ * calls) or the budget was exceeded.
+ */
+static bool endScope(const std::string& what, bool keeps_buffers = false) {
+  tracker.active = false;
+  if (tracker.live != 0 && !keeps_buffers) {
+    std::cout << "FAILED! " << what << " leaked " << tracker.live << " bytes" << std::endl;
+    return false;
+  }
+  if (tracker.over_budget) {
+    std::cout << "FAILED! " << what << " needs more than the " << tracker.budget << " bytes budget, peak "
+              << tracker.total.peak << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static void maxUsage(Usage& into, const Usage& usage) {
+  into.allocs = usage.allocs > into.allocs ? usage.allocs : into.allocs;
+  into.bytes = usage.bytes > into.bytes ? usage.bytes : into.bytes;
+  into.peak = usage.peak > into.peak ? usage.peak : into.peak;
+}
+
+static void printUsage(const std::string& name, const Usage& usage) {
+  std::cout << "  " << name << ": " << usage.allocs << " allocs, " << usage.bytes << " bytes, peak "
+            << usage.peak << std::endl;
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--esp32") {
+      tracker.budget = ESP32_DECODE_BUDGET;
+    } else if (arg == "--budget" && i + 1 < argc) {
+      tracker.budget = std::stoul(argv[++i]);
+    } else {
+      std::cout << "usage: " << argv[0] << " [--budget bytes | --esp32]" << std::endl;
+      return 1;
+    }
+  }
+
+  TheengsDecoder decoder;
+  TheengsDecoder::testPropertiesHook = propertiesHook;
+  DynamicJsonDocument devices(decoder.getDocMax()); // the definitions without a heap, the decoder having no document
+  std::vector<Advert> adverts = testVectors();
+  adverts.push_back(makeAdvert("unknown service data", -1, nullptr, nullptr, "0xfa11", "123456789abcdef0", nullptr));
+  adverts.push_back(makeAdvert("unknown manufacturer data", -1, "AA:BB:CC:DD:EE:FF", nullptr, nullptr, nullptr, "ffff0102030405"));
+  // decoded by the C API into the document its handle keeps for several service data entries
+  const char* entries = "{\"servicedata\":[{\"servicedatauuid\":\"fe95\",\"servicedata\":\"70205b04756ab883c8593f090410020001\"},"
+                        "{\"servicedatauuid\":\"fa11\",\"servicedata\":\"123456789abcdef\"}]}";
+  void* handle = Theengs_NewDecoder();
+  char out[2048];
+  size_t out_len;
+  size_t count;
+
+  // the first calls build the catalog caches and the buffers kept between calls
+  for (const Advert& advert : adverts) {
+    StaticJsonDocument<2048> doc;
+    decodeAdvert(decoder, devices, doc, advert);
+    Theengs_DecodeBLEInto(handle, advert.json.c_str(), out, sizeof(out), &out_len);
+  }
+  Theengs_DecodeBLEInto(handle, entries, out, sizeof(out), &out_len);
+  decoder.getCatalog(&count);
+  Theengs_GetCatalog(handle, &count);
+
+  bool passed = true;
+  std::map<int, Usage> models;
+  Usage paths[PATH_COUNT] = {};
+  Usage decodes = {};
+
+  for (const Advert& advert : adverts) {
+    std::string what = std::string(advert.test) + " " + advert.json;
+    beginScope(PATH_MATCH);
+    int res = -1;
+    try {
+      StaticJsonDocument<2048> doc;
+      res = decodeAdvert(decoder, devices, doc, advert);
+    } catch (const std::bad_alloc&) {
+      tracker.over_budget = true;
+    }
+    passed &= endScope(what);
+    if (res != advert.expected && !tracker.over_budget) {
+      std::cout << "FAILED! " << advert.test << " decoded to " << res << ", " << advert.expected << " expected" << std::endl;
+      passed = false;
+    }
+    maxUsage(models[advert.expected], tracker.total);
+    maxUsage(decodes, tracker.total);
+    maxUsage(paths[PATH_MATCH], tracker.paths[PATH_MATCH]);
+    maxUsage(paths[PATH_PROPERTIES], tracker.paths[PATH_PROPERTIES]);
+  }
+
+  for (int i = 0; i < TheengsDecoder::BLE_ID_NUM::BLE_ID_MAX; ++i) {
+    std::string model_id = decoder.getTheengAttribute(i, "model_id");
+    std::string what = "getters of " + model_id;
+    beginScope(PATH_GETTERS);
+    decoder.getTheengModel(model_id.c_str());
+    decoder.getTheengAttribute(model_id.c_str(), "brand");
+    decoder.getTheengAttribute(model_id.c_str(), "condition");
+    decoder.getTheengProperties(model_id.c_str());
+    decoder.getCatalog(&count);
+    passed &= endScope(what);
+    maxUsage(paths[PATH_GETTERS], tracker.paths[PATH_GETTERS]);
+  }
+
+  // the handle keeps its buffers between calls: a second pass over the same
+  // adverts must leave them as the first one did
+  for (int pass = 0; pass < 2; ++pass) {
+    long retained = 0;
+    for (const Advert& advert : adverts) {
+      std::string what = "C API " + advert.json;
+      beginScope(PATH_C_API);
+      try {
+        Theengs_DecodeBLEInto(handle, advert.json.c_str(), out, sizeof(out), &out_len);
+        Theengs_FreeString(Theengs_DecodeBLE(handle, advert.json.c_str()));
+        Theengs_GetCatalog(handle, &count);
+      } catch (const std::bad_alloc&) {
+        tracker.over_budget = true;
+      }
+      passed &= endScope(what, true);
+      retained += tracker.live;
+      maxUsage(paths[PATH_C_API], tracker.total);
+    }
+    std::string what = std::string("C API ") + entries;
+    beginScope(PATH_C_API);
+    try {
+      Theengs_DecodeBLEInto(handle, entries, out, sizeof(out), &out_len);
+    } catch (const std::bad_alloc&) {
+      tracker.over_budget = true;
+    }
+    passed &= endScope(what, true);
+    retained += tracker.live;
+    maxUsage(paths[PATH_C_API], tracker.total);
+    if (pass == 1 && retained != 0) {
+      std::cout << "FAILED! the C API decoder handle grew by " << retained << " bytes" << std::endl;
+      passed = false;
+    }
+  }
+
+  TheengsDecoder::testPropertiesHook = nullptr;
+  Theengs_DestroyDecoder(handle);
+
+  std::cout << "heap use per model, highest of its vectors (-1 for the unknown ones):" << std::endl;
+  for (std::map<int, Usage>::iterator it = models.begin(); it != models.end(); ++it) {
+    printUsage(it->first < 0 ? "-1" : std::to_string(it->first) + " " + decoder.getTheengAttribute(it->first, "model_id"), it->second);
+  }
+  std::cout << "heap use per path, highest of a call:" << std::endl;
+  for (int i = 0; i < PATH_COUNT; ++i) {
+    printUsage(path_names[i], paths[i]);
+  }
+  printUsage("decode", decodes);
+  if (tracker.budget != 0) {
+    std::cout << "budget: " << tracker.budget << " bytes" << std::endl;
+  }
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout << "allocation tests passed" << std::endl;
+  return 0;
+}
+
+#else
+
+int main() {
+  std::cout << "the allocation hooks need glibc, skipped" << std::endl;
+  return 0;
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include <limits>
 
 #include "decoder.h"
+#include "test_ble_adverts.h"
 
 const char* expected_servicedata[] = {
     "{\"brand\":\"Xiaomi\",\"model\":\"Mi Jia round\",\"model_id\":\"LYWSDCGQ\",\"type\":\"THB\",\"tempc\":26,\"tempf\":78.8,\"hum\":61.4,\"mac\":\"58:2D:34:33:AA:DF\"}",
@@ -415,836 +416,6 @@ const char* expected_mac_mfgsvcdata[] = {
     "{\"brand\":\"April Brother\",\"model\":\"ABTemp\",\"model_id\":\"ABTemp\",\"type\":\"BCON\",\"track\":true,\"mfid\":\"4c00\",\"uuid\":\"b5b182c7eab14988aa99b5c1517008d9\",\"major\":1,\"batt\":100,\"tempc\":26,\"tempf\":78.8,\"txpower\":-59,\"mac\":\"D5:FE:15:49:AC:7D\"}",
 };
 
-// Service data test input [test name] [data]
-const char* test_servicedata[][2] = {
-    {"Mi jia round sensor", "5020aa0137dfaa33342d580d100404016602"},
-    {"Mi jia round sensor", "5020aa018ddfaa33342d580610026602"},
-    {"Mi jia round sensor", "5020aa0155ffeeddccbbaa0a100151"},
-    {"Mi jia round sensor", "5020aa01123c0338342d580a10013e"},
-    {"Mi jia round sensor", "5020aa018ddfaa33342d580410021201"},
-    {"Formaldehyde detector", "5020df02383a5c014357480a10015e"},
-    {"Formaldehyde detector", "5020df02283a5c014357480610025302"},
-    {"Formaldehyde detector", "5020df025b3a5c014357481010020800"},
-    {"Formaldehyde detector", "5120df023effeeddccbbaa041002c400"},
-    {"RoPot", "71205d0183d20c6d8d7cc40d08100103"},
-    {"RoPot", "71205d0188ffeeddccbbaa0d0910020100"},
-    {"AprilBrother N03", "ab03aabbccddeeff64ebff7f005e01"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_svcdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::LYWSDCGQ,
-    TheengsDecoder::BLE_ID_NUM::LYWSDCGQ,
-    TheengsDecoder::BLE_ID_NUM::LYWSDCGQ,
-    TheengsDecoder::BLE_ID_NUM::LYWSDCGQ,
-    TheengsDecoder::BLE_ID_NUM::LYWSDCGQ,
-    TheengsDecoder::BLE_ID_NUM::JQJCY01YM,
-    TheengsDecoder::BLE_ID_NUM::JQJCY01YM,
-    TheengsDecoder::BLE_ID_NUM::JQJCY01YM,
-    TheengsDecoder::BLE_ID_NUM::JQJCY01YM,
-    TheengsDecoder::BLE_ID_NUM::HHCCPOT002,
-    TheengsDecoder::BLE_ID_NUM::HHCCPOT002,
-    TheengsDecoder::BLE_ID_NUM::ABN03,
-};
-
-// manufacturer data test input [test name] [device name] [data]
-const char* test_mfgdata[][3] = {
-    {"Inkbird TH1", "sps", "660a03150010805908"},
-    {"Inkbird TH1", "sps", "f009fe1301ca893008"},
-    {"iBeacon", "BlueCharm_135727", "4c000215426c7565436861726d426561636f6e730efe1355c5"},
-    {"iBeacon", "NRF51822", "4c000215fda50693a4e24fb1afcfc6eb07647825000100021a"},
-    {"H5055", "GVH5055", "cf040400461b061700ffff2c01067300ffff2c010000"},
-    {"H5055", "GVH5055", "cf040400417f065600ffff2c01069100ffff2c010"},
-    {"H5055", "GVH5055", "cf04040061bf065c00ffff2c01063700ffff2c010000"},
-    {"H5055", "GVH5055", "cf040400538f06ffffffff2c01065400ffff2c010"},
-    {"H5075", "GVH5075_1234", "88ec000418ee6400"},
-    {"H5075", "GVH5075_1234", "88ec00811f096400"},
-    {"H5072", "GVH5072_1234", "88ec0004344b6400"},
-    {"H5102", "GVH5102_1234", "0100010103590e64"},
-    {"Inkbird TH2", "tps", "660a19200010805908"},
-    {"Inkbird TH2", "tps", "76fb00000010805908"},
-    {"Inkbird TH2", "sps", "e300bb070093c36406"},
-    {"Inkbird P01B", "tps", "840affff00a6066008"},
-    {"iNodeEM", "electricity", "90826300f0cf0000c409820080"},
-    {"iNodeEM", "electricity", "94826300f0cf0000c409260080"},
-    {"iNodeEM", "electricity", "90826300f0cf0000c409b60080"},
-    {"iNodeEM", "electricity", "92826300f0cf0000c409160080"},
-    {"iNodeEM", "electricity", "9082dd0061b80000c4096b0080"},
-    {"iNodeEM", "water", "90826300f0cf0000c419760080"},
-    {"iNodeEM", "water", "9682dd0061b80000c4193b0080"},
-    {"RuuviTag RAWv1", "RuuviTag", "990403291A1ECE1EFC18F94202CA0B53"},
-    {"RuuviTag RAWv1", "RuuviTag maximum values", "990403FF7F63FFFF7FFF7FFF7FFFFFFF"},
-    {"RuuviTag RAWv1", "RuuviTag minimum values", "99040300FF6300008001800180010000"},
-    {"BlueMaestro", "TempoDisc 3in1", "330117560e10177000ef01b3006c0100"},
-    {"BlueMaestro", "TempoDisc 3in1", "330116430e10061eff5d030fff400100"},
-    {"BlueMaestro", "TempoDisc 4in1", "33011b3a0e10061e00df02f727970100"},
-    {"BlueMaestro", "TempoDisc 1in1", "33010d6402580ad100fc0100"},
-    {"MS-CDP", "Windows 10 Desktop", "060001092002ac6d90ec0132b3204cd39c7ced3e48436ba15dc6314778"},
-    {"BM2", "Battery Monitor", "4c000215655f83caae16a10a702e31f30d58dd82f644000064"},
-    {"BM2", "Battery Monitor", "4c000215655f83caae16a10a702e31f30d58dd82f441423144"},
-    {"SmartDry", "Laundry Sensor", "ae0156d708420000c84252006907"},
-    {"SmartDry", "Laundry Sensor", "ae019bc8af4108d7c34208016807"},
-    {"SmartDry", "Laundry Sensor", "ae018c60fe41b8fbc64233006d07"},
-    {"SmartDry", "Laundry Sensor", "ae01ca9dec4160fc5f424a005207"},
-    {"SmartDry", "Laundry Sensor", "ae01ca9dec4160fc5f424a005200"},
-    {"SmartDry", "Laundry Sensor", "ae01ca9dec4160fc5f424a005206"},
-    {"Amphiro", "Digital Hand Shower", "eefa0000240015000015001a0029000c194f000000"},
-    {"ThermoPro", "TP357", "c2100147022c"},
-    {"ThermoPro", "TP357", "c276014a022c"},
-    {"ThermoPro", "TP357S", "c2d60043220b01"},
-    {"ThermoPro", "TP358", "c2f50032022c"},
-    {"ThermoPro", "TP358", "c2f60033022c"},
-    {"ThermoPro", "TP359", "c2ff0035012c"},
-    {"ThermoPro", "TP393", "c2d40037022c"},
-    {"Oria", "T301", "55aa0105aabbccddeeff01070a0015e0630001"},
-    {"Oria", "T301", "55aa0105aabbccddeeff010709e215e0530001"},
-    {"Oria", "T301", "55aa0105aabbccddeeff01070a3c170c440001"},
-    {"Oria", "T201", "55aa0101a4c13874b08501070a1d10f064000100"},
-    {"BeeWi", "BSDOO", "0d00080c000664"},
-    {"BeeWi", "BSDOO", "0d00080c010664"},
-    {"Sensirion SHT4X", "SHT4X", "d5060006e2e7036a1c65"},
-    {"Sensirion SHT4X", "SHT4X", "d5060006e2e733339dc4"},
-    {"Sensirion SHT4X", "SHT4X", "d5060006e2e72b3e6891"},
-    {"Sensirion SHT4X", "SHT4X", "d5060006e2e7036a1c650d09534854343020476164676574"},
-    {"Sensirion MyCO2", "SCD4X", "d506000ae2e733339dc4e902"},
-    {"Sensirion MyCO2", "SCD4X", "d506000867355367925c0b040609"},
-    {"Sensirion MyCO2", "SCD4X", "d506000ac543016b88619a05000000009a05000000000000"},
-    {"H5174", "GVH5174_1234", "01000101035e1364"},
-    {"H5174", "GVH5174_1234", "01000101811a6764"},
-    {"H5074", "Govee_H5074_1234", "88ec00c408231d6402"},
-    {"H5074", "Govee_H5074_1234", "88ec00a0facc176402"},
-    {"H5074", "Govee_H5074_1234", "88ec001b0a9b196402"},
-    {"Mopeka", "Standard", "5900035d41a4c150a8cc0323"},
-    {"Mopeka", "Standard", "5900035b41a4c650a8cc801b"},
-    {"H5055", "GVH5055", "59045b006401201c00ffffffff20ffffffffffff0000"},
-    {"H5055", "GVH5055", "59045b00640220ffffffffffff201f00ffffffff0000"},
-    {"H5055", "GVH5055", "59045b00646020ffffffffffff201e00ffffffff0000"},
-    {"H5055", "GVH5055", "59045b0064a020ffffffffffff202100ffffffff0000"},
-    {"H5106", "GVH5106_1234", "010001010ed2e431"},
-    {"H5106", "GVH5106_1234", "010001010deeaa6f"},
-    {"H5106", "GVH5106_1234", "010001010ddf25cc"},
-    {"H5106", "GVH5106_1234", "010001010069fcd3"},
-    {"H5106", "GVH5106_1234", "01000101848420c0"},
-    {"H5106", "GVH5106_1234", "0100010181aa77cf"},
-    {"H5106", "GVH5106_1234", "0100010185e12c39"},
-    {"Polar", "Polar H10 75087320", "6b003b164446"},
-    {"Polar", "Polar H10 75087320", "6b002f166b68"},
-    {"Atomax", "Skale I/II", "ef81d70400ff"},
-    {"Atomax", "Skale I/II", "ef81280100ff"},
-    {"Atomax", "Skale I/II", "ef8160fcffff"},
-    {"Apple", "Continuity", "4c0009060304c0a87b1e130c1adefc915b9ef8010401030c"},
-    {"Apple", "Continuity", "4c00130100"},
-    {"Apple", "Continuity", "4c001219003d9967e0d67bf55617939043e48fd6762144da3e35160300"},
-    {"Apple", "Continuity", "4c000719010e2022f58f00000a7d9fff27234873d4305e0fed1b39e2b8"},
-    {"Apple", "Continuity", "4c000c0e00a7582cd64fff2fe83046c99f5b10065a19e96670d8"},
-    {"Tracker iTAG", "iTAG", "8afc23eb"},
-    {"Tile name", "Tile", "xxxx"},
-    {"H5106 extended", "GVH5106_1234", "010001010d915f9a4c000215494e54454c4c495f524f434b535f48575075f2ff0c"},
-    {"H5075 extended", "GVH5075_1234", "88ec000384e45c004c000215494e54454c4c495f524f434b535f48575075f2ffc2"},
-    {"ABTemp without service data", "ABTemp", "4c000215b5b182c7eab14988aa99b5c1517008d90001641ac5"},
-    {"Mopeka", "Standard", "5900065d3b00001b4443109b"},
-    {"Mopeka", "Standard", "59000c60410000a73e762c80"},
-    {"Mopeka", "Standard", "59000c603de1c8f2eb44ee1f"},
-    {"BM2", "ZX-1689", "4c000215655f83caae16a10a702e31f30d58dd82f441423157"},
-    {"BM2", "Li Battery Monitor", "4c000215655f83caae16a10a702e31f30d58dd82f441423149"},
-    {"H5104", "GVH5104_1234", "0100010103f99e64"},
-    {"H5179", "Govee_H5179_1234", "0188ec000101ee07581641"},
-    {"Braun", "Oral-B", "dc0004710502360000000f0004"},
-    {"Braun", "Oral-B", "dc000471050332010301030a04"},
-    {"Braun", "Oral-B", "dc00047105013a000002010004"},
-    {"Braun", "Oral-B", "dc000471050432010e03032e04"},
-    {"Braun", "Oral-B", "dc000471057332010e05032e04"},
-    {"Braun", "Oral-B", "dc000471050332010e06032e04"},
-    {"Braun", "Oral-B", "dc000471050332010e07032e04"},
-    {"Braun", "Oral-B", "dc000471050332010e08032e04"},
-    {"Braun", "Oral-B", "dc000202060220000001010004"},
-    {"Braun", "Oral-B", "dc000202067320020f07080004"},
-    {"BM6", "Battery Monitor", "4c0002153ba29cd9a42c894856badaf2606ef777114d0000cd"},
-    {"BM6", "Battery Monitor", "4c0002153ba29cd9a42c894856badaf2606ef777114e0000cd"},
-    {"Apple", "Watch", "4c0010050b182068dd"},
-    {"Apple", "Watch", "4c0010050b982068dd"},
-    {"Aranet", "Aranet4", "0207210e0401000c0f016f030802681f1362012c018c00b9"},
-    {"Aranet", "Aranet4", "0207210e0401000c0f014c030e02601f1162012c01b10036"},
-    {"Apple", "iPhone", "4c0010061a1e16ec7f61"},
-    {"Apple", "iPhone", "4c0010065a1e02711c95"},
-    {"Apple", "iPhone", "4c0010065b1e02711c91"},
-    {"Apple", "iPad", "4c0010020304"},
-    {"Apple", "iPad", "4c0010020704"},
-    {"Apple", "iPad", "4c0010050b1c93fbf5"},
-    {"Theengs", "iBeacon Tracker", "4c000215546865656e67732d69426561636f6e31f644000064"},
-    {"Theengs", "iBeacon Tracker", "4c000215546865656e67732d69426561636f6e32f644000064"},
-    {"Mobvoi", "TicWatch GTH Pro", "0000aabbccddeeff"},
-    {"XOSS", "X2", "04ff0161063f"},
-    {"SwitchBot Meter ManData", "WoSensorTHP", "6909aabbccddeeff4a0109962f"},
-    {"SwitchBot Meter ManData", "WoSensorTHP", "6909aabbccddeeff4801009732"},
-    {"SwitchBot Meter ManData", "WoSensorTHP", "6909aabbccddeeff3e0908965b"},
-    {"Gigaset G-Tag", "", "80010215123480c390ffbbc5"},
-    {"H5105", "GVH5105_1234", "0100010103787664"},
-    {"Tracker iTAG sesardelaisla", "iTAG", "0501aabbccddeeff6602010300"},
-    {"Tracker iTAG sesardelaisla", "iTAG", "0501ffeeddccbbaa3fa2e2ee00"},
-    {"Tilt Hydrothermometer", "Tilt", "4c000215a495bb10c5b14b44b5121370f02d74de004403f8c5"},
-    {"Oras", "Smart Faucet", "3101006400323131313030373933350020202020"},
-    {"Oras", "Smart Faucet", "3101004800546865656e67734142430020202020"},
-    {"Otodata RC1010", "", "b1034f544f54454c45020010270000366e0f000000"},
-    {"Otodata RC1010", "", "b1034f544f54454c4502006b260000366e0f000000"},
-    {"Otodata RC1010", "", "b1034f544f3332383148845603132111010400022af20304"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_mfgdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::IBEACON,
-    TheengsDecoder::BLE_ID_NUM::IBEACON,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5072,
-    TheengsDecoder::BLE_ID_NUM::H5072,
-    TheengsDecoder::BLE_ID_NUM::H5072,
-    TheengsDecoder::BLE_ID_NUM::H5102,
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::IBSTHBP01B,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::INODEEM,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV1,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV1,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV1,
-    TheengsDecoder::BLE_ID_NUM::BM3IN1,
-    TheengsDecoder::BLE_ID_NUM::BM3IN1,
-    TheengsDecoder::BLE_ID_NUM::BM4IN1,
-    TheengsDecoder::BLE_ID_NUM::BM1IN1,
-    TheengsDecoder::BLE_ID_NUM::MS_CDP,
-    TheengsDecoder::BLE_ID_NUM::BM2,
-    TheengsDecoder::BLE_ID_NUM::BM2,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::SMARTDRY,
-    TheengsDecoder::BLE_ID_NUM::AMPHIRO,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::TPTH,
-    TheengsDecoder::BLE_ID_NUM::T301,
-    TheengsDecoder::BLE_ID_NUM::T301,
-    TheengsDecoder::BLE_ID_NUM::T301,
-    TheengsDecoder::BLE_ID_NUM::T201,
-    TheengsDecoder::BLE_ID_NUM::BWBSDOO,
-    TheengsDecoder::BLE_ID_NUM::BWBSDOO,
-    TheengsDecoder::BLE_ID_NUM::SHT4X,
-    TheengsDecoder::BLE_ID_NUM::SHT4X,
-    TheengsDecoder::BLE_ID_NUM::SHT4X,
-    TheengsDecoder::BLE_ID_NUM::SHT4X,
-    TheengsDecoder::BLE_ID_NUM::SCD4X,
-    TheengsDecoder::BLE_ID_NUM::SCD4X,
-    TheengsDecoder::BLE_ID_NUM::SCD4X,
-    TheengsDecoder::BLE_ID_NUM::H5102,
-    TheengsDecoder::BLE_ID_NUM::H5102,
-    TheengsDecoder::BLE_ID_NUM::H5074,
-    TheengsDecoder::BLE_ID_NUM::H5074,
-    TheengsDecoder::BLE_ID_NUM::H5074,
-    TheengsDecoder::BLE_ID_NUM::MOPEKA,
-    TheengsDecoder::BLE_ID_NUM::MOPEKA,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5055,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::PH10,
-    TheengsDecoder::BLE_ID_NUM::PH10,
-    TheengsDecoder::BLE_ID_NUM::SKALE,
-    TheengsDecoder::BLE_ID_NUM::SKALE,
-    TheengsDecoder::BLE_ID_NUM::SKALE,
-    TheengsDecoder::BLE_ID_NUM::APPLE_CONT,
-    TheengsDecoder::BLE_ID_NUM::APPLE_CONT,
-    TheengsDecoder::BLE_ID_NUM::APPLE_CONTAT,
-    TheengsDecoder::BLE_ID_NUM::APPLE_CONTAT,
-    TheengsDecoder::BLE_ID_NUM::APPLE_CONTAT,
-    TheengsDecoder::BLE_ID_NUM::ITAG,
-    TheengsDecoder::BLE_ID_NUM::TILEN,
-    TheengsDecoder::BLE_ID_NUM::H5106,
-    TheengsDecoder::BLE_ID_NUM::H5072,
-    TheengsDecoder::BLE_ID_NUM::ABTEMP,
-    TheengsDecoder::BLE_ID_NUM::MOPEKA,
-    TheengsDecoder::BLE_ID_NUM::MOPEKA,
-    TheengsDecoder::BLE_ID_NUM::MOPEKA,
-    TheengsDecoder::BLE_ID_NUM::BM2,
-    TheengsDecoder::BLE_ID_NUM::BM2,
-    TheengsDecoder::BLE_ID_NUM::H5102,
-    TheengsDecoder::BLE_ID_NUM::H5179,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::ORALB_BT,
-    TheengsDecoder::BLE_ID_NUM::BM6,
-    TheengsDecoder::BLE_ID_NUM::BM6,
-    TheengsDecoder::BLE_ID_NUM::APPLEWATCH,
-    TheengsDecoder::BLE_ID_NUM::APPLEWATCH,
-    TheengsDecoder::BLE_ID_NUM::ARANET4,
-    TheengsDecoder::BLE_ID_NUM::ARANET4,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::APPLEDEVICE,
-    TheengsDecoder::BLE_ID_NUM::TheengsIB01,
-    TheengsDecoder::BLE_ID_NUM::TheengsIB02,
-    TheengsDecoder::BLE_ID_NUM::TICWATCHGTH,
-    TheengsDecoder::BLE_ID_NUM::XOSSX2,
-    TheengsDecoder::BLE_ID_NUM::SBMT_M,
-    TheengsDecoder::BLE_ID_NUM::SBMT_M,
-    TheengsDecoder::BLE_ID_NUM::SBMT_M,
-    TheengsDecoder::BLE_ID_NUM::GTAG,
-    TheengsDecoder::BLE_ID_NUM::H5102,
-    TheengsDecoder::BLE_ID_NUM::ITAG,
-    TheengsDecoder::BLE_ID_NUM::ITAG,
-    TheengsDecoder::BLE_ID_NUM::TILT,
-    TheengsDecoder::BLE_ID_NUM::ORAS,
-    TheengsDecoder::BLE_ID_NUM::ORAS,
-    TheengsDecoder::BLE_ID_NUM::OTOD,
-    TheengsDecoder::BLE_ID_NUM::OTOD,
-    TheengsDecoder::BLE_ID_NUM::OTOD,
-};
-
-// uuid test input [test name] [device name] [uuid] [manufacturer data] [service data]
-const char* test_name_uuid_mfgsvcdata[][5] = {
-    {"RDL52832", "RDL52832", "0x0318", "4c000215fda50693a4e24fb1afcfc6eb07647825270f270fd8", "183a2f33010000020000000100000907"},
-    {"RDL52832", "RDL52832", "0x0318", "4c000215fda50693a4e24fb1afcfc6eb0764782500010002d8", "194c3a39000001040000000901000908"},
-    {"RDL52832", "RDL52832", "0x0318", "4c000215fda50693a4e24fb1afcfc6eb0764782500010002d8", "1a463d34000002000100090600000105"},
-    {"RDL52832", "RDL52832", "0x1803", "4c000215fda50693a4e24fb1afcfc6eb0764782500010002d8", "183a2f33010000020000000100000907"},
-    {"RDL52832", "RDL52832", "0x1803", "4c000215fda50693a4e24fb1afcfc6eb0764782500010002d8", "194c3a39000001040000000901000908"},
-    {"RDL52832", "RDL52832", "0x1803", "4c000215fda50693a4e24fb1afcfc6eb0764782500010002d8", "1a463d34000002000100090600000105"},
-    {"SwitchBot Outdoor Meter", "Outdoor Meter", "0xfd3d", "6909aabbccddeeff8b0305993200", "770064"},
-    {"SwitchBot Outdoor Meter", "Outdoor Meter", "0xfd3d", "6909aabbccddeeff940b039a5000", "770064"},
-    {"SwitchBot Outdoor Meter", "Outdoor Meter", "0xfd3d", "6909aabbccddeeffe30f090f2a00", "770041"},
-    {"SE TEMP volt","P T EN 888444","0x2a6e","5707f2120c","8308"},
-    {"SE RHT volt","P RHT 88888B","0x2a6f","5707f2190c","2f"},
-    {"SE TEMP PROBE","P TPROBE 000000","0x2a6e","5707f2e40b","0c08"},
-    {"SE MAG","P MAG CCCCCC","0x2a06","5707f2070c","3b00"},
-    {"SE TEMP wrong svc data","P T EN 888888","0x2a6e","5707f2020c","ff7f"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeff0d275514", "78003c"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffd5256414", "780048"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffd8253214", "780036"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffcf270014", "780036"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffe0254d14", "780036"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffd3274914", "780036"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffd3272814", "780060"},
-    {"Switchbot_BlindTilt", "WoBlindTilt", "0xfd3d", "6909aabbccddeeffd3273c14", "780060"},
-    {"Switchbot_BlindTilt NEW", "WoBlindTilt", "0xfd3d", "6909aabbccddeeff4427504184", "780064"},
-    {"Switchbot_BlindTilt NEW", "WoBlindTilt", "0xfd3d", "6909aabbccddeeff2427412184", "780064"},
-    {"Switchbot_BlindTilt NEW", "WoBlindTilt", "0xfd3d", "6909aabbccddeeff39274b4184", "780064"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_name_uuid_mfgsvcdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::RDL52832,
-    TheengsDecoder::BLE_ID_NUM::SBOT,
-    TheengsDecoder::BLE_ID_NUM::SBOT,
-    TheengsDecoder::BLE_ID_NUM::SBOT,
-    TheengsDecoder::BLE_ID_NUM::SE_TEMP,
-    TheengsDecoder::BLE_ID_NUM::SE_RHT,
-    TheengsDecoder::BLE_ID_NUM::SE_TPROBE,
-    TheengsDecoder::BLE_ID_NUM::SE_MAG,
-    TheengsDecoder::BLE_ID_NUM::SE_TEMP,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-    TheengsDecoder::BLE_ID_NUM::SBBT,
-};
-
-// uuid test input [test name] [mac] [device name] [uuid] [manufacturer data] [service data]
-const char* test_name_mac_uuid_mfgsvcdata[][6] = {
-    {"SBBT-002C", "BC:02:6E:AA:BB:CC", "SBBT-002C", "0xfcd2", "a90b0109000b01000accbbaa6e02bc", "40001d01643a01"},
-    {"SBBT-002C encrypted", "BC:02:6E:AA:BB:CC", "SBBT-002C", "0xfcd2", "a90b0109000b01000accbbaa6e02bc", "4562511158bd25b8f093645b573115"},
-    {"SBDW-002C", "3C:2E:F5:AA:BB:CC", "SBDW-002C", "0xfcd2", "a90b0101000b02000accbbaaf52e3c", "44005d016405fc21002d013f9601"},
-    {"SBDW-002C", "3C:2E:F5:AA:BB:CC", "SBDW-002C", "0xfcd2", "a90b0101000b02000accbbaaf52e3c", "440056016405e406012d003f0000"},
-    {"SBDW-002C encrypted", "3C:2E:F5:AA:BB:CC", "SBDW-002C", "0xfcd2", "a90b0101000b02000accbbaaf52e3c", "4538efaf00d122b4979064e971a7ed16c1644dc481fd"},
-    {"SBMO-003Z", "60:EF:AB:AA:BB:CC", "SBMO-003Z", "0xfcd2", "a90b0101000b05000accbbaaabef60", "4400020164059033002101"},
-    {"SBMO-003Z", "60:EF:AB:AA:BB:CC", "SBMO-003Z", "0xfcd2", "a90b0101000b05000accbbaaabef60", "440005016405100e002100"},
-    {"SBMO-003Z encrypted", "60:EF:AB:AA:BB:CC", "SBMO-003Z", "0xfcd2", "a90b0101000b05000accbbaaabef60", "45cc08edf25d61cc0f42b60011223318cd3624"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_name_mac_uuid_mfgsvcdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C_ENCR,
-    TheengsDecoder::BLE_ID_NUM::SBDW_002C,
-    TheengsDecoder::BLE_ID_NUM::SBDW_002C,
-    TheengsDecoder::BLE_ID_NUM::SBDW_002C_ENCR,
-    TheengsDecoder::BLE_ID_NUM::SBMO_003Z,
-    TheengsDecoder::BLE_ID_NUM::SBMO_003Z,
-    TheengsDecoder::BLE_ID_NUM::SBMO_003Z_ENCR,
-};
-
-// uuid name test input [test name] [uuid] [device name] [service data]
-const char* test_uuid_name_svcdata[][4] = {
-    {"Qingping round sensor ATC441", "0x181a", "CGG_1233DC", "582d341233dc00e03e490b2c2e"},
-    {"Qingping round sensor ATC441", "0x181a", "CGG_1233DC", "582d341233dc00e13e4a0b353b"},
-    {"Qingping round sensor PVVX", "0x181a", "CGG_1233DC", "dc3312342d582f09aa173d0b4b7c05"},
-    {"Qingping round sensor PVVX", "0x181a", "CGG_1233DC", "dc3312342d582909c017350b4a8c05"},
-    {"Qingping round sensor PVVX", "0x181a", "CGG_1233DC", "5a582d34126a38081513da0b5c0304"},
-    {"Qingping round sensor Mi v4", "0xfe95", "Qingping Temp & RH", "5058480b5ddc3312342d580d1004ed005b02"},
-    {"Qingping round sensor Mi v4", "0xfe95", "Qingping Temp & RH", "5058480b70dc3312342d580a100148"},
-    {"ClearGrass round sensor Mi v4", "0xfe95", "ClearGrass Temp & RH", "5030470383ffeeddccbbaa0d100410017e02"},
-    {"ClearGrass round sensor Mi v4", "0xfe95", "ClearGrass Temp & RH", "50304703c7ffeeddccbbaa0d1004f100ee01"},
-    {"ClearGrass round sensor Mi v4", "0xfe95", "ClearGrass Temp & RH", "5030470341ffeeddccbbaa0410021201"},
-    {"ClearGrass round sensor Mi v4", "0xfe95", "ClearGrass Temp & RH", "503047036affeeddccbbaa061002ee01"},
-    {"ClearGrass round sensor Mi v4", "0xfe95", "ClearGrass Temp & RH", "5030470348ffeeddccbbaa0a10010b"},
-    {"Qingping TH Lite sensor PVVX", "0x181a", "CGDK2_1233DC", "ffe51e12342df8080611920b649905"},
-    {"Qingping TH Lite sensor ATC1441", "0x181a", "CGDK2_1233DC", "2d34121ee5ff00e62b640b71c0"},
-    {"LYWSD03MMC_ATC", "0x181a", "ATC_800021", "a4c138d5d49801453e510b7b62"},
-    {"LYWSD03MMC_ATC", "0x181a", "ATC_800021", "a4c138d5d498ffd33e510b7b62"},
-    {"LYWSD03MMC_PVVX", "0x181a", "ATC_800021", "5601cf38c1a44008bd13470c64cc0f"},
-    {"LYWSD03MMC_PVVX", "0x181a", "MHO_SAL", "628f5238c1a48307e4128f0b64b40f"},
-    {"LYWSD03MMC_PVVX", "0x181a", "MHO_SAL", "5601cf38c1a462fdbd13470c64cc0f"},
-    {"MJWSD05MMC_PVVX", "0x181a", "BTH_F6C51E", "2fdedf38c1a47c090d11350c644b05"},
-    {"SBBT-002C press", "0xfcd2", "SBBT-002C", "40001d01643a01"},
-    {"SBBT-002C double press", "0xfcd2", "SBBT-002C", "40001e01643a02"},
-    {"SBBT-002C triple press", "0xfcd2", "SBBT-002C", "40001f01643a03"},
-    {"SBBT-002C long press", "0xfcd2", "SBBT-002C", "40002001643a04"},
-    {"SBBT-002C press", "0xfcd2", "SBBT-002C", "4400ab01643a01"},
-    {"SBBT-002C encrypted", "0xfcd2", "SBBT-002C", "4562511158bd25b8f093645b573115"},
-    {"LYWSD03MMC_PVVX_ENCR", "0x181a", "ATC_9C58AB", "23ef56583dd42050fe8e4d"},
-    {"LYWSD03MMC_PVVX_DECR", "0x181a", "ATC_89DF88", "9c0902116404"},
-    {"ABN07", "0xfcd2", "asensor_7F7F", "4000100164029309038612"},
-    {"Nutale", "0x0900", "nutale", "aabbccddeeff160100010100"},
-    {"SE TEMP", "0x2a6e", "C T 999999", "1301"}, 
-    {"SE TEMP negative","0x2a6e","C T 88888E","6afc"}, 
-    {"SE RHT hum","0x2a6f","P RHT 99999A","46"},
-    {"SE RHT temp neg","0x2a6e","P RHT 33399T","34f8"},
-    {"SE TEMP temp positive","0x2a6e","P T EN 888444","7008"},
-    {"SE RHT temp pos","0x2a6e","P RHT 99999Z","0a02"},
-    {"SE TEMP PROBE temp","0x2a6e","P TPROBE 111999","1608"},
-    {"SE MAG Open","0x2a06","P MAG CCCCCC","2400"},
-    {"SE MAG Closed","0x2a06","P MAG CCCCCC","2900"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_uuid_name_svcdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::CGG1_ATC1441,
-    TheengsDecoder::BLE_ID_NUM::CGG1_ATC1441,
-    TheengsDecoder::BLE_ID_NUM::CGG1_PVVX,
-    TheengsDecoder::BLE_ID_NUM::CGG1_PVVX,
-    TheengsDecoder::BLE_ID_NUM::CGG1_PVVX,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK_2,
-    TheengsDecoder::BLE_ID_NUM::CGDK2_PVVX,
-    TheengsDecoder::BLE_ID_NUM::CGDK2_ATC1441,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_ATC,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_ATC,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C,
-    TheengsDecoder::BLE_ID_NUM::SBBT_002C_ENCR,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX_ENCR,
-    TheengsDecoder::BLE_ID_NUM::LYWSD03MMC_PVVX_DECR,
-    TheengsDecoder::BLE_ID_NUM::ABN07,
-    TheengsDecoder::BLE_ID_NUM::NUTALE,
-    TheengsDecoder::BLE_ID_NUM::SE_TEMP,
-    TheengsDecoder::BLE_ID_NUM::SE_TEMP,
-    TheengsDecoder::BLE_ID_NUM::SE_RHT,
-    TheengsDecoder::BLE_ID_NUM::SE_RHT,
-    TheengsDecoder::BLE_ID_NUM::SE_TEMP,
-    TheengsDecoder::BLE_ID_NUM::SE_RHT,
-    TheengsDecoder::BLE_ID_NUM::SE_TPROBE,
-    TheengsDecoder::BLE_ID_NUM::SE_MAG,
-    TheengsDecoder::BLE_ID_NUM::SE_MAG,
-};
-
-// uuid test input [test name] [uuid] [data source] [data]
-const char* test_uuid[][4] = {
-    {"Mi Smart Scale", "0x181d", "servicedata", "223e30e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "627607e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "a23e30e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "e27607e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "237233e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "637607e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "a37233e607020e10293a"},
-    {"Mi Smart Scale", "0x181d", "servicedata", "e37607e607020e10293a"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0226e607020e10293af7019a38"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0224e607020e10293a00009a38"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0624e607020e10293a0000fc03"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0326e607020e10293af701f136"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0324e607020e10293a0000f136"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "0724e607020e10293a0000ce04"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "02a6e607020e10293af7019a38"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "02a4e607020e10293a00009a38"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "06a4e607020e10293a0000fc03"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "03a6e607020e10293af701f136"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "03a4e607020e10293a0000f136"},
-    {"Mi_Body_Scale_2", "0x181b", "servicedata", "07a4e607020e10293a0000ce04"},
-    {"Mokobeacon", "0xff01", "servicedata", "64000000005085a000f0ffe003"},
-    {"MokoXPro", "feab", "servicedata", "70000a011201ee0caf03def14635998a"},
-    {"MokoXPro", "feab", "servicedata", "60000a010007154039c0fa000bf901f40c93fe3487"},
-    {"MokoXPro", "feab", "servicedata", "60000a0100070100ff403ec00bf901f40c93fe3487"},
-    {"GAEN", "fd6f", "servicedata", "e7c6d34c71e48baf278bd99be74685bca78126ab"},
-    {"Switchbot_S1", "0d00", "servicedata", "48d0db"},
-    {"Switchbot_S1", "0d00", "servicedata", "4890cc"},
-    {"Switchbot_S1", "0d00", "servicedata", "48005b"},
-    {"Switchbot_Meter_Plus", "fd3d", "servicedata", "6900ba18993b"},
-    {"Switchbot_Meter_Plus", "fd3d", "servicedata", "6900ba031938"},
-    {"Switchbot_Meter_Plus", "fd3d", "servicedata", "6900ba379ab8"},
-    {"Switchbot_Meter", "0d00", "servicedata", "540054459938"},
-    {"Switchbot_Meter", "0d00", "servicedata", "5400d40299b8"},
-    {"bParasite", "181a", "servicedata", "10c30c1c6400e6667fffaabbccddeeff"},
-    {"bParasite", "181a", "servicedata", "11c30b8658aca6666b85aabbccddeeff30d4"},
-    {"bParasite", "181a", "servicedata", "20c30c1c0a00e6667fffaabbccddeeff"},
-    {"bParasite", "181a", "servicedata", "21c30b8608dea6666b85aabbccddeeff30d4"},
-    {"Switchbot_Curtain", "0d00", "servicedata", "63c04c1970"},
-    {"Switchbot_Curtain", "0d00", "servicedata", "63805599a0"},
-    {"ClearGrass clock", "fe95", "servicedata", "70205b0475ffeeddccbbaa090410020001"},
-    {"ClearGrass clock", "fe95", "servicedata", "70205b04dcffeeddccbbaa09061002b202"},
-    {"ClearGrass clock", "fe95", "servicedata", "70205b0475ffeeddccbbaa090410020901"},
-    {"ClearGrass clock", "fe95", "servicedata", "70205b0485ffeeddccbbaa090a100108"},
-    {"Mi flora", "fe95", "servicedata", "712098004a63b6658d7cc40d071003f32600"},
-    {"Mi flora", "fe95", "servicedata", "712098005763b6658d7cc40d0810011e"},
-    {"Mi flora", "fe95", "servicedata", "712098000163b6658d7cc40d0410024001"},
-    {"Mi flora", "fe95", "servicedata", "7120980008ffeeddccbbaa0d0910020000"},
-    {"VegTrug flora", "fe95", "servicedata", "7120bc030163b6658d7cc40d0410024001"},
-    {"Switchbot_MotionSensor", "0x0d00", "servicedata", "73b037000045"},
-    {"Switchbot_MotionSensor", "0xfd3d", "servicedata", "73b037000045"},
-    {"Switchbot_MotionSensor", "0xfd3d", "servicedata", "7340d50000f2"},
-    {"Switchbot_Contact", "0x0d00", "servicedata", "64c05c010000000000"},
-    {"Switchbot_Contact", "0x0d00", "servicedata", "6480d7020000000000"},
-    {"Switchbot_Contact", "0x0d00", "servicedata", "6440c1050000000000"},
-    {"Switchbot_Contact", "0xfd3d", "servicedata", "6440c1050000000000"},
-    {"Qingping Air Monitor Lite", "0xfdcd", "servicedata", "080eaabbccddeeff010422014c011204710072001302ed03"},
-    {"Qingping Air Monitor Lite", "0xfdcd", "servicedata", "880eaabbccddeeff0104f900b50112047d0186011302fd02"},
-    {"Qingping Air Monitor Lite", "0xfdcd", "servicedata", "880eaabbccddeeff0104f600ab011204a400d7001302c702"},
-    {"Qingping Air Monitor Lite", "0xfdcd", "servicedata", "8824aabbccddeeff0104ce0028021204050005001302d701"},
-    {"Service data", "0x180f", "servicedata", "21"},
-    {"ClearGrass alarm clock", "0xfdcd", "servicedata", "080caffd50342d5801040a017f0202012a"},
-    {"ClearGrass alarm clock", "0xfdcd", "servicedata", "080caffd50342d5801040d019e020201aa"},
-    {"ClearGrass alarm clock", "0xfdcd", "servicedata", "080caffd50342d5801040e019102020155"},
-    {"ClearGrass Weather Station", "0xfdcd", "servicedata", "0809ffeeddccbbaa01040801870207024f2702015c"},
-    {"ClearGrass Weather Station", "0xfdcd", "servicedata", "08094c0140342d5801040f01880207024f2702015c"},
-    {"ClearGrass Weather Station", "0xfdcd", "servicedata", "08094c0140342d580104fc004a0207026627020120"},
-    {"Qingping TH lite", "0xfdcd", "servicedata", "8810ffeeddccbbaa0104e8008f0302010b"},
-    {"Qingping TH lite", "0xfdcd", "servicedata", "8810799111342d580104e9001d0202010b"},
-    {"Qingping TH lite", "0xfdcd", "servicedata", "0810799111342d580104e9001d0202010b"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "0812ffeeddccbbaa0201530f0118090400000000"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "8812ffeeddccbbaa0201640f01c4090405020000"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "4812ffeeddccbbaa0804010300000f0150"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "4812ffeeddccbbaa0804000300000f0150"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "c812ffeeddccbbaa1101010f015f"},
-    {"Qingping Motion & Light", "0xfdcd", "servicedata", "4812ffeeddccbbaa1101000f0189"},
-    {"Qingping Door Open", "0xfdcd", "servicedata", "0804ffeeddccbbaa0201600f012b0f0100"},
-    {"Qingping Door Close", "0xfdcd", "servicedata", "0804751060342d580201600f01420f0101"},
-    {"Qingping Door Open Action", "0xfdcd", "servicedata", "4804751060342d580401000f01cb"},
-    {"Qingping Door Close Action", "0xfdcd", "servicedata", "4804751060342d580401010f01d5"},
-    {"Qingping round sensor", "0xfdcd", "servicedata", "0807ffeeddccbbaa01041201720202010d"},
-    {"Qingping round sensor", "0xfdcd", "servicedata", "8816YYYYYYYYYYYY0104eb001b01020164"},
-    {"Qingping round sensor", "0xfdcd", "servicedata", "8816xxxxxxxxxxxx0104f4003b01020164"},
-    {"Qingping alarm clock", "0xfdcd", "servicedata", "081eaabbccddeeff0104d200fe01020164"},
-    {"Jaalee", "0xf525", "manufacturerdata", "4c000215ebefd08370a247c89837e7b5634df52567f857becb64"},
-    {"Jaalee", "0xf525", "manufacturerdata", "4c000215ebefd08370a247c89837e7b5634df5257420591acb64"},
-    {"Switchbot_Curtain 2", "0xfd3d", "servicedata", "63c011641104"},
-    {"BlueCharm BC08", "0xfeaa", "servicedata", "21010b0c1318000021fffdfc12"},
-    {"BlueCharm BC08", "0xfeaa", "servicedata", "21010b0c0df540ff95fe69fc80"},
-    {"Switchbot_Contact", "0xfd3d", "servicedata", "640064440359ffff42"},
-    {"Switchbot_MotionSensor", "0xfd3d", "servicedata", "73006402f002"},
-    {"Tile uuid", "0xfeed", "servicedata", "0200c58aaccd312f479e"},
-    {"Tile uuid", "0xfeec", "servicedata", "0200c58aaccd312f479e"},
-    {"Tile uuid", "0xfd84", "servicedata", "0200c58aaccd312f479e"},
-    {"Mi flora pink tuya", "0xfd50", "servicedata", "0e006e0134a428005b"},
-    {"Mi flora pink tuya", "0xfd50", "servicedata", "620000000047640000"},
-    {"Mi flora pink tuya", "0xfd50", "servicedata", "6000d2000224640000"},
-    {"BlueCharm BC04P", "0xfeaa", "servicedata", "21010b0c5a1680001f001ffca5"},
-    {"BlueCharm BC021", "0xfeaa", "servicedata", "21010b0bd61ec00022fff203d1"},
-    {"BlueCharm BC021", "0xfeaa", "servicedata", "21010b0c7af140006dffe10416"},
-    {"BlueCharm BC021", "0xfeaa", "servicedata", "21010b0c7a0040006dffe10416"},
-    {"BlueCharm BC021", "0xfeaa", "servicedata", "21010b0c7affc0006dffe10416"},
-    {"KKM K6P", "0xfeaa", "servicedata", "2101070e5b154f2169"},
-    {"KKM K6P", "0xfeaa", "servicedata", "2101070e5b16521f9b"},
-    {"KKM K6P", "0xfeaa", "servicedata", "2101070e5b16531f95"},
-    {"KKM K6P", "0xfeaa", "servicedata", "2101070e5b00401f95"},
-    {"KKM K6P", "0xfeaa", "servicedata", "2101070e5bffc01f95"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e5befbb42d1ffc200000407"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e33f1a94e01002e000f03f7"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e5bf2f42da1fe2cffd203a9"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e58186f2a29ffe1000003f7"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e58165125a5ffd2000003f7"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e07192a224ffffcffec03eb"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e58007325a5ffd2000003f7"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e07ff8e224ffffcffec03eb"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e58f4362bd8000ffff103f7"},
-    {"KKM K9", "0xfeaa", "servicedata", "21010f0e5bf51b4addffc200000416"},
-    {"Switchbot_S1", "0xfd3d", "servicedata", "48004700"},
-    {"ClearGrass Barometer Pro", "0xfdcd", "servicedata", "8818ffeeddccbbaa0104e800dc0102015e07025a27"},
-    {"Switchbot_Curtain 3", "0xfd3d", "servicedata", "7bc04f641204"},
-    {"Switchbot_Curtain 3", "0xfd3d", "servicedata", "7b804d001204"},
-    {"Switchbot_Curtain 3", "0xfd3d", "servicedata", "7b4057e41106"},
-    {"Switchbot_Curtain 3", "0xfd3d", "servicedata", "7bc04f391204"},
-    {"MiLamp", "0xfe95",  "servicedata", "4030dd031d0300010100"},
-    {"MiLamp", "0xfe95",  "servicedata", "4030dd030203000101"},
-    {"MiLamp", "0xfe95",  "servicedata", "3030dd0301ffeeddccbbaa0d"},
-    {"Jaalee", "0xf51c", "manufacturerdata", "4c000215ebefd08370a247c89837e7b5634df52565823d1acc64"},
-    {"NodOn NIU", "0x0000", "servicedata", "02599c37d90287a521520006635ab801"},
-    {"NodOn NIU", "0x0000", "servicedata", "02599c37d90287a52152000663ee4b02"},
-    {"NodOn NIU", "0x0000", "servicedata", "02599c37d90287a52152000660259003"},
-    {"NodOn NIU", "0x0000", "servicedata", "02599c37d90287a521520006622b8104"},
-    {"NodOn NIU", "0x0000", "servicedata", "02599c37d90287a521520004595eb905"},
-    {"Feasycom BP108", "0xfff0", "servicedata", "27021992aabbccddeeff64"},
-    {"Feasycom BPXXX", "0xfff0", "servicedata", "29021992aabbccddeeff64"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_uuid_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC04HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMKG,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::XMTZC05HMLB,
-    TheengsDecoder::BLE_ID_NUM::MOKOBEACON,
-    TheengsDecoder::BLE_ID_NUM::MOKOBEACONXPRO,
-    TheengsDecoder::BLE_ID_NUM::MOKOBEACONXPRO,
-    TheengsDecoder::BLE_ID_NUM::MOKOBEACONXPRO,
-    TheengsDecoder::BLE_ID_NUM::GAEN,
-    TheengsDecoder::BLE_ID_NUM::SBS1,
-    TheengsDecoder::BLE_ID_NUM::SBS1,
-    TheengsDecoder::BLE_ID_NUM::SBS1,
-    TheengsDecoder::BLE_ID_NUM::SBMT,
-    TheengsDecoder::BLE_ID_NUM::SBMT,
-    TheengsDecoder::BLE_ID_NUM::SBMT,
-    TheengsDecoder::BLE_ID_NUM::SBMT,
-    TheengsDecoder::BLE_ID_NUM::SBMT,
-    TheengsDecoder::BLE_ID_NUM::BPARASITE,
-    TheengsDecoder::BLE_ID_NUM::BPARASITE,
-    TheengsDecoder::BLE_ID_NUM::BPARASITE,
-    TheengsDecoder::BLE_ID_NUM::BPARASITE,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::LYWSD02,
-    TheengsDecoder::BLE_ID_NUM::LYWSD02,
-    TheengsDecoder::BLE_ID_NUM::LYWSD02,
-    TheengsDecoder::BLE_ID_NUM::LYWSD02,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY01HHCC,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY01HHCC,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY01HHCC,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY01HHCC,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY01HHCC,
-    TheengsDecoder::BLE_ID_NUM::SBMS,
-    TheengsDecoder::BLE_ID_NUM::SBMS,
-    TheengsDecoder::BLE_ID_NUM::SBMS,
-    TheengsDecoder::BLE_ID_NUM::SBCS,
-    TheengsDecoder::BLE_ID_NUM::SBCS,
-    TheengsDecoder::BLE_ID_NUM::SBCS,
-    TheengsDecoder::BLE_ID_NUM::SBCS,
-    TheengsDecoder::BLE_ID_NUM::CGDN1,
-    TheengsDecoder::BLE_ID_NUM::CGDN1,
-    TheengsDecoder::BLE_ID_NUM::CGDN1,
-    TheengsDecoder::BLE_ID_NUM::CGDN1,
-    TheengsDecoder::BLE_ID_NUM::SERVICE_DATA,
-    TheengsDecoder::BLE_ID_NUM::CGD1,
-    TheengsDecoder::BLE_ID_NUM::CGD1,
-    TheengsDecoder::BLE_ID_NUM::CGD1,
-    TheengsDecoder::BLE_ID_NUM::CGP1W,
-    TheengsDecoder::BLE_ID_NUM::CGP1W,
-    TheengsDecoder::BLE_ID_NUM::CGP1W,
-    TheengsDecoder::BLE_ID_NUM::CGDK2_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGDK2_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGDK2_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGPR1,
-    TheengsDecoder::BLE_ID_NUM::CGH1,
-    TheengsDecoder::BLE_ID_NUM::CGH1,
-    TheengsDecoder::BLE_ID_NUM::CGH1,
-    TheengsDecoder::BLE_ID_NUM::CGH1,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGG1_STOCK,
-    TheengsDecoder::BLE_ID_NUM::CGD1,
-    TheengsDecoder::BLE_ID_NUM::JAALEE,
-    TheengsDecoder::BLE_ID_NUM::JAALEE,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::SBCS,
-    TheengsDecoder::BLE_ID_NUM::SBMS,
-    TheengsDecoder::BLE_ID_NUM::TILE,
-    TheengsDecoder::BLE_ID_NUM::TILE,
-    TheengsDecoder::BLE_ID_NUM::TILE,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY10,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY10,
-    TheengsDecoder::BLE_ID_NUM::HHCCJCY10,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::BC08,
-    TheengsDecoder::BLE_ID_NUM::KKM_K6P,
-    TheengsDecoder::BLE_ID_NUM::KKM_K6P,
-    TheengsDecoder::BLE_ID_NUM::KKM_K6P,
-    TheengsDecoder::BLE_ID_NUM::KKM_K6P,
-    TheengsDecoder::BLE_ID_NUM::KKM_K6P,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::KKM_K9,
-    TheengsDecoder::BLE_ID_NUM::SBS1,
-    TheengsDecoder::BLE_ID_NUM::CGP23W,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::SBCU,
-    TheengsDecoder::BLE_ID_NUM::MUE4094RT,
-    TheengsDecoder::BLE_ID_NUM::MUE4094RT,
-    TheengsDecoder::BLE_ID_NUM::MUE4094RT,
-    TheengsDecoder::BLE_ID_NUM::JAALEE,
-    TheengsDecoder::BLE_ID_NUM::NODONNIU,
-    TheengsDecoder::BLE_ID_NUM::NODONNIU,
-    TheengsDecoder::BLE_ID_NUM::NODONNIU,
-    TheengsDecoder::BLE_ID_NUM::NODONNIU,
-    TheengsDecoder::BLE_ID_NUM::NODONNIU,
-    TheengsDecoder::BLE_ID_NUM::FEASY,
-    TheengsDecoder::BLE_ID_NUM::FEASY,
-};
-
-// MAC manufacturer data test input [test name] [mac] [data]
-const char* test_mac_mfgdata[][3] = {
-    {"IBT-2XS", "a1:b2:c3:d4:e5:f6", "00000000a1b2c3d4e5f6e600e600"},
-    {"IBT-2XS", "AA:BB:CC:DD:EE:FF", "00000000aabbccddeeff18014001"},
-    {"IBT-2XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeefff6ff8a02"},
-    {"IBT-2XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeeffdc00d200"},
-    {"IBT-2XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeefff6ff4402"},
-    {"IBT-2X", "aa:bb:cc:dd:ee:ff", "01000000ffeeddccbbaadc00cf00"},
-    {"IBT-2X", "aa:bb:cc:dd:ee:ff", "01000000ffeeddccbbaa4c014f01"},
-    {"IBT-2X", "aa:bb:cc:dd:ee:ff", "01000000ffeeddccbbaaffff4f01"},
-    {"IBT-4XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeeff04010401fa00fa00"},
-    {"IBT-4XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeeff0401f6ff58021202"},
-    {"IBT-6XS", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeeffd200c800f6ffd200f6fff6ff"},
-    {"SOLIS_6", "aa:bb:cc:dd:ee:ff", "00000000aabbccddeeffc800c800f6ffd200f6fff6ff"},
-    {"TPMS", "80:EA:CA:DD:EE:FF", "000180eacaddeefff46503007c0c00003300"},
-    {"TPMS", "82:EA:CA:DD:EE:FF", "000182eacaddeeff11fc0300aa0600005300"},
-    {"MiBand", "AA:BB:CC:DD:EE:FF", "57010202017dffffffffffffffffffffffffff02aabbccddeeff"},
-    {"RuuviTag", "CB:B8:33:4C:88:4F", "99040512fc5394c37c0004fffc040cac364200cdcbb8334c884f"},
-    {"RuuviTag maximum values", "CB:B8:33:4C:88:4F", "9904057ffffffefffe7fff7fff7fffffdefefffecbb8334c884f"},
-    {"RuuviTag minimum values", "CB:B8:33:4C:88:4F", "9904058001000000008001800180010000000000cbb8334c884f"},
-    {"WS02/WS08", "70:F7:00:00:11:1A", "100000001a110000f770580cf5016c0443090000"},
-    {"WS02/WS08", "DC:23:00:00:0A:AE", "11000000ae0a000023dcb80b92017c03cdbb0300"},
-    {"WS02/WS08", "63:D0:00:00:1D:CF", "1b002500cf1d0000d063a40cdc00bf0332270000"},
-    {"WS02/WS08", "8E:BB:00:00:07:10", "1500000010070000bb8e140b6c01dd02f0d47200"},
-    {"WS02/WS08", "8E:BB:00:00:07:10", "1500000010070000bb8eb401faa530002601c66f6700"},
-    {"WS02/WS08", "63:06:00:00:0D:FE", "10000000fe0d00000663db01779f010082011cd30000"},
-    {"WS02/WS08", "DC:23:00:00:0A:AE", "11000000ae0a000023dcb001af00000083019d520300"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_mac_mfgdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::IBT_2XS,
-    TheengsDecoder::BLE_ID_NUM::IBT_2XS,
-    TheengsDecoder::BLE_ID_NUM::IBT_2XS,
-    TheengsDecoder::BLE_ID_NUM::IBT_2XS,
-    TheengsDecoder::BLE_ID_NUM::IBT_2XS,
-    TheengsDecoder::BLE_ID_NUM::IBT_2X,
-    TheengsDecoder::BLE_ID_NUM::IBT_2X,
-    TheengsDecoder::BLE_ID_NUM::IBT_2X,
-    TheengsDecoder::BLE_ID_NUM::IBT4XS,
-    TheengsDecoder::BLE_ID_NUM::IBT4XS,
-    TheengsDecoder::BLE_ID_NUM::IBT6XS_SOLIS,
-    TheengsDecoder::BLE_ID_NUM::IBT6XS_SOLIS,
-    TheengsDecoder::BLE_ID_NUM::TPMS,
-    TheengsDecoder::BLE_ID_NUM::TPMS,
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV2,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV2,
-    TheengsDecoder::BLE_ID_NUM::RUUVITAG_RAWV2,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-    TheengsDecoder::BLE_ID_NUM::THERMOBEACON,
-};
-
-// MAC test input [test name] [mac] [manufacturer data] [service data]
-const char* test_mac_mfgsvcdata[][4] = {
-    {"MiBand", "AA:BB:CC:DD:EE:FF", "57010202017dffffffffffffffffffffffffff02aabbccddeeff", "8d230000"},
-    {"MiBand", "AA:BB:CC:DD:EE:FF", "570102020184ffffffffffffffffffffffffff02aabbccddeeff", ""},
-    {"MiBand", "AA:BB:CC:DD:EE:FF", "570102ffffffffffffffffffffffffffffffff02aabbccddeeff", "ac1e0000"},
-    {"MiBand", "AA:BB:CC:DD:EE:FF", "570102ffffffffffffffffffffffffffffffff02aabbccddeeff", ""},
-    {"Amazfit Bip S", "AA:BB:CC:DD:EE:FF", "570100dcdde701d61acdc010c59c77fad0bf8e02aabbccddeeff", "ac1e0000"},
-    {"ABTemp", "D5:FE:15:49:AC:7D", "4c000215b5b182c7eab14988aa99b5c1517008d90001641ac5", "7dac4915fed57dac530680"},
-};
-
-TheengsDecoder::BLE_ID_NUM test_mac_mfgsvcdata_id_num[]{
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::MIBAND,
-    TheengsDecoder::BLE_ID_NUM::ABTEMP,
-};
-
 template <typename T>
 static bool floatEqual(T f1, T f2) {
   return (fabs(f1 - f2) <= std::numeric_limits<T>::epsilon() * fmax(fabs(f1), fabs(f2)));
@@ -1264,7 +435,9 @@ bool checkResult(JsonObject result, JsonObject expected) {
   for (JsonPair kv : expected) {
     if (result[kv.key()] != kv.value()) {
       if (kv.value().is<double>() || kv.value().is<float>()) {
-        if (floatEqual(kv.value().as<float>(), result[kv.key()].as<float>())) {
+        double value = result[kv.key()].as<double>();
+        TheengsDecoder::readNumber(result[kv.key()], &value); // raw in fixed point
+        if (floatEqual(kv.value().as<float>(), static_cast<float>(value))) {
           continue;
         }
       }
@@ -1281,19 +454,39 @@ bool checkResult(JsonObject result, JsonObject expected) {
   return true;
 }
 
+static void shadowMismatch(const TheengsDecoder::ShadowMismatch& mismatch) {
+  std::cout << "Shadow mismatch on " << mismatch.advert << std::endl;
+  std::cout << "Engine " << static_cast<int>(mismatch.engine) << ": " << mismatch.decoded << std::endl;
+  std::cout << "Engine " << static_cast<int>(mismatch.shadow) << ": " << mismatch.shadow_decoded << std::endl;
+}
+
+// Whether the model is in the catalog, the vectors of the models a THEENGS_DEVICES build leaves out being skipped
+static bool compiledIn(TheengsDecoder& decoder, int model) {
+  TheengsDecoder::ModelInfo info;
+  return decoder.getModelInfo(model, info);
+}
+
 int main() {
   StaticJsonDocument<2048> doc;
   JsonObject bleObject;
   TheengsDecoder decoder;
+  DynamicJsonDocument devices(decoder.getDocMax());
   int decode_res = -1;
 
+  // the reference engine decodes every advert too, and must agree with the one checked
+  decoder.setEngine(TheengsDecoder::ENGINE_INDEXED);
+  decoder.setShadow(TheengsDecoder::ENGINE_REFERENCE, 1000, shadowMismatch);
+
   for (unsigned int i = 0; i < sizeof(test_servicedata) / sizeof(test_servicedata[0]); ++i) {
+    if (!compiledIn(decoder, test_svcdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_servicedata[i][0] << " : " << test_servicedata[i][1] << std::endl;
     doc["servicedata"] = test_servicedata[i][1];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_svcdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("servicedata");
@@ -1332,13 +525,16 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_mfgdata) / sizeof(test_mfgdata[0]); ++i) {
+    if (!compiledIn(decoder, test_mfgdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_mfgdata[i][0] << " : " << test_mfgdata[i][1] << " : " << test_mfgdata[i][2] << std::endl;
     doc["name"] = test_mfgdata[i][1];
     doc["manufacturerdata"] = test_mfgdata[i][2];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_mfgdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("name");
@@ -1380,6 +576,9 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_uuid_name_svcdata) / sizeof(test_uuid_name_svcdata[0]); ++i) {
+    if (!compiledIn(decoder, test_uuid_name_svcdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_uuid_name_svcdata[i][0] << " : " << test_uuid_name_svcdata[i][1] << std::endl;
     doc["servicedatauuid"] = test_uuid_name_svcdata[i][1];
@@ -1387,7 +586,7 @@ int main() {
     doc["servicedata"] = test_uuid_name_svcdata[i][3];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_uuid_name_svcdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("servicedatauuid");
@@ -1429,6 +628,9 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_mac_mfgsvcdata) / sizeof(test_mac_mfgsvcdata[0]); ++i) {
+    if (!compiledIn(decoder, test_mac_mfgsvcdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_mac_mfgsvcdata[i][0] << " : " << test_mac_mfgsvcdata[i][1] << test_mac_mfgsvcdata[i][2] << test_mac_mfgsvcdata[i][3] << std::endl;
     doc["id"] = test_mac_mfgsvcdata[i][1];
@@ -1436,7 +638,7 @@ int main() {
     doc["servicedata"] = test_mac_mfgsvcdata[i][3];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_mac_mfgsvcdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("id");
@@ -1478,6 +680,9 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_name_uuid_mfgsvcdata) / sizeof(test_name_uuid_mfgsvcdata[0]); ++i) {
+    if (!compiledIn(decoder, test_name_uuid_mfgsvcdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_name_uuid_mfgsvcdata[i][0] << " : " << test_name_uuid_mfgsvcdata[i][1] << std::endl;
     doc["name"] = test_name_uuid_mfgsvcdata[i][1];
@@ -1486,7 +691,7 @@ int main() {
     doc["servicedata"] = test_name_uuid_mfgsvcdata[i][4];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_name_uuid_mfgsvcdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("name");
@@ -1529,6 +734,9 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_name_mac_uuid_mfgsvcdata) / sizeof(test_name_mac_uuid_mfgsvcdata[0]); ++i) {
+    if (!compiledIn(decoder, test_name_mac_uuid_mfgsvcdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_name_mac_uuid_mfgsvcdata[i][0] << " : " << test_name_mac_uuid_mfgsvcdata[i][1] << std::endl;
     doc["id"] = test_name_mac_uuid_mfgsvcdata[i][1];
@@ -1538,7 +746,7 @@ int main() {
     doc["servicedata"] = test_name_mac_uuid_mfgsvcdata[i][5];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_name_mac_uuid_mfgsvcdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("name");
@@ -1582,13 +790,16 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_uuid) / sizeof(test_uuid[0]); ++i) {
+    if (!compiledIn(decoder, test_uuid_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_uuid[i][0] << " : " << test_uuid[i][1] << std::endl;
     doc[test_uuid[i][2]] = test_uuid[i][3];
     doc["servicedatauuid"] = test_uuid[i][1];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_uuid_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("servicedatauuid");
@@ -1629,13 +840,16 @@ int main() {
   }
 
   for (unsigned int i = 0; i < sizeof(test_mac_mfgdata) / sizeof(test_mac_mfgdata[0]); ++i) {
+    if (!compiledIn(decoder, test_mac_mfgdata_id_num[i])) {
+      continue;
+    }
     doc.clear();
     std::cout << "trying " << test_mac_mfgdata[i][0] << " : " << test_mac_mfgdata[i][1] << " : " << test_mac_mfgdata[i][2] << std::endl;
     doc["id"] = test_mac_mfgdata[i][1];
     doc["manufacturerdata"] = test_mac_mfgdata[i][2];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decodeObject(decoder, devices, bleObject);
     if (decode_res == test_mac_mfgdata_id_num[i]) {
       std::cout << "Found : " << decode_res << " ";
       bleObject.remove("id");
@@ -1676,6 +890,234 @@ int main() {
     }
   }
 
+  if (!compiledIn(decoder, test_uuid_id_num[0]) || !compiledIn(decoder, test_svcdata_id_num[0])) {
+    std::cout << "service data entries and trace skipped, their models are not compiled in" << std::endl;
+    return decoder.testDocMax() < 0 ? 1 : 0;
+  }
+
+  doc.clear();
+  std::cout << "trying service data entries" << std::endl;
+  JsonArray svc_entries = doc.createNestedArray("servicedata");
+  JsonObject uuid_entry = svc_entries.createNestedObject();
+  uuid_entry["servicedatauuid"] = test_uuid[0][1];
+  uuid_entry["servicedata"] = test_uuid[0][3];
+  JsonObject svcdata_entry = svc_entries.createNestedObject();
+  svcdata_entry["servicedata"] = test_servicedata[0][1];
+  bleObject = doc.as<JsonObject>();
+
+  decode_res = decodeObject(decoder, devices, bleObject);
+  if (decode_res != test_uuid_id_num[0]) {
+    std::cout << "FAILED! Error parsing service data entries, decode res: " << decode_res << std::endl;
+    serializeJson(doc, std::cout);
+    std::cout << std::endl;
+    return 1;
+  }
+
+  uuid_entry.remove("servicedatauuid");
+  uuid_entry.remove("servicedata");
+  svcdata_entry.remove("servicedata");
+  serializeJson(doc, std::cout);
+  std::cout << std::endl;
+
+  for (unsigned int i = 0; i < 2; ++i) {
+    StaticJsonDocument<2048> doc_exp;
+    JsonObject expected = doc_exp.to<JsonObject>();
+    deserializeJson(doc_exp, i == 0 ? expected_uuid[0] : expected_servicedata[0]);
+
+    if (!checkResult(svc_entries[i], expected)) {
+      return 1;
+    }
+  }
+
+  // the manufacturer data of a device decoding no service data stays at the top level
+  if (compiledIn(decoder, test_mfgdata_id_num[0])) {
+    std::cout << "trying manufacturer data with service data entries" << std::endl;
+    doc.clear();
+    doc["name"] = test_mfgdata[0][1];
+    doc["manufacturerdata"] = test_mfgdata[0][2];
+    svc_entries = doc.createNestedArray("servicedata");
+    uuid_entry = svc_entries.createNestedObject();
+    uuid_entry["servicedatauuid"] = test_uuid[0][1];
+    uuid_entry["servicedata"] = test_uuid[0][3];
+    svcdata_entry = svc_entries.createNestedObject();
+    svcdata_entry["servicedata"] = test_servicedata[0][1];
+    bleObject = doc.as<JsonObject>();
+
+    decode_res = decodeObject(decoder, devices, bleObject);
+    bleObject.remove("name");
+    bleObject.remove("manufacturerdata");
+    uuid_entry.remove("servicedatauuid");
+    uuid_entry.remove("servicedata");
+    svcdata_entry.remove("servicedata");
+    if (decode_res != test_mfgdata_id_num[0]) {
+      std::cout << "FAILED! Error parsing manufacturer data with entries, decode res: " << decode_res << std::endl;
+      return 1;
+    }
+    StaticJsonDocument<2048> doc_exp;
+    for (unsigned int i = 0; i < 2; ++i) {
+      deserializeJson(doc_exp, i == 0 ? expected_uuid[0] : expected_servicedata[0]);
+      if (!checkResult(svc_entries[i], doc_exp.as<JsonObject>())) {
+        return 1;
+      }
+    }
+    bleObject.remove("servicedata");
+    deserializeJson(doc_exp, expected_mfg[0]);
+    if (!checkResult(bleObject, doc_exp.as<JsonObject>())) {
+      return 1;
+    }
+  }
+
+  // a device recognised from its manufacturer data but decoding service data takes an entry
+  if (compiledIn(decoder, test_mac_mfgsvcdata_id_num[0])) {
+    std::cout << "trying manufacturer data taking a service data entry" << std::endl;
+    doc.clear();
+    doc["id"] = test_mac_mfgsvcdata[0][1];
+    doc["manufacturerdata"] = test_mac_mfgsvcdata[0][2];
+    svc_entries = doc.createNestedArray("servicedata");
+    svcdata_entry = svc_entries.createNestedObject();
+    svcdata_entry["servicedata"] = test_mac_mfgsvcdata[0][3];
+    uuid_entry = svc_entries.createNestedObject();
+    uuid_entry["servicedatauuid"] = test_uuid[0][1];
+    uuid_entry["servicedata"] = test_uuid[0][3];
+    bleObject = doc.as<JsonObject>();
+
+    decode_res = decodeObject(decoder, devices, bleObject);
+    svcdata_entry.remove("servicedata");
+    uuid_entry.remove("servicedatauuid");
+    uuid_entry.remove("servicedata");
+    if (decode_res != test_mac_mfgsvcdata_id_num[0] || bleObject.containsKey("brand")) {
+      std::cout << "FAILED! Error parsing manufacturer data taking an entry, decode res: " << decode_res << std::endl;
+      serializeJson(doc, std::cout);
+      std::cout << std::endl;
+      return 1;
+    }
+    for (unsigned int i = 0; i < 2; ++i) {
+      StaticJsonDocument<2048> doc_exp;
+      deserializeJson(doc_exp, i == 0 ? expected_mac_mfgsvcdata[0] : expected_uuid[0]);
+      if (!checkResult(svc_entries[i], doc_exp.as<JsonObject>())) {
+        return 1;
+      }
+    }
+  }
+
+  // entries beyond MAX_SVC_DATA_ENTRIES are left out and counted
+  std::cout << "trying too many service data entries" << std::endl;
+  for (int decoded = 0; decoded < 2; ++decoded) {
+    TheengsDecoder::Stats before, after;
+    TheengsDecoder::getStats(before);
+    doc.clear();
+    svc_entries = doc.createNestedArray("servicedata");
+    for (int i = 0; i <= MAX_SVC_DATA_ENTRIES; ++i) {
+      bool decodable = decoded ? i == 0 : i == MAX_SVC_DATA_ENTRIES;
+      svc_entries.createNestedObject()["servicedata"] = decodable ? test_servicedata[0][1] : "00";
+    }
+    bleObject = doc.as<JsonObject>();
+    decode_res = decodeObject(decoder, devices, bleObject);
+    TheengsDecoder::getStats(after);
+    uint64_t too_many = after.reject_reasons[TheengsDecoder::REJECT_TOO_MANY_ENTRIES] -
+                        before.reject_reasons[TheengsDecoder::REJECT_TOO_MANY_ENTRIES];
+    if (decode_res != (decoded ? test_svcdata_id_num[0] : -1) || too_many != (decoded ? 0u : 1u) ||
+        after.truncated - before.truncated != 1 || svc_entries[MAX_SVC_DATA_ENTRIES].containsKey("brand")) {
+      std::cout << "FAILED! " << MAX_SVC_DATA_ENTRIES + 1 << " entries decoded as " << decode_res << ", "
+                << too_many << " rejected as too many, " << after.truncated - before.truncated << " truncated"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "trying disabled models" << std::endl;
+  size_t catalog_count;
+  const char* svcdata_type = decoder.getCatalog(&catalog_count)[test_svcdata_id_num[0]].type;
+  for (int step = 0; step < 3; ++step) {
+    if (step == 0) {
+      decoder.setModelEnabled(test_svcdata_id_num[0], false);
+    } else if (step == 1) {
+      decoder.setEnabledModels(&test_uuid_id_num[0], 1);
+    } else if (!decoder.setTypeEnabled(svcdata_type, false) || decoder.setTypeEnabled("NONE", false)) {
+      std::cout << "FAILED! type " << svcdata_type << " not found" << std::endl;
+      return 1;
+    }
+    doc.clear();
+    doc["servicedata"] = test_servicedata[0][1];
+    bleObject = doc.as<JsonObject>();
+    decode_res = decodeObject(decoder, devices, bleObject);
+    decoder.setEnabledModels(TheengsDecoder::ModelMask().set());
+    if (decode_res == test_svcdata_id_num[0]) {
+      std::cout << "FAILED! disabled model decoded at step " << step << std::endl;
+      return 1;
+    }
+  }
+
+#ifndef DECODER_NO_HEAP // neither traced nor shadowed without a heap
+  std::cout << "trying decode trace" << std::endl;
+  TheengsDecoder::TraceRecord records[1024];
+  TheengsDecoder::readTrace(records, 1024);
+  decoder.setTrace(true);
+  doc.clear();
+  doc["servicedata"] = test_servicedata[0][1];
+  bleObject = doc.as<JsonObject>();
+  decodeObject(decoder, devices, bleObject);
+  decoder.setTrace(false);
+  decodeObject(decoder, devices, bleObject);
+  size_t traced = TheengsDecoder::readTrace(records, 1024);
+  if (traced < 3 || records[0].event != TheengsDecoder::TRACE_DECODE_START ||
+      records[traced - 1].event != TheengsDecoder::TRACE_DECODE_END ||
+      records[traced - 1].device != test_svcdata_id_num[0] || TheengsDecoder::readTrace(records, 1024) != 0) {
+    std::cout << "FAILED! trace of " << traced << " records" << std::endl;
+    return 1;
+  }
+
+  // the indexed engine only tries the models whose key the advertisement holds
+  std::cout << "trying candidate models" << std::endl;
+  const TheengsDecoder::MatchEngine engines[2] = {TheengsDecoder::ENGINE_REFERENCE, TheengsDecoder::ENGINE_INDEXED};
+  size_t tried[2] = {};
+  for (int e = 0; e < 2; ++e) {
+    decoder.setEngine(engines[e]);
+    doc.clear();
+    doc["servicedatauuid"] = "0xfa11";
+    doc["servicedata"] = "123456789abcdef0123456";
+    bleObject = doc.as<JsonObject>();
+    decoder.setTrace(true);
+    decode_res = decodeObject(decoder, devices, bleObject);
+    decoder.setTrace(false);
+    traced = TheengsDecoder::readTrace(records, 1024);
+    for (size_t r = 0; r < traced; ++r) {
+      tried[e] += records[r].event == TheengsDecoder::TRACE_DEVICE;
+    }
+  }
+  if (decode_res != -1 || tried[1] >= tried[0]) {
+    std::cout << "FAILED! the indexed engine tried " << tried[1] << " models, the reference one " << tried[0]
+              << std::endl;
+    return 1;
+  }
+  TheengsDecoder::releaseTrace();
+
+  TheengsDecoder::ShadowStats shadow;
+  decoder.getShadowStats(shadow);
+  if (shadow.compared == 0 || shadow.skipped != 0 || shadow.model_mismatches != 0 || shadow.json_mismatches != 0) {
+    std::cout << "FAILED! shadow engine: " << shadow.compared << " compared, " << shadow.skipped << " skipped, "
+              << shadow.model_mismatches << " model and " << shadow.json_mismatches << " JSON mismatches" << std::endl;
+    return 1;
+  }
+
+  std::cout << "trying shadow sampling" << std::endl;
+  decoder.setShadow(TheengsDecoder::ENGINE_REFERENCE, 1000, shadowMismatch, 0.25f);
+  decoder.getShadowStats(shadow, true);
+  for (int i = 0; i < 8; ++i) {
+    doc.clear();
+    doc["servicedata"] = test_servicedata[0][1];
+    bleObject = doc.as<JsonObject>();
+    decodeObject(decoder, devices, bleObject);
+  }
+  decoder.getShadowStats(shadow);
+  if (shadow.compared != 2 || shadow.unsampled != 6 || shadow.model_mismatches != 0 || shadow.json_mismatches != 0) {
+    std::cout << "FAILED! shadow sampling: " << shadow.compared << " compared, " << shadow.unsampled << " unsampled"
+              << std::endl;
+    return 1;
+  }
+  decoder.setShadow(TheengsDecoder::ENGINE_REFERENCE, 0);
+#endif
+
   if (decoder.testDocMax() < 0) {
     return 1;
   }
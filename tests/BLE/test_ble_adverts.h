@@ -0,0 +1,134 @@
+#ifndef _TEST_BLE_ADVERTS_H_
+#define _TEST_BLE_ADVERTS_H_
+
+// The inputs of test_ble as advertisements, for the harnesses replaying them.
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "test_ble_vectors.h"
+
+// An advertisement as the decoder receives it, the absent fields being nullptr
+struct Advert {
+  const char* test;
+  int expected; // model index, -1 if not decoded
+  const char* id;
+  const char* name;
+  const char* servicedatauuid;
+  const char* servicedata;
+  const char* manufacturerdata;
+  std::string json; // the same advertisement as JSON text
+};
+
+static inline std::string jsonString(const char* str) {
+  std::string out = "\"";
+  for (const char* c = str; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      out += '\\';
+    }
+    out += *c;
+  }
+  return out + "\"";
+}
+
+static inline Advert makeAdvert(const char* test, int expected, const char* id, const char* name,
+                                const char* uuid, const char* svc, const char* mfg) {
+  Advert advert = {test, expected, id, name, uuid, svc, mfg, ""};
+  const char* keys[] = {"id", "name", "servicedatauuid", "servicedata", "manufacturerdata"};
+  const char* values[] = {id, name, uuid, svc, mfg};
+  advert.json = "{";
+  for (int i = 0; i < 5; ++i) {
+    if (values[i] != nullptr) {
+      advert.json += (advert.json.size() > 1 ? "," : "") + jsonString(keys[i]) + ":" + jsonString(values[i]);
+    }
+  }
+  advert.json += "}";
+  return advert;
+}
+
+#define VECTOR_COUNT(vectors) (sizeof(vectors) / sizeof(vectors[0]))
+
+/*
+ * @brief Collects the inputs of test_ble, laid out like the test feeds them.
+ */
+static inline std::vector<Advert> testVectors() {
+  std::vector<Advert> adverts;
+  for (size_t i = 0; i < VECTOR_COUNT(test_servicedata); ++i) {
+    const char** v = test_servicedata[i];
+    adverts.push_back(makeAdvert(v[0], test_svcdata_id_num[i], nullptr, nullptr, nullptr, v[1], nullptr));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_mfgdata); ++i) {
+    const char** v = test_mfgdata[i];
+    adverts.push_back(makeAdvert(v[0], test_mfgdata_id_num[i], nullptr, v[1], nullptr, nullptr, v[2]));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_name_uuid_mfgsvcdata); ++i) {
+    const char** v = test_name_uuid_mfgsvcdata[i];
+    adverts.push_back(makeAdvert(v[0], test_name_uuid_mfgsvcdata_id_num[i], nullptr, v[1], v[2], v[4], v[3]));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_name_mac_uuid_mfgsvcdata); ++i) {
+    const char** v = test_name_mac_uuid_mfgsvcdata[i];
+    adverts.push_back(makeAdvert(v[0], test_name_mac_uuid_mfgsvcdata_id_num[i], v[1], v[2], v[3], v[5], v[4]));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_uuid_name_svcdata); ++i) {
+    const char** v = test_uuid_name_svcdata[i];
+    adverts.push_back(makeAdvert(v[0], test_uuid_name_svcdata_id_num[i], nullptr, v[2], v[1], v[3], nullptr));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_uuid); ++i) {
+    const char** v = test_uuid[i];
+    bool svc = strcmp(v[2], "servicedata") == 0;
+    adverts.push_back(makeAdvert(v[0], test_uuid_id_num[i], nullptr, nullptr, v[1], svc ? v[3] : nullptr, svc ? nullptr : v[3]));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_mac_mfgdata); ++i) {
+    const char** v = test_mac_mfgdata[i];
+    adverts.push_back(makeAdvert(v[0], test_mac_mfgdata_id_num[i], v[1], nullptr, nullptr, nullptr, v[2]));
+  }
+  for (size_t i = 0; i < VECTOR_COUNT(test_mac_mfgsvcdata); ++i) {
+    const char** v = test_mac_mfgsvcdata[i];
+    adverts.push_back(makeAdvert(v[0], test_mac_mfgsvcdata_id_num[i], v[1], nullptr, nullptr, v[3], v[2]));
+  }
+  return adverts;
+}
+
+/*
+ * @brief Decodes object with decodeBLEJson. With DECODER_NO_HEAP the decoder
+ * has no document of its own and parses the device definitions into devices.
+ */
+static inline int decodeObject(TheengsDecoder& decoder, JsonDocument& devices, JsonObject& object) {
+#ifdef DECODER_NO_HEAP
+  return decoder.decodeBLEJson(devices, object);
+#else
+  (void)devices;
+  return decoder.decodeBLEJson(object);
+#endif
+}
+
+// Fills doc with the radio fields of advert
+static inline JsonObject advertObject(JsonDocument& doc, const Advert& advert) {
+  doc.clear();
+  if (advert.id != nullptr) doc["id"] = advert.id;
+  if (advert.name != nullptr) doc["name"] = advert.name;
+  if (advert.servicedatauuid != nullptr) doc["servicedatauuid"] = advert.servicedatauuid;
+  if (advert.servicedata != nullptr) doc["servicedata"] = advert.servicedata;
+  if (advert.manufacturerdata != nullptr) doc["manufacturerdata"] = advert.manufacturerdata;
+  return doc.as<JsonObject>();
+}
+
+/*
+ * @brief Decodes advert like an application filling a document from the radio
+ * fields and calling decodeBLEJson.
+ */
+static inline int decodeAdvert(TheengsDecoder& decoder, JsonDocument& devices, JsonDocument& doc, const Advert& advert) {
+  JsonObject object = advertObject(doc, advert);
+  return decodeObject(decoder, devices, object);
+}
+
+#ifndef DECODER_NO_HEAP
+static inline int decodeAdvert(TheengsDecoder& decoder, JsonDocument& doc, const Advert& advert) {
+  JsonObject object = advertObject(doc, advert);
+  return decoder.decodeBLEJson(object);
+}
+#endif
+
+#endif
@@ -60,6 +60,7 @@ int main() {
   StaticJsonDocument<2048> doc;
   JsonObject bleObject;
   TheengsDecoder decoder;
+  DynamicJsonDocument devices(decoder.getDocMax());
   int decode_res = -1;
 
   for (unsigned int i = 0; i < sizeof(test_servicedata) / sizeof(test_servicedata[0]); ++i) {
@@ -68,7 +69,7 @@ int main() {
     doc["servicedata"] = test_servicedata[i][1];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decoder.decodeBLEJson(devices, bleObject);
     if (strcmp(test_servicedata[i][0], "SHOULD FAIL") == 0 &&
         decode_res != TheengsDecoder::BLE_ID_NUM::UNKNOWN_MODEL) {
       std::cout << "Decode result returned model ID: " << bleObject["model_id"] << " UNKNOWN_MODEL expected "
@@ -97,7 +98,7 @@ int main() {
     doc["manufacturerdata"] = test_mfgdata[i][2];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decoder.decodeBLEJson(devices, bleObject);
     if (strcmp(test_mfgdata[i][0], "SHOULD FAIL") == 0 &&
         decode_res != TheengsDecoder::BLE_ID_NUM::UNKNOWN_MODEL) {
       std::cout << "Decode result returned model ID: " << bleObject["model_id"] << " UNKNOWN_MODEL expected "
@@ -128,7 +129,7 @@ int main() {
     doc["servicedatauuid"] = test_uuid[i][1];
     bleObject = doc.as<JsonObject>();
 
-    decode_res = decoder.decodeBLEJson(bleObject);
+    decode_res = decoder.decodeBLEJson(devices, bleObject);
     if (strcmp(test_uuid[i][0], "SHOULD FAIL") == 0 &&
         decode_res != TheengsDecoder::BLE_ID_NUM::UNKNOWN_MODEL) {
       std::cout << "Decode result returned model ID: " << bleObject["model_id"] << " UNKNOWN_MODEL expected "
@@ -161,11 +162,32 @@ int main() {
     return 1;
   }
 
+  if (decoder.getTheengModel("SHOULD_FAIL") != -1 || !decoder.getTheengAttribute("SHOULD_FAIL", "brand").empty()) {
+    std::cout << "FAILED! Should fail getTheengModel returned a model" << std::endl;
+    return 1;
+  }
+
+  // the model index agrees with the attributes of every model
+  for (int i = 0; i < TheengsDecoder::BLE_ID_NUM::BLE_ID_MAX; ++i) {
+    TheengsDecoder::ModelInfo info;
+    if (!decoder.getModelInfo(i, info) || info.model_id.size == 0) {
+      std::cout << "FAILED! No model info for model " << i << std::endl;
+      return 1;
+    }
+    std::string model_id(info.model_id.data, info.model_id.size);
+    int mod_index = decoder.getTheengModel(model_id.c_str());
+    if (mod_index < 0 || mod_index > i || decoder.getTheengAttribute(mod_index, "model_id") != model_id ||
+        decoder.getTheengAttribute(i, "brand") != std::string(info.brand.data, info.brand.size)) {
+      std::cout << "FAILED! Model " << i << " " << model_id << " found at " << mod_index << std::endl;
+      return 1;
+    }
+  }
+
   doc.clear();
   std::cout << "trying garbage inputs" << std::endl;
   doc["garbage"] = "input";
   bleObject = doc.as<JsonObject>();
-  decode_res = decoder.decodeBLEJson(bleObject);
+  decode_res = decoder.decodeBLEJson(devices, bleObject);
   if (decode_res >= 0) {
     std::cout << "FAILED! garbage input returned " << decode_res << std::endl;
     return 1;
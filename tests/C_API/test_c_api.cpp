@@ -0,0 +1,230 @@
+#include <iostream>
+#include <string.h>
+#include <vector>
+
+#include "decoder.h"
+#include "shared/theengs.h"
+
+// advertisement JSON test input [test name] [json] [expected model_id, nullptr if not decoded]
+const char* test_json[][3] = {
+    {"ClearGrass clock", "{\"id\":\"AA:BB:CC:DD:EE:FF\",\"servicedata\":\"70205b04756ab883c8593f090410020001\",\"servicedatauuid\":\"fe95\"}", "LYWSD02"},
+    {"Inkbird TH1", "{\"name\":\"sps\",\"manufacturerdata\":\"660a03150110805908\",\"rssi\":-67}", "IBS-TH1/TH2/P01B/ITH-12S"},
+    {"Unknown", "{\"id\":\"AA:BB:CC:DD:EE:FF\",\"servicedata\":\"123456789abcdef\",\"servicedatauuid\":\"fa11\"}", nullptr},
+};
+
+const uint8_t test_raw_svcdata[] = {0x70, 0x20, 0x5b, 0x04, 0x75, 0x6a, 0xb8, 0x83, 0xc8, 0x59, 0x3f,
+                                    0x09, 0x04, 0x10, 0x02, 0x00, 0x01};
+
+static bool checkOutput(const char* name, const char* out, const char* model_id) {
+  StaticJsonDocument<2048> doc;
+  if (deserializeJson(doc, out) || !doc["model_id"].is<const char*>() ||
+      strcmp(doc["model_id"].as<const char*>(), model_id) != 0) {
+    std::cout << "FAILED! " << name << " returned: " << out << ", " << model_id << " expected" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  void* decoder = Theengs_NewDecoder();
+  char out[1024];
+  size_t out_len = 0;
+
+  for (unsigned int i = 0; i < sizeof(test_json) / sizeof(test_json[0]); ++i) {
+    std::cout << "trying " << test_json[i][0] << " : " << test_json[i][1] << std::endl;
+    Theengs_Status status = Theengs_DecodeBLEInto(decoder, test_json[i][1], out, sizeof(out), &out_len);
+    if (test_json[i][2] == nullptr) {
+      if (status != THEENGS_NO_MATCH) {
+        std::cout << "FAILED! " << test_json[i][0] << " status " << static_cast<int>(status) << ", no match expected" << std::endl;
+        return 1;
+      }
+      continue;
+    }
+    if (status != THEENGS_OK || out_len != strlen(out) || !checkOutput(test_json[i][0], out, test_json[i][2])) {
+      return 1;
+    }
+
+    // the same decode into a buffer short by the null terminator
+    size_t needed = 0;
+    if (Theengs_DecodeBLEInto(decoder, test_json[i][1], out, out_len, &needed) != THEENGS_BUFFER_TOO_SMALL ||
+        needed != out_len) {
+      std::cout << "FAILED! " << test_json[i][0] << " length " << needed << ", " << out_len << " expected" << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "trying invalid input" << std::endl;
+  out_len = 1;
+  if (Theengs_DecodeBLEInto(decoder, "[1,2]", out, sizeof(out), &out_len) != THEENGS_INVALID_INPUT || out_len != 0) {
+    std::cout << "FAILED! invalid input expected, with no output" << std::endl;
+    return 1;
+  }
+  out_len = 1;
+  if (Theengs_DecodeBLEInto(decoder, test_json[2][1], out, sizeof(out), &out_len) != THEENGS_NO_MATCH || out_len != 0) {
+    std::cout << "FAILED! no output expected for an advertisement not decoded" << std::endl;
+    return 1;
+  }
+
+  // several service data entries, decoded into the document the handle keeps, grown for the longer input
+  std::cout << "trying service data entries" << std::endl;
+  const char* entries[] = {
+      "{\"servicedata\":[{\"servicedatauuid\":\"fe95\",\"servicedata\":\"70205b04756ab883c8593f090410020001\"}]}",
+      "{\"id\":\"AA:BB:CC:DD:EE:FF\",\"servicedata\":[{\"servicedatauuid\":\"fa11\",\"servicedata\":\"123456789abcdef\"},"
+      "{\"servicedatauuid\":\"fe95\",\"servicedata\":\"70205b04756ab883c8593f090410020001\"}]}",
+  };
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const char* input : entries) {
+      if (Theengs_DecodeBLEInto(decoder, input, out, sizeof(out), &out_len) != THEENGS_OK || out_len != strlen(out) ||
+          strstr(out, "\"model_id\":\"LYWSD02\"") == nullptr) {
+        std::cout << "FAILED! entries " << input << " returned: " << out << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // decoded keys the input already has are replaced, as decodeBLEJson does, not written twice
+  std::cout << "trying decoded keys in the input" << std::endl;
+  const char* decoded_keys =
+      "{\"brand\":\"unknown\",\"id\":\"AA:BB:CC:DD:EE:FF\",\"servicedata\":\"70205b04756ab883c8593f090410020001\","
+      "\"servicedatauuid\":\"fe95\",\"model_id\":\"none\",\"rssi\":-70}";
+  StaticJsonDocument<2048> merged;
+  if (Theengs_DecodeBLEInto(decoder, decoded_keys, out, sizeof(out), &out_len) != THEENGS_OK || out_len != strlen(out) ||
+      !checkOutput("decoded keys", out, "LYWSD02") || strstr(strstr(out, "\"brand\"") + 1, "\"brand\"") != nullptr ||
+      strstr(strstr(out, "\"model_id\"") + 1, "\"model_id\"") != nullptr || deserializeJson(merged, out) ||
+      merged["rssi"] != -70 || strncmp(out, "{\"brand\":\"Xiaomi/Mijia\",", 24) != 0) {
+    std::cout << "FAILED! decoded keys returned: " << out << std::endl;
+    return 1;
+  }
+  const char* decoded_text = Theengs_DecodeBLE(decoder, decoded_keys);
+  if (decoded_text == nullptr || strcmp(decoded_text, out) != 0) {
+    std::cout << "FAILED! decoded keys returned: " << (decoded_text != nullptr ? decoded_text : "nullptr") << std::endl;
+    return 1;
+  }
+  Theengs_FreeString(decoded_text);
+
+  std::cout << "trying batch" << std::endl;
+  std::string inputs;
+  size_t input_lens[sizeof(test_json) / sizeof(test_json[0])];
+  Theengs_Result results[sizeof(test_json) / sizeof(test_json[0])];
+  for (unsigned int i = 0; i < sizeof(test_json) / sizeof(test_json[0]); ++i) {
+    inputs += test_json[i][1];
+    input_lens[i] = strlen(test_json[i][1]);
+  }
+  size_t used = 0;
+  if (Theengs_DecodeBLEBatch(decoder, inputs.data(), input_lens, 3, out, sizeof(out), results, &used) != THEENGS_OK) {
+    std::cout << "FAILED! batch status" << std::endl;
+    return 1;
+  }
+  for (unsigned int i = 0; i < sizeof(test_json) / sizeof(test_json[0]); ++i) {
+    if (test_json[i][2] == nullptr) {
+      if (results[i].status != THEENGS_NO_MATCH || results[i].model != -1) {
+        std::cout << "FAILED! batch " << test_json[i][0] << " no match expected" << std::endl;
+        return 1;
+      }
+    } else if (results[i].status != THEENGS_OK || results[i].offset + results[i].length >= used ||
+               !checkOutput(test_json[i][0], out + results[i].offset, test_json[i][2])) {
+      return 1;
+    }
+  }
+
+  // an arena only holding the first output
+  if (Theengs_DecodeBLEBatch(decoder, inputs.data(), input_lens, 3, out, results[0].length + 1, results, &used) != THEENGS_BUFFER_TOO_SMALL ||
+      results[0].status != THEENGS_OK || results[1].status != THEENGS_BUFFER_TOO_SMALL || used != results[0].length + 1) {
+    std::cout << "FAILED! batch arena too small" << std::endl;
+    return 1;
+  }
+
+  std::cout << "trying raw advertisement" << std::endl;
+  Theengs_Advert advert;
+  memset(&advert, 0, sizeof(advert));
+  advert.id = "AA:BB:CC:DD:EE:FF";
+  advert.servicedatauuid = "fe95";
+  advert.servicedata = test_raw_svcdata;
+  advert.servicedata_len = sizeof(test_raw_svcdata);
+  if (Theengs_DecodeBLERawInto(decoder, &advert, out, sizeof(out), &out_len) != THEENGS_OK ||
+      !checkOutput("raw ClearGrass clock", out, "LYWSD02")) {
+    return 1;
+  }
+  if (Theengs_DecodeBLERawBatch(decoder, &advert, 1, out, sizeof(out), results, &used) != THEENGS_OK ||
+      results[0].model != TheengsDecoder::BLE_ID_NUM::LYWSD02) {
+    std::cout << "FAILED! raw batch" << std::endl;
+    return 1;
+  }
+
+  const char* decoded = Theengs_DecodeBLE(decoder, test_json[2][1]);
+  if (decoded != nullptr) {
+    std::cout << "FAILED! nullptr expected for an advertisement not decoded" << std::endl;
+    return 1;
+  }
+  decoded = Theengs_DecodeBLE(decoder, test_json[0][1]);
+  if (decoded == nullptr || !checkOutput("string ClearGrass clock", decoded, "LYWSD02")) {
+    return 1;
+  }
+  Theengs_FreeString(decoded);
+
+  std::cout << "trying catalog" << std::endl;
+  size_t count = 0;
+  TheengsDecoder lib_decoder;
+  const Theengs_Model* models = Theengs_GetCatalog(decoder, &count);
+  if (models == nullptr || count != TheengsDecoder::BLE_ID_NUM::BLE_ID_MAX) {
+    std::cout << "FAILED! catalog of " << count << " models" << std::endl;
+    return 1;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    StaticJsonDocument<2048> props;
+    std::string expected = lib_decoder.getTheengProperties(models[i].model_id);
+    if (models[i].index != static_cast<int32_t>(i) || deserializeJson(props, expected) ||
+        props["properties"].as<JsonObject>().size() != models[i].property_count) {
+      std::cout << "FAILED! catalog model " << i << " " << models[i].model_id << std::endl;
+      return 1;
+    }
+    for (size_t p = 0; p < models[i].property_count; ++p) {
+      const Theengs_Property& prop = models[i].properties[p];
+      if (!props["properties"][prop.key].is<JsonObject>() ||
+          strcmp(props["properties"][prop.key]["name"].as<const char*>(), prop.name) != 0) {
+        std::cout << "FAILED! catalog model " << models[i].model_id << " property " << prop.key << std::endl;
+        return 1;
+      }
+    }
+  }
+  const Theengs_Model& lywsd02 = models[TheengsDecoder::BLE_ID_NUM::LYWSD02];
+  size_t again = 0;
+  if (strcmp(lywsd02.model_id, "LYWSD02") != 0 || lywsd02.type == nullptr || strcmp(lywsd02.type, "THB") != 0 ||
+      Theengs_GetCatalog(decoder, &again) != models || again != count) {
+    std::cout << "FAILED! catalog LYWSD02 " << lywsd02.model_id << std::endl;
+    return 1;
+  }
+
+  std::cout << "trying stats" << std::endl;
+  Theengs_GetStats(nullptr, nullptr, 0, 1);
+  Theengs_DecodeBLEInto(decoder, test_json[0][1], out, sizeof(out), &out_len);
+  Theengs_DecodeBLEInto(decoder, test_json[2][1], out, sizeof(out), &out_len);
+  Theengs_DecodeBLEInto(decoder, "{\"name\":\"unknown\",\"manufacturerdata\":\"ff\"}", out, sizeof(out), &out_len);
+  Theengs_DecodeBLEInto(decoder, "{\"rssi\":-70}", out, sizeof(out), &out_len);
+  Theengs_Stats stats;
+  std::vector<uint64_t> model_matches(count);
+  uint64_t latency = 0;
+  if (Theengs_GetStats(&stats, model_matches.data(), model_matches.size(), 1) != count) {
+    std::cout << "FAILED! stats model count" << std::endl;
+    return 1;
+  }
+  for (int i = 0; i < THEENGS_LATENCY_BUCKETS; ++i) {
+    latency += stats.latency[i];
+  }
+  if (stats.adverts != 4 || stats.matches != 1 || stats.rejects != 3 || latency != 4 || stats.latency_sum_us == 0 ||
+      model_matches[TheengsDecoder::BLE_ID_NUM::LYWSD02] != 1 ||
+      stats.reject_reasons[THEENGS_REJECT_NO_DATA] != 1 || stats.reject_reasons[THEENGS_REJECT_TOO_SHORT] != 1) {
+    std::cout << "FAILED! stats " << stats.adverts << " adverts, " << stats.matches << " matches, "
+              << stats.rejects << " rejects" << std::endl;
+    return 1;
+  }
+  Theengs_GetStats(&stats, nullptr, 0, 0);
+  if (stats.adverts != 0) {
+    std::cout << "FAILED! stats not reset" << std::endl;
+    return 1;
+  }
+
+  Theengs_DestroyDecoder(decoder);
+  std::cout << "C API tests passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,119 @@
+// Fixed-point decoding: the inputs of test_ble decoded in fixed point give the
+// same properties as decoded in double. The values read from the decoded
+// object with readNumber equal the double ones to their precision, and the
+// serialized documents are the same text, but for the ties the exact value
+// rounds away from zero.
+
+#include <math.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "test_ble_adverts.h"
+
+static bool sameValue(JsonVariant a, JsonVariant b) {
+  if (a.is<const char*>() || b.is<const char*>()) {
+    return a.is<const char*>() && b.is<const char*>() && strcmp(a.as<const char*>(), b.as<const char*>()) == 0;
+  }
+  if (a.is<bool>() || b.is<bool>()) {
+    return a.is<bool>() && b.is<bool>() && a.as<bool>() == b.as<bool>();
+  }
+  double x, y;
+  if (!TheengsDecoder::readNumber(a, &x) || !TheengsDecoder::readNumber(b, &y)) {
+    return false;
+  }
+  return fabs(x - y) <= 1e-9 * fmax(1, fabs(x));
+}
+
+/*
+ * Whether the texts of two numbers differ by one in their last decimal, the
+ * exact fixed-point value of a tie being rounded away from zero while the
+ * double nearest to it may fall on either side.
+ */
+static bool lastDigitApart(const std::string& a, const std::string& b) {
+  size_t decimals = 0;
+  for (const std::string* text : {&a, &b}) {
+    size_t dot = text->find('.');
+    if (dot != std::string::npos && text->size() - dot - 1 > decimals) {
+      decimals = text->size() - dot - 1;
+    }
+  }
+  return decimals > 0 && fabs(strtod(a.c_str(), nullptr) - strtod(b.c_str(), nullptr)) <= 1.001 * pow(10, -static_cast<double>(decimals));
+}
+
+int main() {
+  std::vector<Advert> adverts = testVectors();
+
+  TheengsDecoder decoder;
+  TheengsDecoder fixed_decoder;
+  decoder.setFixedPoint(false); // on by default with DECODER_FIXED_POINT
+  fixed_decoder.setFixedPoint(true);
+  if (decoder.getFixedPoint() || !fixed_decoder.getFixedPoint()) {
+    std::cout << "FAILED! the fixed-point mode is not set" << std::endl;
+    return 1;
+  }
+
+  DynamicJsonDocument devices(decoder.getDocMax());
+  StaticJsonDocument<4096> doc;
+  StaticJsonDocument<4096> fixed_doc;
+  bool passed = true;
+  int decimals = 0; // the values with decimals decoded in fixed point, added as raw numbers
+  int doubles = 0; // those added as a double, out of the fixed-point range or of float data
+  int ties = 0; // the values printed one apart in their last decimal, at a tie
+
+  for (const Advert& advert : adverts) {
+    int res = decodeAdvert(decoder, devices, doc, advert);
+    int fixed_res = decodeAdvert(fixed_decoder, devices, fixed_doc, advert);
+    if (res != fixed_res) {
+      std::cout << "FAILED! " << advert.test << " decoded to " << fixed_res << " in fixed point, " << res
+                << " in double" << std::endl;
+      passed = false;
+      continue;
+    }
+    JsonObject values = doc.as<JsonObject>();
+    JsonObject fixed_values = fixed_doc.as<JsonObject>();
+    if (values.size() != fixed_values.size()) {
+      std::cout << "FAILED! " << advert.test << " decoded to " << fixed_values.size() << " properties in fixed point, "
+                << values.size() << " in double" << std::endl;
+      passed = false;
+    }
+    int advert_ties = 0;
+    for (JsonPair kv : values) {
+      JsonVariant fixed_value = fixed_values[kv.key().c_str()];
+      std::string value, fixed_text;
+      serializeJson(kv.value(), value);
+      serializeJson(fixed_value, fixed_text);
+      if (!sameValue(kv.value(), fixed_value) || (value != fixed_text && !lastDigitApart(value, fixed_text))) {
+        std::cout << "FAILED! " << advert.test << " decoded " << kv.key().c_str() << " to " << fixed_text
+                  << " in fixed point, " << value << " in double" << std::endl;
+        passed = false;
+      } else if (!fixed_value.is<long long>() && !fixed_value.is<bool>()) {
+        advert_ties += value != fixed_text;
+        decimals += !fixed_value.is<const char*>() && !fixed_value.is<double>(); // a raw number
+        doubles += fixed_value.is<double>();
+      }
+    }
+    std::string text, fixed_text;
+    serializeJson(doc, text);
+    serializeJson(fixed_doc, fixed_text);
+    ties += advert_ties;
+    if (text != fixed_text && advert_ties == 0) {
+      std::cout << "FAILED! " << advert.test << " serialized to " << fixed_text << " in fixed point, " << text
+                << " in double" << std::endl;
+      passed = false;
+    }
+  }
+
+  if (decimals == 0) {
+    std::cout << "FAILED! no value with decimals decoded" << std::endl;
+    passed = false;
+  }
+  if (!passed) {
+    return 1;
+  }
+  std::cout << adverts.size() << " advertisements decoded in fixed point, " << decimals << " values with decimals, "
+            << doubles << " in double, " << ties << " printed one apart at a tie" << std::endl;
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <string.h>
+#include <string>
+
+#include "decoder.h"
+#include "metrics_exporter.h"
+
+#ifdef METRICS_HTTP_LISTENER
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+// OpenMetrics lines expected after decoding the adverts below
+const char* expected_lines[] = {
+    "# TYPE theengs_decoder_adverts counter\n",
+    "theengs_decoder_adverts_total 3\n",
+    "theengs_decoder_matches_total 1\n",
+    "theengs_decoder_rejects_total{reason=\"no_data\"} 1\n",
+    "theengs_decoder_truncated_total 0\n",
+    "theengs_decoder_model_matches_total{model_id=\"LYWSD02\",index=\"1\"} 1\n",
+    "# TYPE theengs_decoder_decode_latency_seconds histogram\n",
+    "theengs_decoder_decode_latency_seconds_bucket{le=\"5.12e-07\"} ",
+    "theengs_decoder_decode_latency_seconds_bucket{le=\"+Inf\"} 3\n",
+    "theengs_decoder_decode_latency_seconds_count 3\n",
+    "theengs_decoder_decode_latency_seconds_sum 0.",
+};
+
+static bool checkMetrics(const std::string& name, const std::string& text) {
+  for (const char* line : expected_lines) {
+    if (text.find(line) == std::string::npos) {
+      std::cout << "FAILED! " << name << " misses " << line << text << std::endl;
+      return false;
+    }
+  }
+  if (text.size() < 6 || text.compare(text.size() - 6, 6, "# EOF\n") != 0) {
+    std::cout << "FAILED! " << name << " does not end with # EOF" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+#ifdef METRICS_HTTP_LISTENER
+// Sends request to the listener on port and returns the whole response
+static std::string fetch(uint16_t port, const std::string& request) {
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  std::string response;
+  if (client >= 0 && connect(client, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 &&
+      send(client, request.data(), request.size(), 0) == static_cast<ssize_t>(request.size())) {
+    char buf[1024];
+    ssize_t n;
+    while ((n = recv(client, buf, sizeof(buf), 0)) > 0) {
+      response.append(buf, n);
+    }
+  }
+  if (client >= 0) {
+    close(client);
+  }
+  return response;
+}
+#endif
+
+int main() {
+  TheengsDecoder decoder;
+  TheengsDecoder::resetStats();
+  DynamicJsonDocument devices(decoder.getDocMax());
+  StaticJsonDocument<1024> doc;
+  JsonObject decoded = doc.to<JsonObject>();
+  decoder.decodeBLE(devices, decoded, "70205b04756ab883c8593f090410020001", nullptr, nullptr, "fe95", "AA:BB:CC:DD:EE:FF");
+  decoder.decodeBLE(devices, decoded, "123456789abcdef0123456", nullptr, nullptr, "fa11", nullptr);
+  decoder.decodeBLE(devices, decoded, nullptr, nullptr, nullptr, nullptr, "AA:BB:CC:DD:EE:FF");
+
+  std::cout << "trying OpenMetrics text" << std::endl;
+  TheengsDecoder::Stats stats;
+  TheengsDecoder::getStats(stats);
+  if (stats.latency_sum_us == 0) {
+    std::cout << "FAILED! no decode time counted" << std::endl;
+    return 1;
+  }
+  std::string text;
+  writeOpenMetrics(stats, text);
+  if (!checkMetrics("text", text)) {
+    return 1;
+  }
+
+#ifdef METRICS_HTTP_LISTENER
+  std::cout << "trying HTTP listener" << std::endl;
+  MetricsListener listener;
+  if (!listener.start(0) || listener.port() == 0) {
+    std::cout << "FAILED! listener not started" << std::endl;
+    return 1;
+  }
+  std::string response = fetch(listener.port(), "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  size_t body = response.find("\r\n\r\n");
+  if (response.compare(0, 15, "HTTP/1.1 200 OK") != 0 ||
+      response.find("Content-Type: " OPENMETRICS_CONTENT_TYPE "\r\n") == std::string::npos ||
+      body == std::string::npos || !checkMetrics("response", response.substr(body + 4))) {
+    std::cout << "FAILED! response " << response << std::endl;
+    return 1;
+  }
+  response = fetch(listener.port(), "GET /other HTTP/1.1\r\n\r\n");
+  if (response.compare(0, 22, "HTTP/1.1 404 Not Found") != 0) {
+    std::cout << "FAILED! 404 expected, got " << response << std::endl;
+    return 1;
+  }
+  listener.stop();
+  if (listener.port() != 0 || !listener.start(0)) {
+    std::cout << "FAILED! listener not restarted" << std::endl;
+    return 1;
+  }
+#endif
+
+  std::cout << "metrics tests passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,196 @@
+// Decoding without a heap: the decoder built with DECODER_NO_HEAP decodes the
+// inputs of test_ble with malloc poisoned, the global operator new and the
+// malloc family aborting the test on any call made while decoding, and gets
+// the attributes and properties of every model into buffers the same way.
+// The definitions are parsed into a document of the test, allocated before,
+// and every one must fit the size computed from the catalog.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "test_ble_adverts.h"
+
+#ifdef __GLIBC__
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+
+static bool poisoned = false;
+static const char* decoding = ""; // the test decoded while poisoned
+
+// Reports the allocation without allocating and aborts
+static void poison(const char* call) {
+  if (!poisoned) {
+    return;
+  }
+  poisoned = false;
+  const char* parts[] = {"FAILED! ", call, " called while decoding ", decoding, "\n"};
+  for (const char* part : parts) {
+    if (write(STDERR_FILENO, part, strlen(part)) < 0) {
+      break;
+    }
+  }
+  abort();
+}
+
+extern "C" void* malloc(size_t size) noexcept {
+  poison("malloc");
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+  poison("calloc");
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) noexcept {
+  poison("realloc");
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) noexcept {
+  __libc_free(ptr);
+}
+
+void* operator new(size_t size) {
+  poison("operator new");
+  void* ptr = __libc_malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+  free(ptr);
+}
+
+// The debug output of the decoder is buffered without a heap too
+static char stdout_buffer[BUFSIZ];
+
+int main() {
+  setvbuf(stdout, stdout_buffer, _IOFBF, sizeof(stdout_buffer));
+
+  std::vector<Advert> adverts = testVectors();
+  // inputs beyond the bounds of the decoder buffers are rejected, not overflowed
+  std::string long_data(600, 'f');
+  adverts.push_back(makeAdvert("long service data", -1, "AA:BB:CC:DD:EE:FF:00:11:22:33:44:55:66", nullptr, "0xfcd2",
+                               long_data.c_str(), nullptr));
+  adverts.push_back(makeAdvert("long manufacturer data", -1, nullptr, long_data.c_str(), nullptr, nullptr,
+                               long_data.c_str()));
+
+  static TheengsDecoder decoder;
+  DynamicJsonDocument devices(decoder.getDocMax());
+  StaticJsonDocument<2048> doc;
+  StaticJsonDocument<2048> decoded;
+  bool passed = true;
+
+  for (const Advert& advert : adverts) {
+    decoding = advert.test;
+    poisoned = true;
+    int res = decodeAdvert(decoder, devices, doc, advert);
+    decoded.clear();
+    JsonObject fields = decoded.to<JsonObject>();
+    int res_fields = decoder.decodeBLE(devices, fields, advert.servicedata, advert.manufacturerdata, advert.name,
+                                       advert.servicedatauuid, advert.id);
+    poisoned = false;
+    if (res != advert.expected || res_fields != advert.expected) {
+      std::cout << "FAILED! " << advert.test << " decoded to " << res << " and " << res_fields << ", "
+                << advert.expected << " expected" << std::endl;
+      passed = false;
+    }
+  }
+
+  // service data entries, decoded into the input document
+  decoding = "service data entries";
+  doc.clear();
+  JsonArray entries = doc.createNestedArray("servicedata");
+  for (int i = 0; i < 2; ++i) {
+    JsonObject entry = entries.createNestedObject();
+    entry["servicedata"] = test_servicedata[i][1];
+  }
+  JsonObject object = doc.as<JsonObject>();
+  poisoned = true;
+  int res = decoder.decodeBLEJson(devices, object);
+  poisoned = false;
+  if (res != test_svcdata_id_num[0]) {
+    std::cout << "FAILED! service data entries decoded to " << res << ", " << static_cast<int>(test_svcdata_id_num[0])
+              << " expected" << std::endl;
+    passed = false;
+  }
+
+  // the attributes and properties of every model, into buffers, the
+  // condition being read from the definition parsed in full
+  char model_id[32];
+  char condition[1024];
+  static char properties[4096];
+  size_t models = 0;
+  for (int i = 0; i < TheengsDecoder::BLE_ID_MAX; ++i) {
+    decoding = "getters";
+    poisoned = true;
+    size_t id_len = decoder.getTheengAttribute(devices, i, "model_id", model_id, sizeof(model_id));
+    int found = decoder.getTheengModel(model_id);
+    size_t condition_len = decoder.getTheengAttribute(devices, i, "condition", condition, sizeof(condition));
+    size_t properties_len = decoder.getTheengProperties(i, properties, sizeof(properties));
+    poisoned = false;
+    if (id_len == 0 || found < 0 || condition_len < 2 || condition[0] != '[' || properties_len < 2 ||
+        properties[0] != '{') {
+      std::cout << "FAILED! getters of model " << i << " " << model_id << ": " << condition << " " << properties
+                << std::endl;
+      passed = false;
+    }
+    models++;
+  }
+  if (decoder.getTheengAttribute(devices, -1, "model_id", model_id, sizeof(model_id)) != 0 || model_id[0] != '\0' ||
+      decoder.getTheengAttribute(devices, 0, "model_id", model_id, 4) != 3 || strlen(model_id) != 3) {
+    std::cout << "FAILED! getter of an invalid model or a short buffer" << std::endl;
+    passed = false;
+  }
+
+  if (decoder.testDocMax() < 0) {
+    std::cout << "FAILED! a definition needs more than the " << decoder.getDocMax() << " bytes of DECODER_DOC_SIZE"
+              << std::endl;
+    passed = false;
+  }
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout << adverts.size() + 1 << " advertisements decoded and the getters of " << models << " models called"
+            << " without a heap, " << decoder.getDocMax() << " bytes of document" << std::endl;
+  return 0;
+}
+
+#else
+
+int main() {
+  std::cout << "the allocation hooks need glibc, skipped" << std::endl;
+  return 0;
+}
+
+#endif
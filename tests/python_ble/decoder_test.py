@@ -1,9 +1,15 @@
 from TheengsDecoder import decodeBLE as dble
 from TheengsDecoder import getProperties
 from TheengsDecoder import getAttribute
+from TheengsDecoder import Decoder
+from TheengsDecoder import decode_many
+from TheengsDecoder import decode_columns
+from TheengsDecoder import getCatalog
+from TheengsDecoder import getStats
 import json
+import math
 
-x = {"servicedata":"712098004a63b6658d7cc40d071003f32600"}
+x = {"servicedata":"712098004a63b6658d7cc40d071003f32600","servicedatauuid":"fe95"}
 z = dble(json.dumps(x))
 print(z, "\n")
 
@@ -13,7 +19,58 @@ brand = getAttribute(p['model_id'], 'brand')
 model = getAttribute(p['model_id'], 'model')
 print("brand:", brand, ", model:", model)
 
+# a decoded key of the input is replaced, not written twice
+r = dble(json.dumps(dict(x, brand="unknown", rssi=-70)))
+print(r, "\n")
+assert r.count('"brand"') == 1 and json.loads(r)["brand"] == p["brand"] and json.loads(r)["rssi"] == -70
+
 y = {}
 z = dble(json.dumps(y))
 print("decoder result (None expected): ", z)
+
+decoder = Decoder()
+d = decoder.decodeBLE({"servicedata": bytes.fromhex("712098004a63b6658d7cc40d071003f32600"), "servicedatauuid": "fe95"})
+print(d, "\n")
+print(decoder.getProperties(d['model_id']), "\n")
+print("brand:", decoder.getAttribute(d['model_id'], 'brand'))
+print("decoder result (None expected): ", decoder.decodeBLE({}))
+
+batch = decode_many([x, {}, x], threads=2)
+print("batch results:", batch)
+assert batch[0] == decoder.decodeBLE(x) and batch[1] is None
+
+columns = decode_columns(["lux", "tempc"], threads=2,
+                         servicedata=[x["servicedata"], None, bytes.fromhex(x["servicedata"])],
+                         servicedatauuid=["fe95", None, "fe95"])
+print("columns:", columns)
+assert columns["model"][0] >= 0 and columns["model"][1] == -1 and columns["model"][2] == columns["model"][0]
+assert columns["lux"][0] == 9971 and math.isnan(columns["lux"][1]) and columns["lux"][2] == 9971
+assert all(math.isnan(value) for value in columns["tempc"])
+for properties in (["lux", "lux"], ["model"]):
+    try:
+        decode_columns(properties, servicedata=[x["servicedata"]])
+        assert False, properties
+    except ValueError as err:
+        print("ValueError:", err)
+catalog = getCatalog()
+print("catalog:", len(catalog), "models")
+assert len(catalog) >= 116 and [model["index"] for model in catalog] == list(range(len(catalog)))
+assert all(getAttribute(model["model_id"], "brand") == model["brand"] for model in catalog if model["model_id"])
+lywsd02 = next(model for model in catalog if model["model_id"] == "LYWSD02")
+assert lywsd02["model_id"] == "LYWSD02" and lywsd02["brand"] == "Xiaomi/Mijia" and lywsd02["type"] == "THB"
+assert lywsd02["properties"]["tempc"] == {"unit": "°C", "name": "temperature"}
+assert sorted(lywsd02["properties"]) == ["batt", "hum", "mac", "tempc"]
+
+getStats(reset=True)
+stats = getStats()
+assert stats["adverts"] == 0 and stats["matches"] == 0 and stats["models"] == {} and stats["latency_sum_us"] == 0
+index = next(model["index"] for model in catalog if model["model_id"] == p["model_id"])
+dble(json.dumps(x))
+dble(json.dumps({"manufacturerdata": "ffff"}))
+stats = getStats(reset=True)
+print("stats:", stats)
+assert stats["adverts"] == 2 and stats["matches"] == 1 and stats["rejects"] == 1
+assert stats["models"] == {index: 1} and stats["reject_reasons"]["too_short"] == 1
+assert sum(stats["latency"]) == 2 and stats["latency_sum_us"] > 0
+assert getStats()["adverts"] == 0
 print("Done")
\ No newline at end of file